@@ -0,0 +1,446 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Benchmark of mm_imgp() over the format labels, resolutions and rotations.
+ * Every case reports the latency percentiles of one call, the throughput in
+ * megapixels of the source per second, the peak RSS of the process and the implementation mm_imgp_query
+ * reports for it, as CSV or JSON. MM_IMGP_TIER=gstreamer, c, sse2 or avx2 benchmarks the other tiers.
+ *
+ * usage: mm_util_gstcs_bench [--src LABEL] [--dst LABEL] [--size WxH] [--dst-size WxH] [--rotate N] [--filter NAME]
+ *                            [--threads N] [--iterations N] [--warmup N] [--format csv|json] [--output FILE]
+ * --src, --dst, --size and --rotate can be repeated to select a part of the matrix.
+ */
+
+#include <glib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+
+#define BENCH_MAX_FILTERS 32
+#define BENCH_DEFAULT_ITERATIONS 20
+#define BENCH_DEFAULT_WARMUP 2
+#define BENCH_ALIGN(num) (((num) + 15) & ~15)
+
+typedef struct _bench_size_s
+{
+	const char* name;
+	unsigned int width;
+	unsigned int height;
+} bench_size_s;
+
+typedef enum
+{
+	BENCH_FORMAT_CSV = 0,
+	BENCH_FORMAT_JSON,
+} bench_format_e;
+
+typedef struct _bench_options_s
+{
+	const char* src[BENCH_MAX_FILTERS];
+	unsigned int src_count;
+	const char* dst[BENCH_MAX_FILTERS];
+	unsigned int dst_count;
+	bench_size_s size[BENCH_MAX_FILTERS];
+	unsigned int size_count;
+	int rotate[BENCH_MAX_FILTERS];
+	unsigned int rotate_count;
+	unsigned int dst_width; /* 0 for the size of the source */
+	unsigned int dst_height;
+	mm_util_img_resize_filter_e filter;
+	unsigned int threads;
+	unsigned int iterations;
+	unsigned int warmup;
+	bench_format_e format;
+	FILE* out;
+} bench_options_s;
+
+typedef struct _bench_result_s
+{
+	int result;
+	imgp_kernel_info_s kernel; /* implementation which ran the case */
+	double min_us;
+	double mean_us;
+	double p50_us;
+	double p90_us;
+	double p99_us;
+	double max_us;
+	double mpixel_per_s;
+	long peak_rss_kb;
+} bench_result_s;
+
+/* every label accepted by mm_setup_image_size() */
+static const char* _bench_labels[] = {
+	"I420", "Y42B", "YUV422", "Y444", "YV12", "NV12", "RGB565", "RGB888",
+	"BGR888", "UYVY", "YUYV", "ARGB8888", "BGRA8888", "RGBA8888", "ABGR8888", "BGRX",
+};
+
+static const bench_size_s _bench_sizes[] = {
+	{ "QVGA", 320, 240 },
+	{ "VGA", 640, 480 },
+	{ "HD", 1280, 720 },
+	{ "FHD", 1920, 1080 },
+	{ "4K", 3840, 2160 },
+};
+
+static const char* _bench_rotate_names[MM_UTIL_ROTATE_NUM] = {
+	"0", "90", "180", "270", "flip_horz", "flip_vert",
+};
+
+static const char* _bench_filter_names[MM_UTIL_RESIZE_FILTER_NUM] = {
+	"default", "nearest", "bilinear", "bicubic", "lanczos", "area", "thumbnail",
+};
+
+static int
+_bench_compare_double(const void* a, const void* b)
+{
+	double _a = *(const double*) a;
+	double _b = *(const double*) b;
+	return (_a > _b) - (_a < _b);
+}
+
+static double
+_bench_percentile(const double* sorted, unsigned int count, unsigned int percent)
+{
+	/* nearest rank */
+	unsigned int rank = (percent * count + 99) / 100;
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static long
+_bench_peak_rss_kb(void)
+{
+	struct rusage usage;
+
+	if(getrusage(RUSAGE_SELF, &usage) != 0) {
+		return -1;
+	}
+	return usage.ru_maxrss;
+}
+
+static int
+_bench_parse_size(const char* value, bench_size_s* size)
+{
+	unsigned int i = 0;
+
+	for(i = 0; i < G_N_ELEMENTS(_bench_sizes); i++) {
+		if(g_ascii_strcasecmp(value, _bench_sizes[i].name) == 0) {
+			*size = _bench_sizes[i];
+			return 0;
+		}
+	}
+	if(sscanf(value, "%ux%u", &size->width, &size->height) != 2 || size->width == 0 || size->height == 0) {
+		return -1;
+	}
+	size->name = value;
+	return 0;
+}
+
+static int
+_bench_parse_rotate(const char* value)
+{
+	int i = 0;
+
+	for(i = 0; i < MM_UTIL_ROTATE_NUM; i++) {
+		if(strcmp(value, _bench_rotate_names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int
+_bench_parse_filter(const char* value)
+{
+	int i = 0;
+
+	for(i = 0; i < MM_UTIL_RESIZE_FILTER_NUM; i++) {
+		if(strcmp(value, _bench_filter_names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void
+_bench_usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [--src LABEL] [--dst LABEL] [--size QVGA|VGA|HD|FHD|4K|WxH] [--dst-size WxH]\n"
+		"\t[--rotate 0|90|180|270|flip_horz|flip_vert] [--filter default|nearest|bilinear|bicubic|lanczos|area|thumbnail]\n"
+		"\t[--threads N] [--iterations N] [--warmup N]\n"
+		"\t[--format csv|json] [--output FILE]\n", name);
+}
+
+static int
+_bench_parse_options(int argc, char** argv, bench_options_s* options)
+{
+	bench_size_s size;
+	int i = 0;
+
+	memset(options, 0, sizeof(bench_options_s));
+	options->iterations = BENCH_DEFAULT_ITERATIONS;
+	options->warmup = BENCH_DEFAULT_WARMUP;
+	options->out = stdout;
+
+	for(i = 1; i < argc; i++) {
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if(value == NULL) {
+			return -1;
+		}
+		if(strcmp(argv[i], "--src") == 0 && options->src_count < BENCH_MAX_FILTERS) {
+			options->src[options->src_count++] = value;
+		}else if(strcmp(argv[i], "--dst") == 0 && options->dst_count < BENCH_MAX_FILTERS) {
+			options->dst[options->dst_count++] = value;
+		}else if(strcmp(argv[i], "--size") == 0 && options->size_count < BENCH_MAX_FILTERS) {
+			if(_bench_parse_size(value, &options->size[options->size_count]) != 0) {
+				return -1;
+			}
+			options->size_count++;
+		}else if(strcmp(argv[i], "--dst-size") == 0) {
+			if(_bench_parse_size(value, &size) != 0) {
+				return -1;
+			}
+			options->dst_width = size.width;
+			options->dst_height = size.height;
+		}else if(strcmp(argv[i], "--rotate") == 0 && options->rotate_count < BENCH_MAX_FILTERS) {
+			options->rotate[options->rotate_count] = _bench_parse_rotate(value);
+			if(options->rotate[options->rotate_count] < 0) {
+				return -1;
+			}
+			options->rotate_count++;
+		}else if(strcmp(argv[i], "--filter") == 0) {
+			if(_bench_parse_filter(value) < 0) {
+				return -1;
+			}
+			options->filter = _bench_parse_filter(value);
+		}else if(strcmp(argv[i], "--threads") == 0) {
+			options->threads = atoi(value);
+		}else if(strcmp(argv[i], "--iterations") == 0) {
+			options->iterations = atoi(value);
+		}else if(strcmp(argv[i], "--warmup") == 0) {
+			options->warmup = atoi(value);
+		}else if(strcmp(argv[i], "--format") == 0) {
+			if(strcmp(value, "csv") == 0) {
+				options->format = BENCH_FORMAT_CSV;
+			}else if(strcmp(value, "json") == 0) {
+				options->format = BENCH_FORMAT_JSON;
+			}else {
+				return -1;
+			}
+		}else if(strcmp(argv[i], "--output") == 0) {
+			options->out = fopen(value, "w");
+			if(options->out == NULL) {
+				perror(value);
+				return -1;
+			}
+		}else {
+			return -1;
+		}
+		i++;
+	}
+	if(options->iterations == 0) {
+		return -1;
+	}
+
+	/* the whole matrix when nothing is selected */
+	if(options->src_count == 0) {
+		for(i = 0; i < (int) G_N_ELEMENTS(_bench_labels); i++) {
+			options->src[options->src_count++] = _bench_labels[i];
+		}
+	}
+	if(options->dst_count == 0) {
+		for(i = 0; i < (int) G_N_ELEMENTS(_bench_labels); i++) {
+			options->dst[options->dst_count++] = _bench_labels[i];
+		}
+	}
+	if(options->size_count == 0) {
+		for(i = 0; i < (int) G_N_ELEMENTS(_bench_sizes); i++) {
+			options->size[options->size_count++] = _bench_sizes[i];
+		}
+	}
+	if(options->rotate_count == 0) {
+		for(i = 0; i < MM_UTIL_ROTATE_NUM; i++) {
+			options->rotate[options->rotate_count++] = i;
+		}
+	}
+	return 0;
+}
+
+static void
+_bench_fill(unsigned char* buffer, size_t size)
+{
+	size_t i = 0;
+
+	/* a gradient rather than zeroes, so that no kernel takes a shortcut */
+	for(i = 0; i < size; i++) {
+		buffer[i] = (unsigned char) ((i * 7 + (i >> 10)) & 0xff);
+	}
+}
+
+static void
+_bench_run_case(const bench_options_s* options, imgp_info_s* info, bench_result_s* result)
+{
+	double* samples = g_new0(double, options->iterations);
+	double total_us = 0;
+	gint64 start = 0;
+	unsigned int i = 0;
+
+	memset(result, 0, sizeof(bench_result_s));
+	mm_imgp_query(info, &result->kernel);
+	for(i = 0; i < options->warmup; i++) {
+		result->result = mm_imgp(info, IMGP_CSC);
+		if(result->result != MM_ERROR_NONE) {
+			break;
+		}
+	}
+	for(i = 0; i < options->iterations && result->result == MM_ERROR_NONE; i++) {
+		start = g_get_monotonic_time();
+		result->result = mm_imgp(info, IMGP_CSC);
+		samples[i] = (double) (g_get_monotonic_time() - start);
+		total_us += samples[i];
+	}
+
+	if(result->result == MM_ERROR_NONE) {
+		qsort(samples, options->iterations, sizeof(double), _bench_compare_double);
+		result->min_us = samples[0];
+		result->max_us = samples[options->iterations - 1];
+		result->mean_us = total_us / options->iterations;
+		result->p50_us = _bench_percentile(samples, options->iterations, 50);
+		result->p90_us = _bench_percentile(samples, options->iterations, 90);
+		result->p99_us = _bench_percentile(samples, options->iterations, 99);
+		result->mpixel_per_s = total_us > 0 ? (double) info->src_width * info->src_height * options->iterations / total_us : 0;
+	}
+	result->peak_rss_kb = _bench_peak_rss_kb();
+	g_free(samples);
+}
+
+static void
+_bench_print_header(const bench_options_s* options)
+{
+	if(options->format == BENCH_FORMAT_CSV) {
+		fprintf(options->out, "src,dst,width,height,dst_width,dst_height,rotate,filter,threads,iterations,result,kernel,isa,"
+			"min_us,mean_us,p50_us,p90_us,p99_us,max_us,mpixel_per_s,peak_rss_kb\n");
+	}else {
+		fprintf(options->out, "[\n");
+	}
+}
+
+static void
+_bench_print_result(const bench_options_s* options, const imgp_info_s* info, const bench_result_s* result, gboolean first)
+{
+	if(options->format == BENCH_FORMAT_CSV) {
+		fprintf(options->out, "%s,%s,%u,%u,%u,%u,%s,%s,%u,%u,%d,%s,%s,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%ld\n",
+			info->input_format_label, info->output_format_label, info->src_width, info->src_height, info->dst_width, info->dst_height,
+			_bench_rotate_names[info->angle], _bench_filter_names[info->resize_filter], options->threads, options->iterations, result->result,
+			result->kernel.kernel, result->kernel.isa,
+			result->min_us, result->mean_us, result->p50_us, result->p90_us, result->p99_us, result->max_us,
+			result->mpixel_per_s, result->peak_rss_kb);
+	}else {
+		fprintf(options->out, "%s  {\"src\": \"%s\", \"dst\": \"%s\", \"width\": %u, \"height\": %u, \"dst_width\": %u, \"dst_height\": %u, "
+			"\"rotate\": \"%s\", \"filter\": \"%s\", \"threads\": %u, \"iterations\": %u, \"result\": %d, \"kernel\": \"%s\", \"isa\": \"%s\", "
+			"\"min_us\": %.1f, \"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f, "
+			"\"mpixel_per_s\": %.2f, \"peak_rss_kb\": %ld}",
+			first ? "" : ",\n", info->input_format_label, info->output_format_label, info->src_width, info->src_height, info->dst_width, info->dst_height,
+			_bench_rotate_names[info->angle], _bench_filter_names[info->resize_filter], options->threads, options->iterations, result->result,
+			result->kernel.kernel, result->kernel.isa,
+			result->min_us, result->mean_us, result->p50_us, result->p90_us, result->p99_us, result->max_us,
+			result->mpixel_per_s, result->peak_rss_kb);
+	}
+	fflush(options->out);
+}
+
+int
+main(int argc, char** argv)
+{
+	bench_options_s options;
+	bench_result_s result;
+	imgp_info_s info;
+	unsigned char* src = NULL;
+	unsigned char* dst = NULL;
+	size_t src_size = 0;
+	size_t dst_size = 0;
+	unsigned int s = 0, d = 0, z = 0, r = 0;
+	unsigned int dst_width = 0, dst_height = 0;
+	unsigned int failed = 0;
+	gboolean first = TRUE;
+
+	if(_bench_parse_options(argc, argv, &options) != 0) {
+		_bench_usage(argv[0]);
+		return 1;
+	}
+
+	_bench_print_header(&options);
+	for(z = 0; z < options.size_count; z++) {
+		dst_width = options.dst_width ? options.dst_width : options.size[z].width;
+		dst_height = options.dst_height ? options.dst_height : options.size[z].height;
+
+		/* room for 4 bytes per pixel with the padding of every format */
+		src_size = (size_t) BENCH_ALIGN(options.size[z].width) * BENCH_ALIGN(options.size[z].height) * 4;
+		dst_size = (size_t) BENCH_ALIGN(MAX(dst_width, dst_height)) * BENCH_ALIGN(MAX(dst_width, dst_height)) * 4;
+		src = g_malloc(src_size);
+		dst = g_malloc(dst_size);
+		_bench_fill(src, src_size);
+		memset(dst, 0, dst_size); /* fault the pages in before the first measure */
+
+		for(s = 0; s < options.src_count; s++) {
+			for(d = 0; d < options.dst_count; d++) {
+				for(r = 0; r < options.rotate_count; r++) {
+					memset(&info, 0, sizeof(imgp_info_s));
+					info.src = src;
+					info.dst = dst;
+					g_strlcpy(info.input_format_label, options.src[s], IMAGE_FORMAT_LABEL_BUFFER_SIZE);
+					g_strlcpy(info.output_format_label, options.dst[d], IMAGE_FORMAT_LABEL_BUFFER_SIZE);
+					info.src_width = options.size[z].width;
+					info.src_height = options.size[z].height;
+					info.angle = options.rotate[r];
+					if(info.angle == MM_UTIL_ROTATE_90 || info.angle == MM_UTIL_ROTATE_270) {
+						info.dst_width = dst_height;
+						info.dst_height = dst_width;
+					}else {
+						info.dst_width = dst_width;
+						info.dst_height = dst_height;
+					}
+					info.thread_count = options.threads;
+					info.resize_filter = options.filter;
+
+					_bench_run_case(&options, &info, &result);
+					_bench_print_result(&options, &info, &result, first);
+					first = FALSE;
+					if(result.result != MM_ERROR_NONE) {
+						failed++;
+					}
+				}
+			}
+		}
+		g_free(src);
+		g_free(dst);
+	}
+	if(options.format == BENCH_FORMAT_JSON) {
+		fprintf(options.out, "\n]\n");
+	}
+	if(options.out != stdout) {
+		fclose(options.out);
+	}
+	fprintf(stderr, "%u unsupported or failed cases\n", failed);
+	return 0;
+}
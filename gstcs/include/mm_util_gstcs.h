@@ -31,6 +31,8 @@ extern "C" {
 #include <string.h>
 
 #define IMAGE_FORMAT_LABEL_BUFFER_SIZE 9
+#define MM_UTIL_IMG_PLANE_MAX 3
+#define MM_UTIL_IMGP_ASYNC_MAX_JOBS 16
 
 typedef enum
 {
@@ -43,6 +45,33 @@ typedef enum
 	MM_UTIL_ROTATE_NUM              /**< Number of rotation types */
 } mm_util_img_rotate_type_e;
 
+typedef enum
+{
+	MM_UTIL_RESIZE_FILTER_DEFAULT,  /**< Bilinear, as videoscale does */
+	MM_UTIL_RESIZE_FILTER_NEAREST,  /**< Nearest sample - fastest */
+	MM_UTIL_RESIZE_FILTER_BILINEAR, /**< Bilinear */
+	MM_UTIL_RESIZE_FILTER_BICUBIC,  /**< Bicubic - sharper */
+	MM_UTIL_RESIZE_FILTER_LANCZOS,  /**< Lanczos with 3 lobes - best quality, slowest */
+	MM_UTIL_RESIZE_FILTER_AREA,     /**< Average of the covered area - fast for integer downscales such as thumbnails */
+	MM_UTIL_RESIZE_FILTER_THUMBNAIL, /**< 2x / 4x / 8x box reductions of the source before any conversion, then bilinear - fastest for large downscales */
+	MM_UTIL_RESIZE_FILTER_NUM       /**< Number of resize filters */
+} mm_util_img_resize_filter_e;
+
+typedef enum
+{
+	MM_UTIL_COLOR_MATRIX_BT601,     /**< ITU-R BT.601, SD content - default */
+	MM_UTIL_COLOR_MATRIX_BT709,     /**< ITU-R BT.709, HD content */
+	MM_UTIL_COLOR_MATRIX_BT2020,    /**< ITU-R BT.2020 non constant luminance, UHD content */
+	MM_UTIL_COLOR_MATRIX_NUM        /**< Number of color matrices */
+} mm_util_img_color_matrix_e;
+
+typedef enum
+{
+	MM_UTIL_COLOR_RANGE_LIMITED,    /**< Y in [16, 235], Cb / Cr in [16, 240] - default */
+	MM_UTIL_COLOR_RANGE_FULL,       /**< Y, Cb and Cr in [0, 255], e.g. JPEG */
+	MM_UTIL_COLOR_RANGE_NUM         /**< Number of color ranges */
+} mm_util_img_color_range_e;
+
 /* Enumerations */
 typedef enum
 {
@@ -74,11 +103,17 @@ typedef enum
 	MM_UTIL_IMG_FMT_BGRX8888,      /**<BGRX8888 pixel format */
 	/* non-standard format */
 	MM_UTIL_IMG_FMT_NV12_TILED,     /**< Customized color format in s5pc110 */
+	MM_UTIL_IMG_FMT_YV12,           /**< YV12 format - planar, V before U */
+	MM_UTIL_IMG_FMT_Y444,           /**< YUV444 format - planar */
+	MM_UTIL_IMG_FMT_BGR888,         /**< BGR888 pixel format */
+	MM_UTIL_IMG_FMT_ABGR8888,       /**< ABGR8888 pixel format */
 	MM_UTIL_IMG_FMT_NUM,            /**< Number of image formats */
 } mm_util_img_format_e;
 
 /**
  * Image Process Info for dlopen
+ * It is allocated by the callers, so its layout is part of the ABI: the fields after angle came with soname 1 (version 0.4),
+ * binaries built against the previous layout must be rebuilt
  */
 typedef struct _imgp_info_s
 {
@@ -95,8 +130,126 @@ typedef struct _imgp_info_s
 	unsigned int output_stride;
 	unsigned int output_elevation;
 	mm_util_img_rotate_type_e angle;
+	unsigned int thread_count; /* threads converting horizontal stripes of the image with the native kernels, 0 or 1 for the calling thread only */
+	mm_util_img_resize_filter_e resize_filter; /* quality / speed tradeoff of a resize, the gstreamer pipelines map it to a videoscale method */
+	mm_util_img_color_matrix_e color_matrix; /* matrix of the YUV side of a conversion between YUV and RGB */
+	mm_util_img_color_range_e color_range; /* range of the YUV side of a conversion between YUV and RGB */
+	unsigned int src_crop_x; /* left column of the rectangle of the source which is processed, a multiple of the chroma subsampling */
+	unsigned int src_crop_y; /* top row of the rectangle, a multiple of the chroma subsampling */
+	unsigned int src_crop_width; /* size of the rectangle, both 0 for the whole source. It is resized to dst_width x dst_height */
+	unsigned int src_crop_height;
+	unsigned char *src_planes[MM_UTIL_IMG_PLANE_MAX]; /* planes of a source stored apart from each other, e.g. by a decoder. Used instead of src when src_planes[0] is set */
+	unsigned int src_strides[MM_UTIL_IMG_PLANE_MAX]; /* bytes between two rows of each plane of src_planes, 0 for the stride of a packed buffer */
+	unsigned int dst_strides[MM_UTIL_IMG_PLANE_MAX]; /* bytes between two rows of each plane of dst, 0 for the stride of a packed buffer */
+	unsigned int dst_offsets[MM_UTIL_IMG_PLANE_MAX]; /* offset of each plane in dst, 0 for a plane which follows the previous one. All 0 with dst_strides for a packed dst */
 } imgp_info_s;
 
+typedef enum
+{
+	IMGP_STAGE_FORMAT_SETUP = 0,    /**< image format and caps of the input and the output */
+	IMGP_STAGE_PIPELINE_CREATE,     /**< creation of the pipeline and its elements */
+	IMGP_STAGE_LINK,                /**< link of the elements and setup of appsrc / appsink */
+	IMGP_STAGE_PLAYING,             /**< transition of the pipeline to PLAYING */
+	IMGP_STAGE_FRAME,               /**< wait for the converted frame delivered by appsink */
+	IMGP_STAGE_COPY,                /**< copy of the output buffer which was not allocated in dst, or of source planes a pipeline can not read in place */
+	IMGP_STAGE_TEARDOWN,            /**< transition of the pipeline to NULL and release */
+	IMGP_STAGE_NATIVE,              /**< conversion by the native kernels */
+	IMGP_STAGE_NUM,                 /**< Number of stages */
+} imgp_stage_e;
+
+typedef struct _imgp_stage_timing_s
+{
+	unsigned long long count;        /**< Number of times the stage ran */
+	unsigned long long total_us;     /**< Cumulative time of the stage in microseconds */
+	unsigned long long max_us;       /**< Longest run of the stage in microseconds */
+	unsigned long long last_call_us; /**< Time of the stage in the last completed call, 0 when it did not run */
+} imgp_stage_timing_s;
+
+typedef struct _imgp_timing_s
+{
+	unsigned long long calls;        /**< Completed calls of the API since the last reset */
+	imgp_stage_timing_s stage[IMGP_STAGE_NUM];
+} imgp_timing_s;
+
+/**
+ * Completion callback of mm_imgp_async, called from a worker thread of the library.
+ * pImgp_info is the copy of the job, with output_stride and output_elevation set.
+ * It may call mm_imgp_async to queue the next stage of the frame, which never waits for a free slot from the callback,
+ * but not mm_imgp_async_wait_all, which fails with MM_ERROR_IMAGE_INVALID_VALUE there. The job counts as pending until it returns
+ */
+typedef void (*imgp_completed_cb)(imgp_info_s* pImgp_info, int result, void* user_data);
+
+/**
+ * Source callback of mm_imgp_stream: fill band with the rows [y, y + rows) of the source, laid out as a frame of rows rows
+ * of the input format as mm_setup_image_size counts it. The rows are asked in order, each one once
+ */
+typedef int (*imgp_stream_read_cb)(unsigned int y, unsigned int rows, unsigned char* band, void* user_data);
+
+/**
+ * Sink callback of mm_imgp_stream: band holds the rows [y, y + rows) of dst, laid out as a frame of rows rows
+ * of the output format. The bands come in order and band is valid until the callback returns
+ */
+typedef int (*imgp_stream_write_cb)(unsigned int y, unsigned int rows, const unsigned char* band, void* user_data);
+
+/**
+ * Handle of a reusable image process context
+ */
+typedef void *imgp_context_h;
+
+/**
+ * Statistics of the pipeline cache used by mm_imgp
+ */
+typedef struct _imgp_cache_stats_s
+{
+	unsigned int count;              /**< Number of pipelines currently cached */
+	unsigned int max_size;           /**< Maximum number of cached pipelines */
+	unsigned long long hits;         /**< Calls which reused a cached pipeline */
+	unsigned long long misses;       /**< Calls which had to link a new pipeline */
+	unsigned long long evictions;    /**< Pipelines released to respect max_size */
+} imgp_cache_stats_s;
+
+/**
+ * Statistics of the pool of memory blocks, GstBuffers and image formats recycled across the calls
+ */
+typedef struct _imgp_pool_stats_s
+{
+	unsigned int max_bytes;          /**< Maximum size of the memory blocks kept in the pool */
+	unsigned int bytes;              /**< Size of the memory blocks currently kept in the pool */
+	unsigned int max_buffers;        /**< Maximum number of GstBuffers kept in the pool */
+	unsigned int buffers;            /**< Number of GstBuffers currently kept in the pool */
+	unsigned int max_formats;        /**< Maximum number of image formats and their caps kept in the pool */
+	unsigned int formats;            /**< Number of image formats currently kept in the pool */
+	unsigned long long block_hits;   /**< Memory blocks reused from the pool */
+	unsigned long long block_misses; /**< Memory blocks which had to be allocated */
+	unsigned long long buffer_hits;  /**< GstBuffers reused from the pool */
+	unsigned long long buffer_misses;/**< GstBuffers which had to be created */
+	unsigned long long format_hits;  /**< Image formats and caps reused by a new pipeline */
+	unsigned long long format_misses;/**< Image formats and caps which had to be created */
+} imgp_pool_stats_s;
+
+/**
+ * Implementation which runs a process, from the fastest to the slowest
+ */
+typedef enum
+{
+	MM_UTIL_IMGP_TIER_NONE = 0,      /**< Neither the native kernels nor a pipeline can do the process */
+	MM_UTIL_IMGP_TIER_GSTREAMER,     /**< Pipeline of gstreamer elements */
+	MM_UTIL_IMGP_TIER_NATIVE_C,      /**< Native kernels in portable C */
+	MM_UTIL_IMGP_TIER_NATIVE_SIMD,   /**< Native kernels with the SIMD instructions of the cpu */
+} mm_util_imgp_tier_e;
+
+/**
+ * Implementation selected for a process by mm_imgp_query
+ */
+typedef struct _imgp_kernel_info_s
+{
+	mm_util_imgp_tier_e tier;
+	const char* kernel;              /**< "tile", "csc", "rotate", "resize" or "fused" for the native tiers, "pipeline" or "" */
+	const char* isa;                 /**< "C", "SSE2", "AVX2" or "NEON" for the native tiers, "" otherwise */
+	const char* pipeline;            /**< Elements between appsrc and appsink in the order of the gstreamer tier, "" otherwise */
+	unsigned long long bytes;        /**< Estimate of the bytes read and written by these elements, 0 for the native tiers */
+} imgp_kernel_info_s;
+
 /**
  *
  * @remark 	image size
@@ -129,6 +282,258 @@ mm_setup_image_size(const char* image_format_label, int width, int height);
 int
 mm_imgp(imgp_info_s* pImgp_info, imgp_type_e _imgp_type_e);
 
+/**
+ *
+ * @remark 	process an array of frames, consecutive frames of the same geometry go through one pipeline
+ *		with several frames in flight. output_stride and output_elevation of every frame are set
+ *
+ * @param	frames 											 [in/out]	array of n frames, src and dst of each frame must be set
+ * @param	n 												 [in]		number of frames
+ * @param	_imgp_type_e 									 [in]		convert / resize / rotate
+ * @param	results 										 [out]		result of each frame, can be NULL
+ * @return  	This function returns MM_ERROR_NONE when every frame is processed, else the error of the first failed frame
+*/
+int
+mm_imgp_batch(imgp_info_s* frames, unsigned int n, imgp_type_e _imgp_type_e, int* results);
+
+/**
+ *
+ * @remark 	produce several outputs of one source, e.g. a preview, a screen nail and a thumbnail, reading the source once.
+ *		The outputs the native kernels do walk the source together in bands which stay in the cache, the others are pushed
+ *		to their pipelines first so that they run meanwhile. output_stride and output_elevation of every output are set
+ *
+ * @param	outputs 										 [in/out]	array of n outputs with their format label, size, angle, resize filter and dst.
+ *										 			the source of outputs[0] (src or src_planes, input format label, width, height, crop) is the one of every output
+ * @param	n 												 [in]		number of outputs
+ * @param	_imgp_type_e 									 [in]		convert / resize / rotate
+ * @param	results 										 [out]		result of each output, can be NULL
+ * @return  	This function returns MM_ERROR_NONE when every output is produced, else the error of the first failed output
+*/
+int
+mm_imgp_fanout(imgp_info_s* outputs, unsigned int n, imgp_type_e _imgp_type_e, int* results);
+
+/**
+ *
+ * @remark 	queue the job on the worker pool of the library and return, completed_cb is called when dst is filled.
+ *		when MM_UTIL_IMGP_ASYNC_MAX_JOBS jobs are pending, the call waits until one of them completes, except when it is
+ *		called from a completed_cb: the job is then queued over the limit, so that a chain of stages can not deadlock the pool.
+ *		A completed_cb must not call mm_imgp_async_wait_all, which fails there
+ *
+ * @param	pImgp_info 										 [in]		job, it is copied, src and dst must stay valid until completed_cb
+ * @param	_imgp_type_e 									 [in]		convert / resize / rotate
+ * @param	completed_cb 									 [in]		callback called from a worker thread
+ * @param	user_data 										 [in]		user data of completed_cb
+ * @return  	This function returns MM_ERROR_NONE when the job is queued, completed_cb is not called otherwise
+*/
+int
+mm_imgp_async(imgp_info_s* pImgp_info, imgp_type_e _imgp_type_e, imgp_completed_cb completed_cb, void* user_data);
+
+/**
+ *
+ * @remark 	wait until every job queued by mm_imgp_async is completed and its completed_cb returned
+ *
+ * @return  	This function returns MM_ERROR_NONE on success, MM_ERROR_IMAGE_INVALID_VALUE when it is called from a completed_cb
+*/
+int
+mm_imgp_async_wait_all(void);
+
+/**
+ *
+ * @remark 	enable or disable the per-stage timing of every call. It is disabled by default,
+ *		MM_IMGP_TIMING=1 in the environment enables it and MM_IMGP_TIMING_FILE=path dumps it when the library is unloaded
+ *
+ * @param	enable 											 [in]		non zero to enable
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_timing_set_enabled(int enable);
+
+/**
+ *
+ * @remark 	get the cumulative timing of each stage and the breakdown of the last completed call
+ *
+ * @param	timing 											 [out]		timing of the stages
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_timing_get(imgp_timing_s *timing);
+
+/**
+ *
+ * @remark 	reset the timing of every stage
+ *
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_timing_reset(void);
+
+/**
+ *
+ * @remark 	append the timing of every stage to a file as text
+ *
+ * @param	path 											 [in]		file to append to
+ * @return  	This function returns MM_ERROR_NONE on success, MM_ERROR_IMAGE_FILEOPEN when the file can not be opened
+*/
+int
+mm_imgp_timing_dump(const char *path);
+
+/**
+ *
+ * @remark 	create a context which keeps the gstreamer pipeline linked and in PLAYING state for the given conversion,
+ *		so that several frames of the same geometry can be processed without rebuilding the pipeline
+ *
+ * @param	context 										 [out]		handle of the created context
+ * @param	pImgp_info 										 [in]		input / output format label, width, height, angle and source crop. src and dst are not used,
+ *										 			the frames processed have the size of the whole source and are cropped by the context
+ * @param	_imgp_type_e 										 [in]		convert / resize / rotate
+ * @return  	This function returns MM_ERROR_NONE on success, output_stride and output_elevation of pImgp_info are filled
+*/
+int
+mm_imgp_context_create(imgp_context_h *context, imgp_info_s* pImgp_info, imgp_type_e _imgp_type_e);
+
+/**
+ *
+ * @remark 	process one frame through the pipeline of the context
+ *
+ * @param	context 										 [in]		handle created by mm_imgp_context_create
+ * @param	src 											 [in]		input image buffer
+ * @param	dst 											 [out]		output image buffer
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_context_process(imgp_context_h context, unsigned char *src, unsigned char *dst);
+
+/**
+ *
+ * @remark 	stop the pipeline of the context and release it
+ *
+ * @param	context 										 [in]		handle created by mm_imgp_context_create
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_context_destroy(imgp_context_h context);
+
+/**
+ *
+ * @remark 	mm_imgp keeps the linked pipelines of the recently used (format label, width, height, angle) combinations in a LRU cache
+ *
+ * @param	max_size 										 [in]		maximum number of cached pipelines, 0 disables the cache
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_cache_set_size(unsigned int max_size);
+
+/**
+ *
+ * @remark 	get the hit / miss / eviction counters of the pipeline cache
+ *
+ * @param	stats 											 [out]		statistics of the pipeline cache
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_cache_get_stats(imgp_cache_stats_s *stats);
+
+/**
+ *
+ * @remark 	release every cached pipeline
+ *
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_cache_flush(void);
+
+/**
+ *
+ * @remark 	the input and output GstBuffers of the pipelines, the scratch frames of the conversions and the caps of the pipelines
+ *		are recycled by a pool. The memory blocks are kept in size classes up to max_bytes in total
+ *
+ * @param	max_bytes 										 [in]		maximum size of the memory blocks kept, 0 disables the pool of blocks
+ * @param	max_buffers 									 [in]		maximum number of GstBuffers kept, 0 disables the pool of GstBuffers
+ * @param	max_formats 									 [in]		maximum number of image formats and caps kept, 0 disables the pool of formats
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_pool_set_limits(unsigned int max_bytes, unsigned int max_buffers, unsigned int max_formats);
+
+/**
+ *
+ * @remark 	get the size and the hit / miss counters of the pool
+ *
+ * @param	stats 											 [out]		statistics of the pool
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_pool_get_stats(imgp_pool_stats_s *stats);
+
+/**
+ *
+ * @remark 	release everything the pool keeps, the limits stay the same
+ *
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_pool_flush(void);
+
+/**
+ *
+ * @remark 	tell which implementation mm_imgp would run for the formats, sizes, angle and filter of pImgp_info without running it.
+ *		The kernels of the cpu are probed once. The environment variable MM_IMGP_TIER forces a tier to compare them:
+ *		"gstreamer" runs every process a pipeline can do in a pipeline, "c" keeps the native kernels but without SIMD,
+ *		"sse2" or "avx2" limit the SIMD instructions used on x86
+ *
+ * @param	pImgp_info 										 [in]		input / output format label, width, height, angle and resize filter. src and dst are not used
+ * @param	info 											 [out]		tier, native kernel and instruction set, or order of the elements of the pipeline
+ * @return  	This function returns MM_ERROR_NONE on success, MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT when no tier can do the process
+*/
+int
+mm_imgp_query(imgp_info_s* pImgp_info, imgp_kernel_info_s* info);
+
+/**
+ *
+ * @remark 	initialize gstreamer, load the plugins of the pipelines, run a small frame through one and probe the native kernels
+ *		ahead of the first process, so that it does not pay for the cold start. It is optional, the first pipeline of the
+ *		process does the same, and it can be called from any thread more than once
+ *
+ * @return  	This function returns MM_ERROR_NONE on success
+*/
+int
+mm_imgp_prewarm(void);
+
+/**
+ *
+ * @remark 	convert and / or resize a frame a band of rows at a time with the native kernels, so that neither the source
+ *		nor dst has to be in memory: the source rows are pulled from read_cb and the rows of dst pushed to write_cb.
+ *		The memory used is a few bands and the source rows the resize filter of a band reads. src, dst, the planes
+ *		and strides of pImgp_info are not used, rotations and crops are not supported
+ *
+ * @param	pImgp_info 										 [in/out]	input / output format label, width, height and resize filter. output_stride and output_elevation are set
+ * @param	_imgp_type_e 									 [in]		convert / resize
+ * @param	band_height 									 [in]		rows of dst of a band, rounded up to an even number. 0 for the default of 64
+ * @param	read_cb 										 [in]		callback filling the bands of the source
+ * @param	write_cb 										 [in]		callback taking the bands of dst
+ * @param	user_data 										 [in]		user data of the callbacks
+ * @return  	This function returns MM_ERROR_NONE on success, MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT when the native kernels can not
+ *		do the process a band at a time, or the error a callback returned
+*/
+int
+mm_imgp_stream(imgp_info_s* pImgp_info, imgp_type_e _imgp_type_e, unsigned int band_height,
+	imgp_stream_read_cb read_cb, imgp_stream_write_cb write_cb, void* user_data);
+
+/**
+ *
+ * @remark 	mm_imgp_stream from the file src_path to the file dst_path, both are mapped in memory. The pages of the rows
+ *		already processed are released as the bands go, so that the frames are never resident as a whole
+ *
+ * @param	pImgp_info 										 [in/out]	as mm_imgp_stream
+ * @param	_imgp_type_e 									 [in]		convert / resize
+ * @param	band_height 									 [in]		as mm_imgp_stream
+ * @param	src_path 										 [in]		file holding the source laid out as mm_setup_image_size counts it
+ * @param	dst_path 										 [in]		file created or truncated to hold dst
+ * @return  	This function returns MM_ERROR_NONE on success, MM_ERROR_IMAGE_FILEOPEN when a file can not be opened or mapped
+*/
+int
+mm_imgp_stream_file(imgp_info_s* pImgp_info, imgp_type_e _imgp_type_e, unsigned int band_height, const char* src_path, const char* dst_path);
+
 #ifdef __cplusplus__
 };
 #endif
@@ -0,0 +1,105 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MM_UTIL_GSTCS_FORMAT_H__
+#define __MM_UTIL_GSTCS_FORMAT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mm_util_gstcs.h"
+
+/*
+ * Descriptor of every mm_util_img_format_e, the size of a buffer, the caps given to gstreamer,
+ * the plane layout of the native kernels and the resize / rotate capabilities all come from it.
+ */
+
+#define IMGP_FORMAT_PLANE_MAX 3
+
+#define IMGP_FORMAT_FLAG_RESIZE   (1 << 0)  /* videoscale handles the format */
+#define IMGP_FORMAT_FLAG_ROTATE   (1 << 1)  /* videoflip handles the format */
+#define IMGP_FORMAT_FLAG_TILED    (1 << 2)  /* the planes are made of tiles, not of rows */
+
+typedef struct _imgp_plane_desc_s
+{
+	unsigned char width_align;   /* the width of the image is rounded up to it before the subsampling */
+	unsigned char height_align;  /* the height of the image is rounded up to it before the subsampling */
+	unsigned char x_shift;       /* log2 of the horizontal subsampling */
+	unsigned char y_shift;       /* log2 of the vertical subsampling */
+	unsigned char pixel_bytes;   /* bytes of a sample, or of a pixel for packed formats */
+	unsigned char stride_align;  /* the stride in bytes is rounded up to it */
+} imgp_plane_desc_s;
+
+typedef struct _imgp_format_desc_s
+{
+	mm_util_img_format_e format;
+	const char* label;           /* label of imgp_info_s */
+	const char* colorspace;      /* YUV, RGB, RGBA or BGRX */
+	unsigned int fourcc;         /* video/x-raw-yuv formats */
+	int bpp;                     /* video/x-raw-rgb formats */
+	int depth;
+	int red_mask;
+	int green_mask;
+	int blue_mask;
+	int alpha_mask;
+	int endianness;
+	unsigned int plane_count;    /* 0 when the buffer has no linear layout */
+	imgp_plane_desc_s plane[IMGP_FORMAT_PLANE_MAX];
+	unsigned int flags;          /* IMGP_FORMAT_FLAG_* */
+} imgp_format_desc_s;
+
+/**
+ * @remark	descriptor of the format, NULL when it is out of range
+ */
+const imgp_format_desc_s*
+_mm_format_get_desc(mm_util_img_format_e format);
+
+/**
+ * @remark	descriptor of a label of imgp_info_s, NULL when the label is unknown.
+ *		The first 4 characters select the only candidate, so the cost does not depend on the number of formats
+ */
+const imgp_format_desc_s*
+_mm_format_get_desc_by_label(const char* label);
+
+/**
+ * @remark	stride in bytes and number of rows of a plane
+ */
+void
+_mm_format_get_plane_size(const imgp_format_desc_s* desc, unsigned int plane, unsigned int width, unsigned int height, unsigned int* stride, unsigned int* rows);
+
+/**
+ * @remark	size in bytes of a buffer of the format, 0 when the format has no linear layout
+ */
+unsigned int
+_mm_format_get_size(const imgp_format_desc_s* desc, unsigned int width, unsigned int height);
+
+/**
+ * @remark	columns and rows a rectangle of the format starts on, so that it begins with a sample of every plane
+ */
+void
+_mm_format_get_crop_align(const imgp_format_desc_s* desc, unsigned int* x_align, unsigned int* y_align);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/*__MM_UTIL_GSTCS_FORMAT_H__*/
@@ -33,8 +33,30 @@ extern "C" {
 #include <gst/app/gstappbuffer.h>
 #include <gst/app/gstappsink.h>
 #include "mm_util_gstcs.h"
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_format.h"
 #include "mm_log.h"
 
+/* elements of the pipelines, their factories are looked up and loaded once */
+typedef enum
+{
+	IMGP_ELEMENT_APPSRC = 0,
+	IMGP_ELEMENT_COLORSPACE,
+	IMGP_ELEMENT_VIDEOSCALE,
+	IMGP_ELEMENT_VIDEOFLIP,
+	IMGP_ELEMENT_APPSINK,
+	IMGP_ELEMENT_NUM,
+} imgp_element_e;
+
+/* order of the elements between appsrc and appsink */
+#define IMGP_PLAN_ELEMENT_MAX 3
+typedef struct _imgp_plan_s
+{
+	const char* name;
+	imgp_element_e element[IMGP_PLAN_ELEMENT_MAX];
+	unsigned int count;
+} imgp_plan_s;
+
 typedef struct _image_format_s
 {
 	char format_label[IMAGE_FORMAT_LABEL_BUFFER_SIZE]; //I420, AYUV, RGB888, BGRA8888
@@ -44,9 +66,18 @@ typedef struct _image_format_s
 	int stride;
 	int elevation;
 	int blocksize;
+	mm_util_img_color_matrix_e color_matrix; /* colorimetry of the YUV caps */
 	GstCaps* caps;
+	const imgp_format_desc_s* desc; /* NULL when format_label is unknown */
 } image_format_s;
 
+/* memory of the caller for the output buffer of a frame in flight */
+typedef struct _imgp_dst_s
+{
+	guint64 frame; /* offset of the buffer pushed for the frame, the elements allocate its output with it */
+	unsigned char* dst; /* NULL when the pipeline can not write the layout of dst */
+} imgp_dst_s;
+
 typedef struct _gstreamer_s
 {
 	GMainLoop *loop;
@@ -56,9 +87,171 @@ typedef struct _gstreamer_s
 	GstElement *videoscale;
 	GstElement *videoflip;
 	GstElement *appsink;
-	GstBuffer *output_buffer;
+	GQueue output_buffers; /* converted frames in the order they were pushed */
+	GMutex lock; /* protects output_buffers, dsts and error while the pipeline stays in PLAYING */
+	GCond cond;
+	gboolean error;
+	guint64 frame_count;
+	GQueue dsts; /* imgp_dst_s of the frames in flight, the oldest first */
+	unsigned int dst_size;
+	guint64 copy_count; /* frames whose output buffer was not their dst and was copied into it */
 } gstreamer_s;
 
+typedef struct _imgp_context_s
+{
+	imgp_info_s info; /* geometry the pipeline was linked for */
+	image_format_s* input_format;
+	image_format_s* output_format;
+	gstreamer_s* gstreamer;
+	gboolean native; /* converted by the native kernels, there is no pipeline */
+	imgp_info_s source; /* geometry of the frames processed with a crop, which info was set up for. Zeroed without a crop */
+} imgp_context_s;
+
+typedef struct _imgp_job_s
+{
+	imgp_info_s info;
+	imgp_type_e type;
+	imgp_completed_cb completed_cb;
+	void* user_data;
+} imgp_job_s;
+
+typedef struct _imgp_stripes_s
+{
+	imgp_native_stripe_f func;
+	const imgp_native_op_s* op;
+	GMutex lock; /* protects pending and ret */
+	GCond cond;
+	unsigned int pending; /* stripes still running on the worker pool */
+	int ret; /* first error of the stripes */
+} imgp_stripes_s;
+
+typedef struct _imgp_stripe_s
+{
+	imgp_stripes_s* stripes;
+	unsigned int y_start;
+	unsigned int y_end;
+} imgp_stripe_s;
+
+/* state of mm_imgp_stream: the source rows the bands of dst read are kept in a window of the work format,
+ * the rows no band reads anymore are dropped from its start before the next ones are appended */
+typedef struct _imgp_stream_s
+{
+	imgp_stream_read_cb read_cb;
+	imgp_stream_write_cb write_cb;
+	void* user_data;
+	unsigned int thread_count;
+	const imgp_yuv_coeffs_s* coeffs; /* matrix and range of the conversions between YUV and RGB */
+	mm_util_img_format_e src_format;
+	mm_util_img_format_e work_format; /* format which is resized, the one of the source or of dst */
+	mm_util_img_format_e dst_format;
+	unsigned int src_width;
+	unsigned int src_height;
+	unsigned int dst_width;
+	unsigned int dst_height;
+	unsigned int band_rows;          /* rows of dst of a band */
+	unsigned int window_rows;        /* rows of the source the window holds at most */
+	unsigned int window_y;           /* first row of the source in the window */
+	unsigned int window_end;         /* next row of the source to read */
+	imgp_frame_s window;
+	imgp_frame_s resize_src;         /* the whole source and dst of the resize, their planes are the window and the band of each band */
+	imgp_frame_s resize_dst;
+	unsigned char* read_band;        /* rows of the source given by read_cb, NULL when they are read in the window */
+	unsigned char* work_band;        /* resized band of the work format, NULL when it is the format of dst */
+	unsigned char* dst_band;
+} imgp_stream_s;
+
+/* file of mm_imgp_stream_file mapped in memory */
+typedef struct _imgp_stream_file_s
+{
+	imgp_frame_s frame;              /* the whole frame over the mapping */
+	unsigned char* map;
+	size_t size;
+	size_t released[IMGP_NATIVE_PLANE_MAX]; /* bytes of each plane whose pages were released */
+} imgp_stream_file_s;
+
+/* output of mm_imgp_fanout */
+typedef struct _imgp_fanout_s
+{
+	imgp_info_s info;                /* the output with the source of the first one */
+	imgp_native_stripe_f func;       /* native kernel, NULL for a pipeline */
+	imgp_frame_s src;
+	imgp_frame_s dst;
+	imgp_native_op_s op;
+	gboolean banded;                 /* the rows of dst read the rows of the source in order, they are converted as the bands go */
+	unsigned int y;                  /* rows of dst done */
+	imgp_context_s* context;         /* pipeline the frame was pushed to */
+	int ret;
+} imgp_fanout_s;
+
+/* what a process asks of the native kernels */
+typedef struct _imgp_request_s
+{
+	mm_util_img_format_e src_format;
+	mm_util_img_format_e dst_format;
+	unsigned int src_width;
+	unsigned int src_height;
+	unsigned int dst_width; /* after the rotation */
+	unsigned int dst_height;
+	mm_util_img_rotate_type_e angle;
+	mm_util_img_resize_filter_e filter;
+	gboolean resize;
+} imgp_request_s;
+
+/* entry of the registry of the native kernels, the first one which supports a request runs it */
+typedef struct _imgp_kernel_s
+{
+	const char* name;
+	gboolean (*supported)(const imgp_request_s* request);
+	gboolean (*simd)(const imgp_request_s* request); /* whether the SIMD kernels of the cpu do the work, NULL when it is all C */
+	imgp_native_stripe_f func;
+} imgp_kernel_s;
+
+/* header of a memory block of the pool, the data follows it */
+typedef union _imgp_pool_block_s
+{
+	struct {
+		union _imgp_pool_block_s* next; /* next free block of the size class */
+		unsigned int size_class;        /* (unsigned int) -1 when the block is too large to be pooled */
+	} free;
+	guint64 align[2]; /* keeps the data as aligned as the allocation */
+} imgp_pool_block_s;
+
+/**
+ * @remark	block of at least size bytes, from the pool when a block of its size class was released before
+ */
+gpointer
+_mm_imgp_pool_alloc(gsize size);
+
+/**
+ * @remark	give a block of _mm_imgp_pool_alloc back to the pool, it is freed when the pool is full
+ */
+void
+_mm_imgp_pool_free(gpointer data);
+
+/**
+ * @remark	empty GstBuffer which goes back to the pool instead of being freed when its last reference is dropped
+ */
+GstBuffer*
+_mm_imgp_pool_buffer_new(void);
+
+/**
+ * @remark	GstBuffer of the pool holding size bytes of a block of the pool
+ */
+GstBuffer*
+_mm_imgp_pool_buffer_new_and_alloc(guint size);
+
+/**
+ * @remark	image format and caps released by a pipeline of the same format label, size and color matrix, NULL when the pool has none
+ */
+image_format_s*
+_mm_imgp_pool_format_take(const char* format_label, int width, int height, mm_util_img_color_matrix_e color_matrix);
+
+/**
+ * @remark	keep the image format and its caps for the next pipeline, or free them when the pool is full
+ */
+void
+_mm_imgp_pool_format_release(image_format_s* format);
+
 #ifdef __cplusplus
 }
 #endif
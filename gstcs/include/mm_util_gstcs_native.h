@@ -0,0 +1,346 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __MM_UTIL_GSTCS_NATIVE_H__
+#define __MM_UTIL_GSTCS_NATIVE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mm_util_gstcs.h"
+
+/*
+ * Native kernels which run without gstreamer for the most common conversions.
+ * They do not depend on glib, the rows of a frame can be processed in any order
+ * and the fixed point arithmetic is the one of ffmpegcolorspace (SCALEBITS 10), so BT.601 limited range
+ * is bit-exact with the gstreamer path. BT.709, BT.2020 and full range use the same arithmetic with their own coefficients:
+ *   I420 / NV12 -> RGB888, RGB565, ARGB8888, BGRA8888 : chroma of a 2x2 block is shared as ffmpegcolorspace does
+ *   RGB888, RGB565, ARGB8888, BGRA8888 -> I420 / NV12 : chroma is the rounded average of the 2x2 block
+ *   YUYV / UYVY -> I420 : chroma of the even line is used for the 2 lines
+ * and rotate / flip frames of any linear format with cache sized tiles of SIMD transposed blocks.
+ * I420 / NV12 -> RGB with a resize and / or a rotation is done in one fused pass with bilinear sampling.
+ * Frames of the other linear formats are resized with separable nearest, bilinear, bicubic, Lanczos or area filters.
+ * NV12 tiled frames are de-tiled to NV12 / I420 / RGB and tiled from them a row of tiles at a time.
+ */
+
+#define MM_UTIL_ROUND_UP_2(num)  (((num)+1)&~1)
+#define MM_UTIL_ROUND_UP_4(num)  (((num)+3)&~3)
+#define MM_UTIL_ROUND_UP_8(num)  (((num)+7)&~7)
+#define MM_UTIL_ROUND_UP_16(num)  (((num)+15)&~15)
+
+#define IMGP_NATIVE_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define IMGP_NATIVE_PLANE_MAX 3
+#define IMGP_NATIVE_SCALEBITS 10
+#define IMGP_NATIVE_FIX(x) ((int) ((x) * (1 << IMGP_NATIVE_SCALEBITS) + 0.5))
+
+typedef enum
+{
+	IMGP_NATIVE_ISA_C = 0,          /**< Portable C kernels */
+	IMGP_NATIVE_ISA_SSE2,           /**< x86 SSE2 kernels */
+	IMGP_NATIVE_ISA_AVX2,           /**< x86 AVX2 kernels */
+	IMGP_NATIVE_ISA_NEON,           /**< ARM NEON kernels */
+	IMGP_NATIVE_ISA_NUM,
+} imgp_native_isa_e;
+
+typedef enum
+{
+	IMGP_NATIVE_RGB32_ARGB = 0,     /**< [Low Address] A R G B [High Address] */
+	IMGP_NATIVE_RGB32_BGRA,         /**< [Low Address] B G R A [High Address] */
+} imgp_native_rgb32_order_e;
+
+typedef struct _imgp_frame_s
+{
+	mm_util_img_format_e format;
+	unsigned int width;
+	unsigned int height;
+	unsigned char *data[IMGP_NATIVE_PLANE_MAX];
+	unsigned int stride[IMGP_NATIVE_PLANE_MAX];
+} imgp_frame_s;
+
+typedef struct _imgp_yuv_coeffs_s
+{
+	/* YUV -> RGB : R = (y_scale * (Y - y_offset) + r_cr * (Cr - 128) + round) >> SCALEBITS, G and B alike */
+	int y_offset;
+	int y_scale;
+	int r_cr;
+	int g_cb;
+	int g_cr;
+	int b_cb;
+	/* RGB -> YUV : Y = (y_r * R + y_g * G + y_b * B + round + (y_offset << SCALEBITS)) >> SCALEBITS */
+	int y_r, y_g, y_b;
+	int u_r, u_g, u_b;
+	int v_r, v_g, v_b;
+} imgp_yuv_coeffs_s;
+
+/* SIMD row kernels, they return the number of pixels processed from the start of the row, the rest is done in C */
+typedef unsigned int (*imgp_native_yuv420_to_rgb32_row_f)(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order);
+
+/* transpose a square block: dst[j * dst_stride + i] = src[i * src_stride + j] for elements i, j of the block.
+ * The strides are in bytes and can be negative to walk the rows backwards */
+typedef void (*imgp_native_transpose_f)(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+
+/* reverse the order of the elements of a row: dst[i] = src[count - 1 - i], they return the number of elements of dst written */
+typedef unsigned int (*imgp_native_reverse_f)(const unsigned char *src, unsigned char *dst, unsigned int count);
+
+/* vertical pass of a resize: dst[x] = clip(sum of rows[t][x] * weights[t] >> IMGP_NATIVE_RESIZE_BITS) for count bytes,
+ * they return the number of bytes of dst written */
+typedef unsigned int (*imgp_native_resize_vertical_f)(const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+
+/* horizontal pass of a resize of 4 byte pixels: pixel i of dst is filtered from the taps pixels of src from start[i]
+ * with the weights i * taps, they return the number of pixels of dst written */
+typedef unsigned int (*imgp_native_resize_horizontal_f)(const unsigned char *src, const int *start, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+
+/* split interleaved CbCr pairs into u and v, or merge them back, for count pairs.
+ * they return the number of pairs done */
+typedef unsigned int (*imgp_native_split_uv_f)(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count);
+typedef unsigned int (*imgp_native_merge_uv_f)(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count);
+
+#define IMGP_NATIVE_RESIZE_BITS 14
+
+#define IMGP_NATIVE_TRANSPOSE_U8_BLOCK 8
+#define IMGP_NATIVE_TRANSPOSE_U16_BLOCK 8
+#define IMGP_NATIVE_TRANSPOSE_U32_BLOCK 4
+
+#define IMGP_NATIVE_FUSED_TILE 64        /* dst pixels of a side of the tiles of the fused pass */
+#define IMGP_NATIVE_FUSED_MAX_SIZE 16383 /* 16.16 positions of the fused pass fit in an int */
+
+#define IMGP_NATIVE_TILE_WIDTH 64        /* bytes of a row of a tile of NV12 tiled */
+#define IMGP_NATIVE_TILE_HEIGHT 32       /* rows of a tile, the 2048 bytes of a tile are contiguous */
+
+/* kernels selected for the cpu, a NULL row kernel means the C code does the whole row */
+typedef struct _imgp_native_kernels_s
+{
+	imgp_native_isa_e isa;
+	imgp_native_yuv420_to_rgb32_row_f yuv420_to_rgb32_row;
+	imgp_native_transpose_f transpose_u8;     /* IMGP_NATIVE_TRANSPOSE_U8_BLOCK square block of bytes */
+	imgp_native_transpose_f transpose_u16;    /* IMGP_NATIVE_TRANSPOSE_U16_BLOCK square block of 16 bit elements */
+	imgp_native_transpose_f transpose_u32;    /* IMGP_NATIVE_TRANSPOSE_U32_BLOCK square block of 32 bit elements */
+	imgp_native_reverse_f reverse_u8;
+	imgp_native_reverse_f reverse_u16;
+	imgp_native_reverse_f reverse_u32;
+	imgp_native_resize_vertical_f resize_vertical;
+	imgp_native_resize_horizontal_f resize_horizontal_u8x4;
+	imgp_native_split_uv_f split_uv;
+	imgp_native_merge_uv_f merge_uv;
+} imgp_native_kernels_s;
+
+/* coefficient tables of a resize, built once for a frame by _mm_native_resize_prepare */
+typedef struct _imgp_native_resize_s imgp_native_resize_s;
+
+/* operation shared by the stripes of a frame */
+typedef struct _imgp_native_op_s
+{
+	const imgp_frame_s *src;
+	const imgp_frame_s *dst;
+	mm_util_img_rotate_type_e angle;
+	mm_util_img_resize_filter_e filter;
+	unsigned int reduce;          /* box factor of every plane instead of filter, dst is the source size divided by it rounded up */
+	imgp_native_resize_s *resize;
+	unsigned int src_y;           /* even first row of src held by its planes when they are a band of a larger frame, 0 otherwise. Resize only */
+	unsigned int dst_y;           /* even first row of dst held by its planes, as src_y */
+	const imgp_yuv_coeffs_s *coeffs; /* matrix and range of the YUV side of a conversion to / from RGB, NULL for BT.601 limited range */
+} imgp_native_op_s;
+
+unsigned int _mm_native_yuv420_to_rgb32_row_sse2(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order);
+unsigned int _mm_native_yuv420_to_rgb32_row_avx2(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order);
+unsigned int _mm_native_yuv420_to_rgb32_row_neon(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order);
+void _mm_native_transpose_u8_c(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u16_c(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u32_c(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u8_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u16_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u32_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+unsigned int _mm_native_reverse_u8_sse2(const unsigned char *src, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_reverse_u16_sse2(const unsigned char *src, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_reverse_u32_sse2(const unsigned char *src, unsigned char *dst, unsigned int count);
+void _mm_native_transpose_u8_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u16_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+void _mm_native_transpose_u32_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride);
+unsigned int _mm_native_reverse_u8_neon(const unsigned char *src, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_reverse_u16_neon(const unsigned char *src, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_reverse_u32_neon(const unsigned char *src, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_resize_vertical_sse2(const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_resize_horizontal_u8x4_sse2(const unsigned char *src, const int *start, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_resize_vertical_neon(const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_resize_horizontal_u8x4_neon(const unsigned char *src, const int *start, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count);
+unsigned int _mm_native_split_uv_sse2(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count);
+unsigned int _mm_native_merge_uv_sse2(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count);
+unsigned int _mm_native_split_uv_neon(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count);
+unsigned int _mm_native_merge_uv_neon(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count);
+
+/* converter of the rows [y_start, y_end) of dst, stripes of a frame can run concurrently */
+typedef int (*imgp_native_stripe_f)(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	instruction set selected by cpu feature detection for the SIMD kernels
+ */
+imgp_native_isa_e
+_mm_native_get_isa(void);
+
+const char*
+_mm_native_get_isa_name(imgp_native_isa_e isa);
+
+/**
+ * @remark	kernels selected by cpu feature detection, the C ones fill what the instruction set does not provide
+ */
+const imgp_native_kernels_s*
+_mm_native_get_kernels(void);
+
+/**
+ * @remark	bytes of a sample and subsampling of a plane as the native kernels walk it, the CbCr pairs of NV12 are one sample
+ */
+void
+_mm_native_plane_layout(mm_util_img_format_e format, unsigned int plane, unsigned int *elem, unsigned int *x_shift, unsigned int *y_shift);
+
+/**
+ * @remark	set the planes of a frame stored in a contiguous buffer laid out as mm_setup_image_size expects
+ * @return	MM_ERROR_NONE, or MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT when the format has no native layout
+ */
+int
+_mm_native_frame_init(imgp_frame_s *frame, mm_util_img_format_e format, unsigned int width, unsigned int height, unsigned char *buffer);
+
+/**
+ * @remark	use the planes of a frame stored apart from each other, a stride of 0 keeps the stride of a packed buffer.
+ *		The frame keeps its format, width and height from _mm_native_frame_init
+ */
+int
+_mm_native_frame_set_planes(imgp_frame_s *frame, unsigned char *const *planes, const unsigned int *strides);
+
+/**
+ * @remark	copy the samples of every plane of src to dst, both of the same format and size but of any strides
+ */
+void
+_mm_native_frame_copy(const imgp_frame_s *dst, const imgp_frame_s *src);
+
+/**
+ * @remark	fixed point coefficients of a color matrix and range
+ * @return	NULL when the matrix or the range is unknown
+ */
+const imgp_yuv_coeffs_s*
+_mm_native_get_coeffs(mm_util_img_color_matrix_e matrix, mm_util_img_color_range_e range);
+
+/**
+ * @remark	check whether the native colorspace converter supports the pair
+ */
+int
+_mm_native_csc_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format);
+
+/**
+ * @remark	convert the rows [y_start, y_end) of src into dst, both frames have the same size.
+ *		y_start and y_end must be even when one of the frames is 4:2:0 unless y_end is the height.
+ *		coeffs is NULL for BT.601 limited range
+ */
+int
+_mm_native_csc(const imgp_frame_s *src, const imgp_frame_s *dst, const imgp_yuv_coeffs_s *coeffs, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	_mm_native_csc for the stripe runner
+ */
+int
+_mm_native_csc_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	check whether a frame of the format and size can be rotated / flipped natively, dst has the same format
+ */
+int
+_mm_native_rotate_supported(mm_util_img_format_e format, mm_util_img_rotate_type_e angle, unsigned int width, unsigned int height);
+
+/**
+ * @remark	rotate / flip op->src by op->angle into the rows [y_start, y_end) of op->dst.
+ *		the size of dst is the size of src, swapped for 90 and 270 degrees. y_start must be even
+ */
+int
+_mm_native_rotate_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	check whether src can be scaled to the dst size, converted and rotated / flipped in the fused pass.
+ *		dst_width and dst_height are the size after the rotation
+ */
+int
+_mm_native_fused_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format,
+	unsigned int src_width, unsigned int src_height, unsigned int dst_width, unsigned int dst_height);
+
+/**
+ * @remark	scale, convert and rotate / flip op->src by op->angle into the rows [y_start, y_end) of op->dst in one pass
+ */
+int
+_mm_native_fused_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	rows [src_start, src_end) of op->src which _mm_native_fused_rows reads for the rows [y_start, y_end) of op->dst,
+ *		the whole source for the angles which do not keep the order of its rows. src_start is even
+ */
+void
+_mm_native_fused_src_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end, unsigned int *src_start, unsigned int *src_end);
+
+/**
+ * @remark	check whether a frame of the format can be resized natively, dst has the same format
+ */
+int
+_mm_native_resize_supported(mm_util_img_format_e format, unsigned int src_width, unsigned int src_height, unsigned int dst_width, unsigned int dst_height);
+
+/**
+ * @remark	build the coefficient tables of op->filter, or the box reduction by op->reduce, for op->src and op->dst in op->resize
+ * @return	MM_ERROR_NONE, the tables must be freed by _mm_native_resize_release
+ */
+int
+_mm_native_resize_prepare(imgp_native_op_s *op);
+
+void
+_mm_native_resize_release(imgp_native_op_s *op);
+
+/**
+ * @remark	resize op->src into the rows [y_start, y_end) of op->dst. y_start must be even
+ */
+int
+_mm_native_resize_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+/**
+ * @remark	rows [src_start, src_end) of op->src which _mm_native_resize_rows reads for the rows [y_start, y_end) of op->dst,
+ *		src_start is even
+ */
+void
+_mm_native_resize_src_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end, unsigned int *src_start, unsigned int *src_end);
+
+/**
+ * @remark	check whether NV12 tiled can be de-tiled to dst_format, or src_format tiled to NV12 tiled, without a resize or a rotation
+ */
+int
+_mm_native_tile_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format);
+
+/**
+ * @remark	de-tile op->src or tile it into op->dst for the rows [y_start, y_end) of the frame. y_start must be even,
+ *		stripes which start on a row of tiles read or write every tile once
+ */
+int
+_mm_native_tile_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/*__MM_UTIL_GSTCS_NATIVE_H__*/
@@ -22,109 +22,48 @@
 #include <mm_debug.h>
 #include <gst/check/gstcheck.h>
 #include <mm_error.h>
-#define MM_UTIL_ROUND_UP_2(num)  (((num)+1)&~1)
-#define MM_UTIL_ROUND_UP_4(num)  (((num)+3)&~3)
-#define MM_UTIL_ROUND_UP_8(num)  (((num)+7)&~7)
-#define MM_UTIL_ROUND_UP_16(num)  (((num)+15)&~15)
-/*########################################################################################*/
-#define setup_image_size_I420(width, height) { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width) * MM_UTIL_ROUND_UP_2 (height) + MM_UTIL_ROUND_UP_8 (width) * MM_UTIL_ROUND_UP_2 (height) /2); \
-	return size; \
-}
-
-#define setup_image_size_Y42B(width, height)  { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width) * height + MM_UTIL_ROUND_UP_8 (width)  * height); \
-	return size; \
-}
-
-#define setup_image_size_Y444(width, height) { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width) * height  * 3); \
-	return size; \
-}
-
-#define setup_image_size_UYVY(width, height) { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_2 (width) * 2 * height); \
-	return size; \
-}
-
-#define setup_image_size_YUYV(width, height)  { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_2 (width) * 2 * height); \
-	return size; \
-}
-
-#define setup_image_size_YV12(width, height) { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width) * MM_UTIL_ROUND_UP_2 (height)+ MM_UTIL_ROUND_UP_8 (width) * MM_UTIL_ROUND_UP_2 (height) / 2); \
-	return size; \
-}
-
-#define setup_image_size_NV12(width, height) { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width) * MM_UTIL_ROUND_UP_2 (height) *1.5); \
-	return size; \
-}
-
-#define setup_image_size_RGB565(width, height)  { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width * 2) *height); \
-	return size; \
-}
-
-#define setup_image_size_RGB888(width, height)  { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width*3) * height); \
-	return size; \
-}
-
-#define setup_image_size_BGR888(width, height)  { \
-	int size=0; \
-	size = (MM_UTIL_ROUND_UP_4 (width*3) * height); \
-	return size; \
-}
-/*########################################################################################*/
-
-static void
-_mm_sink_buffer (GstElement * appsink, gpointer  user_data)
-{
-	GstBuffer *_buf=NULL;
-	gstreamer_s * pGstreamer_s = (gstreamer_s*) user_data;
-	_buf = gst_app_sink_pull_buffer((GstAppSink*)appsink);
-
-	pGstreamer_s->output_buffer = _buf;
-
-	if(pGstreamer_s->output_buffer != NULL) {
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Create Output Buffer: GST_BUFFER_DATA: %p\t GST_BUFFER_SIZE: %d\n", __func__, __LINE__, GST_BUFFER_DATA(pGstreamer_s->output_buffer),  GST_BUFFER_SIZE (pGstreamer_s->output_buffer));
-	}else {
-		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] ERROR -Input Prepare Buffer!  Check createoutput buffer function", __func__, __LINE__);
-	}
-	gst_buffer_unref (_buf); //we don't need the appsink buffer anymore
-	gst_buffer_ref (pGstreamer_s->output_buffer); //when you want to avoid flushing
-}
-
-static void
-_mm_sink_preroll (GstElement * appsink, gpointer  user_data)
-{
-	GstBuffer *_buf=NULL;
-	gstreamer_s * pGstreamer_s = (gstreamer_s*) user_data;
-	_buf = gst_app_sink_pull_preroll((GstAppSink*)appsink);
-
-	pGstreamer_s->output_buffer = _buf;
-	//pGstreamer_s->output_image_format_s->caps =  GST_BUFFER_CAPS(_buf);
-	if(pGstreamer_s->output_buffer != NULL) {
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Create Output Buffer: GST_BUFFER_DATA: %p\t GST_BUFFER_SIZE: %d\n", __func__, __LINE__,
-			GST_BUFFER_DATA(pGstreamer_s->output_buffer),  GST_BUFFER_SIZE (pGstreamer_s->output_buffer));
-	}else {
-		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] ERROR -Input Prepare Buffer!  Check createoutput buffer function", __func__, __LINE__);
-	}
-
-	gst_buffer_unref (_buf); // we don't need the appsink buffer anymore
-	gst_buffer_ref  (pGstreamer_s->output_buffer); //when you want to avoid flushings
-}
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MM_UTIL_IMGP_CACHE_DEFAULT_SIZE 4
+#define MM_UTIL_IMGP_GSTREAMER_KEY "mm-imgp-gstreamer"
+#define MM_UTIL_IMGP_BATCH_MAX_IN_FLIGHT 4 /* frames pushed ahead of the one being collected */
+#define MM_UTIL_IMGP_THREAD_MAX 16
+#define MM_UTIL_IMGP_STRIPE_MIN_ROWS 64 /* smaller stripes cost more in scheduling than they save */
+#define MM_UTIL_IMGP_ASYNC_THREADS 2 /* jobs converted concurrently, each one holds its own pipeline */
+#define MM_UTIL_IMGP_PREWARM_SIZE 64 /* width and height of the frame of mm_imgp_prewarm */
+#define MM_UTIL_IMGP_STREAM_BAND_ROWS 64 /* rows of dst of a band of mm_imgp_stream by default */
+#define MM_UTIL_IMGP_FANOUT_BAND_BYTES (256 * 1024) /* bytes of the source of a band of mm_imgp_fanout, it stays in the cache while every output reads it */
+
+/* linked pipelines of mm_imgp(), the most recently used one is at the head */
+G_LOCK_DEFINE_STATIC(imgp_cache);
+static GQueue _mm_imgp_cache = G_QUEUE_INIT;
+static unsigned int _mm_imgp_cache_size = MM_UTIL_IMGP_CACHE_DEFAULT_SIZE;
+static imgp_cache_stats_s _mm_imgp_cache_stats;
+
+/* workers shared by every conversion split in stripes */
+G_LOCK_DEFINE_STATIC(imgp_stripe_pool);
+static GThreadPool* _mm_imgp_stripe_pool = NULL;
+
+/* per-stage timing, the stages of the call running on a thread are kept until the call returns */
+G_LOCK_DEFINE_STATIC(imgp_timing);
+static imgp_timing_s _mm_imgp_timing;
+static volatile gint _mm_imgp_timing_enabled = 0;
+static gchar* _mm_imgp_timing_file = NULL;
+static __thread unsigned long long _mm_imgp_timing_call[IMGP_STAGE_NUM];
+static __thread unsigned int _mm_imgp_timing_depth = 0;
+
+static const char* _mm_imgp_stage_names[IMGP_STAGE_NUM] = {
+	"format_setup", "pipeline_create", "link", "playing", "frame", "copy", "teardown", "native",
+};
+
+/* jobs of mm_imgp_async(), pending counts the queued and running ones */
+static GMutex _mm_imgp_async_lock;
+static GCond _mm_imgp_async_cond;
+static GThreadPool* _mm_imgp_async_pool = NULL;
+static unsigned int _mm_imgp_async_pending = 0;
+static __thread gboolean _mm_imgp_async_in_worker = FALSE; /* set while a thread of the pool runs a completed_cb, which must never wait for the pool */
 
 static gboolean
 _mm_on_sink_message  (GstBus * bus, GstMessage * message, gstreamer_s * pGstreamer_s)
@@ -150,18 +89,71 @@ _mm_on_sink_message  (GstBus * bus, GstMessage * message, gstreamer_s * pGstream
 }
 
 
+static const char* _mm_imgp_element_factory_names[IMGP_ELEMENT_NUM] = {
+	[IMGP_ELEMENT_APPSRC] = "appsrc",
+	[IMGP_ELEMENT_COLORSPACE] = "ffmpegcolorspace",
+	[IMGP_ELEMENT_VIDEOSCALE] = "videoscale",
+	[IMGP_ELEMENT_VIDEOFLIP] = "videoflip",
+	[IMGP_ELEMENT_APPSINK] = "appsink",
+};
+static GstElementFactory* _mm_imgp_element_factories[IMGP_ELEMENT_NUM];
+
+static int
+_mm_imgp_gst_init(void)
+{
+	static gsize _init = 0;
+	static int _ret = MM_ERROR_NONE;
+	GstPluginFeature* loaded = NULL;
+	GError* err = NULL;
+	unsigned int i = 0;
+
+	/* gstreamer is initialized and the plugins of the elements loaded by the first pipeline of the process only,
+	 * the registry is not looked up again for every element */
+	if(g_once_init_enter(&_init)) {
+		g_type_init();
+		if(!gst_init_check(NULL, NULL, &err)) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to initialize gstreamer: %s", __func__, __LINE__, err ? err->message : "");
+			g_clear_error(&err);
+			_ret = MM_ERROR_IMAGE_INTERNAL;
+		}
+		for(i = 0; _ret == MM_ERROR_NONE && i < IMGP_ELEMENT_NUM; i++) {
+			_mm_imgp_element_factories[i] = gst_element_factory_find(_mm_imgp_element_factory_names[i]);
+			if(_mm_imgp_element_factories[i] == NULL) {
+				mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] no factory of %s", __func__, __LINE__, _mm_imgp_element_factory_names[i]);
+				continue;
+			}
+			loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(_mm_imgp_element_factories[i]));
+			if(loaded != NULL) {
+				gst_object_unref(_mm_imgp_element_factories[i]);
+				_mm_imgp_element_factories[i] = GST_ELEMENT_FACTORY(loaded);
+			}
+		}
+		g_once_init_leave(&_init, 1);
+	}
+	return _ret;
+}
+
+static GstElement*
+_mm_imgp_element_make(imgp_element_e element, const gchar* name)
+{
+	if(_mm_imgp_element_factories[element] == NULL) {
+		return NULL;
+	}
+	return gst_element_factory_create(_mm_imgp_element_factories[element], name);
+}
+
 static int
 _mm_create_pipeline( gstreamer_s* pGstreamer_s)
 {
 	int ret = MM_ERROR_NONE;
 	pGstreamer_s->pipeline= gst_pipeline_new ("ffmpegcolorsapce");
-	pGstreamer_s->appsrc= gst_element_factory_make("appsrc","appsrc");
-	pGstreamer_s->colorspace=gst_element_factory_make("ffmpegcolorspace","colorconverter");
+	pGstreamer_s->appsrc = _mm_imgp_element_make(IMGP_ELEMENT_APPSRC, "appsrc");
+	pGstreamer_s->colorspace = _mm_imgp_element_make(IMGP_ELEMENT_COLORSPACE, "colorconverter");
 
-	pGstreamer_s->videoscale=gst_element_factory_make("videoscale", "scale");
-	pGstreamer_s->videoflip=gst_element_factory_make( "videoflip", "flip" );
+	pGstreamer_s->videoscale = _mm_imgp_element_make(IMGP_ELEMENT_VIDEOSCALE, "scale");
+	pGstreamer_s->videoflip = _mm_imgp_element_make(IMGP_ELEMENT_VIDEOFLIP, "flip");
 
-	pGstreamer_s->appsink=gst_element_factory_make("appsink","appsink");
+	pGstreamer_s->appsink = _mm_imgp_element_make(IMGP_ELEMENT_APPSINK, "appsink");
 
 	if (!pGstreamer_s->pipeline || !pGstreamer_s->appsrc||!pGstreamer_s->colorspace || !pGstreamer_s->appsink) {
 		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] One element could not be created. Exiting.\n", __func__, __LINE__);
@@ -195,87 +187,194 @@ _mm_check_rotate_format(int GstVideoFlipMethod)
 }
 
 static gboolean
-_mm_check_resize_format_label(char* __format_label)
+_mm_check_resize_format_label(const char* __format_label)
 {
-	gboolean _bool = FALSE;
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(__format_label);
 
-	if(strcmp(__format_label, "AYUV") == 0
-		|| strcmp(__format_label, "UYVY") == 0 ||strcmp(__format_label, "Y800") == 0 || strcmp(__format_label, "I420") == 0  || strcmp(__format_label, "YV12") == 0
-		|| strcmp(__format_label, "RGB888") == 0  || strcmp(__format_label, "RGB565") == 0 || strcmp(__format_label, "BGR888") == 0  || strcmp(__format_label, "RGBA8888") == 0
-		|| strcmp(__format_label, "ARGB8888") == 0 ||strcmp(__format_label, "BGRA8888") == 0 ||strcmp(__format_label, "ABGR8888") == 0 ||strcmp(__format_label, "RGBX") == 0
-		||strcmp(__format_label, "XRGB") == 0 ||strcmp(__format_label, "BGRX") == 0 ||strcmp(__format_label, "XBGR") == 0 ||strcmp(__format_label, "Y444") == 0
-		||strcmp(__format_label, "Y42B") == 0 ||strcmp(__format_label, "YUY2") == 0 ||strcmp(__format_label, "YUYV") == 0 ||strcmp(__format_label, "UYVY") == 0
-		||strcmp(__format_label, "Y41B") == 0 ||strcmp(__format_label, "Y16") == 0 ||strcmp(__format_label, "Y800") == 0 ||strcmp(__format_label, "Y8") == 0
-		||strcmp(__format_label, "GREY") == 0 ||strcmp(__format_label, "AY64") == 0 || strcmp(__format_label, "YUV422") == 0) {
+	return (desc != NULL && (desc->flags & IMGP_FORMAT_FLAG_RESIZE));
+}
 
-		_bool=TRUE;
-	}
+static gboolean
+_mm_check_rotate_format_label(const char* __format_label)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(__format_label);
 
-	return _bool;
+	return (desc != NULL && (desc->flags & IMGP_FORMAT_FLAG_ROTATE));
 }
 
+#define IMGP_PLAN_CSC IMGP_ELEMENT_COLORSPACE
+#define IMGP_PLAN_RSZ IMGP_ELEMENT_VIDEOSCALE
+#define IMGP_PLAN_ROT IMGP_ELEMENT_VIDEOFLIP
+
+/* every order of the elements a process may need, the first one of the lowest cost is linked */
+static const imgp_plan_s _mm_imgp_plans[] = {
+	{ "ffmpegcolorspace", { IMGP_PLAN_CSC }, 1 },
+	{ "videoscale ! ffmpegcolorspace", { IMGP_PLAN_RSZ, IMGP_PLAN_CSC }, 2 },
+	{ "ffmpegcolorspace ! videoscale", { IMGP_PLAN_CSC, IMGP_PLAN_RSZ }, 2 },
+	{ "videoflip ! ffmpegcolorspace", { IMGP_PLAN_ROT, IMGP_PLAN_CSC }, 2 },
+	{ "ffmpegcolorspace ! videoflip", { IMGP_PLAN_CSC, IMGP_PLAN_ROT }, 2 },
+	{ "videoscale ! videoflip ! ffmpegcolorspace", { IMGP_PLAN_RSZ, IMGP_PLAN_ROT, IMGP_PLAN_CSC }, 3 },
+	{ "videoflip ! videoscale ! ffmpegcolorspace", { IMGP_PLAN_ROT, IMGP_PLAN_RSZ, IMGP_PLAN_CSC }, 3 },
+	{ "videoscale ! ffmpegcolorspace ! videoflip", { IMGP_PLAN_RSZ, IMGP_PLAN_CSC, IMGP_PLAN_ROT }, 3 },
+	{ "videoflip ! ffmpegcolorspace ! videoscale", { IMGP_PLAN_ROT, IMGP_PLAN_CSC, IMGP_PLAN_RSZ }, 3 },
+	{ "ffmpegcolorspace ! videoscale ! videoflip", { IMGP_PLAN_CSC, IMGP_PLAN_RSZ, IMGP_PLAN_ROT }, 3 },
+	{ "ffmpegcolorspace ! videoflip ! videoscale", { IMGP_PLAN_CSC, IMGP_PLAN_ROT, IMGP_PLAN_RSZ }, 3 },
+};
+
 static gboolean
-_mm_check_rotate_format_label(const char* __format_label)
+_mm_imgp_plan_has(const imgp_plan_s* plan, imgp_element_e element)
 {
-	gboolean _bool = FALSE;
+	unsigned int i = 0;
 
-	if(strcmp(__format_label, "I420") == 0 ||strcmp(__format_label, "YV12") == 0 || strcmp(__format_label, "IYUV") 
-		|| strcmp(__format_label, "RGB888") ||strcmp(__format_label, "BGR888") == 0 ||strcmp(__format_label, "RGBA8888") == 0
-		|| strcmp(__format_label, "ARGB8888") == 0 ||strcmp(__format_label, "BGRA8888") == 0 ||strcmp(__format_label, "ABGR8888") == 0 ) {
-		_bool=TRUE;
+	for(i = 0; i < plan->count; i++) {
+		if(plan->element[i] == element) {
+			return TRUE;
+		}
 	}
-
-	return _bool;
+	return FALSE;
 }
 
-static void
-_mm_link_pipeline_order_csc_rsz(gstreamer_s* pGstreamer_s, image_format_s*  input_format, image_format_s* output_format)
-{
-	if(_mm_check_resize_format(input_format->width,input_format->height, output_format->width, output_format->height)) 	{
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] check_for_resize", __func__, __LINE__);
-		gst_bin_add_many(GST_BIN(pGstreamer_s->pipeline), pGstreamer_s->appsrc, pGstreamer_s->videoscale, pGstreamer_s->colorspace, pGstreamer_s->appsink,  NULL);
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] gst_bin_add_many", __func__, __LINE__);
-		if(_mm_check_resize_format_label( input_format->format_label)) {
-			mmf_debug(MMF_DEBUG_LOG, "[%s][%05d]  input_format->format_label: %s", __func__, __LINE__,  input_format->format_label);
-			if(!gst_element_link_many(pGstreamer_s->appsrc, pGstreamer_s->videoscale,  pGstreamer_s->colorspace,  pGstreamer_s->appsink, NULL)) {
-				mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Fail to link b/w ffmpeg and appsink except rot\n", __func__, __LINE__);
+/* bytes read and written by the elements of the plan, G_MAXUINT64 when an element would get a format it does not handle.
+ * ffmpegcolorspace works in passthrough between the same formats */
+static guint64
+_mm_imgp_plan_cost(const imgp_plan_s* plan, const imgp_format_desc_s* src_desc, const imgp_format_desc_s* dst_desc,
+	unsigned int width, unsigned int height, unsigned int dst_width, unsigned int dst_height, int angle)
+{
+	const imgp_format_desc_s* desc = src_desc;
+	gboolean transposed = (angle == MM_UTIL_ROTATE_90 || angle == MM_UTIL_ROTATE_270);
+	gboolean flipped = FALSE;
+	unsigned int out_width = 0, out_height = 0;
+	guint64 bytes = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < plan->count; i++) {
+		out_width = width;
+		out_height = height;
+		if(plan->element[i] == IMGP_PLAN_CSC) {
+			if(src_desc != dst_desc) {
+				bytes += (guint64) _mm_format_get_size(src_desc, width, height) + _mm_format_get_size(dst_desc, width, height);
 			}
-		}else if(_mm_check_resize_format_label(output_format->format_label)) {
-			mmf_debug(MMF_DEBUG_LOG, "[%s][%05d]  output_format->format_label: %s", __func__, __LINE__,  output_format->format_label);
-			if(!gst_element_link_many(pGstreamer_s->appsrc,  pGstreamer_s->colorspace, pGstreamer_s->videoscale, pGstreamer_s->appsink, NULL)) {
-				mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Fail to link b/w ffmpeg and appsink except rot\n", __func__, __LINE__);
+			desc = dst_desc;
+			continue;
+		}
+		if(plan->element[i] == IMGP_PLAN_RSZ) {
+			if(!(desc->flags & IMGP_FORMAT_FLAG_RESIZE)) {
+				return G_MAXUINT64;
+			}
+			/* the size of dst, before the rotation when it is still to come */
+			out_width = (transposed && !flipped) ? dst_height : dst_width;
+			out_height = (transposed && !flipped) ? dst_width : dst_height;
+		}else {
+			if(!(desc->flags & IMGP_FORMAT_FLAG_ROTATE)) {
+				return G_MAXUINT64;
 			}
+			flipped = TRUE;
+			out_width = transposed ? height : width;
+			out_height = transposed ? width : height;
 		}
+		bytes += (guint64) _mm_format_get_size(desc, width, height) + _mm_format_get_size(desc, out_width, out_height);
+		width = out_width;
+		height = out_height;
+	}
+	return bytes;
+}
+
+/* the order of the elements which reads and writes the fewest bytes, NULL when there is none for the formats */
+static const imgp_plan_s*
+_mm_imgp_plan_select(const char* input_format_label, unsigned int width, unsigned int height,
+	const char* output_format_label, unsigned int dst_width, unsigned int dst_height, int angle, guint64* bytes)
+{
+	const imgp_format_desc_s* src_desc = _mm_format_get_desc_by_label(input_format_label);
+	const imgp_format_desc_s* dst_desc = _mm_format_get_desc_by_label(output_format_label);
+	const imgp_plan_s* plan = NULL;
+	gboolean resize = FALSE;
+	gboolean rotate = _mm_check_rotate_format(angle);
+	guint64 cost = 0;
+	unsigned int i = 0;
+
+	*bytes = G_MAXUINT64;
+	if(src_desc == NULL || dst_desc == NULL) {
+		return NULL;
+	}
+	if(angle == MM_UTIL_ROTATE_90 || angle == MM_UTIL_ROTATE_270) {
+		resize = _mm_check_resize_format(width, height, dst_height, dst_width);
 	}else {
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] check_for_convert", __func__, __LINE__);
-		gst_bin_add_many(GST_BIN(pGstreamer_s->pipeline), pGstreamer_s->appsrc, pGstreamer_s->colorspace, pGstreamer_s->appsink,  NULL);
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] gst_bin_add_many", __func__, __LINE__);
-		if(!gst_element_link_many(pGstreamer_s->appsrc,  pGstreamer_s->colorspace, pGstreamer_s->appsink, NULL)) {
-			mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Fail to link b/w ffmpeg and appsink except rsz & rot\n", __func__, __LINE__);
+		resize = _mm_check_resize_format(width, height, dst_width, dst_height);
+	}
+
+	for(i = 0; i < G_N_ELEMENTS(_mm_imgp_plans); i++) {
+		if(_mm_imgp_plan_has(&_mm_imgp_plans[i], IMGP_PLAN_RSZ) != resize || _mm_imgp_plan_has(&_mm_imgp_plans[i], IMGP_PLAN_ROT) != rotate) {
+			continue;
 		}
+		cost = _mm_imgp_plan_cost(&_mm_imgp_plans[i], src_desc, dst_desc, width, height, dst_width, dst_height, angle);
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s %ux%u -> %s %ux%u angle: %d: %s costs %" G_GUINT64_FORMAT " bytes", __func__, __LINE__,
+			input_format_label, width, height, output_format_label, dst_width, dst_height, angle, _mm_imgp_plans[i].name, cost);
+		if(cost < *bytes) {
+			plan = &_mm_imgp_plans[i];
+			*bytes = cost;
+		}
+	}
+	return plan;
+}
+
+static GstElement*
+_mm_imgp_plan_element(gstreamer_s* pGstreamer_s, imgp_element_e element)
+{
+	switch(element) {
+		case IMGP_ELEMENT_APPSRC:
+			return pGstreamer_s->appsrc;
+		case IMGP_ELEMENT_COLORSPACE:
+			return pGstreamer_s->colorspace;
+		case IMGP_ELEMENT_VIDEOSCALE:
+			return pGstreamer_s->videoscale;
+		case IMGP_ELEMENT_VIDEOFLIP:
+			return pGstreamer_s->videoflip;
+		default:
+			return pGstreamer_s->appsink;
 	}
 }
 
 static void
-_mm_link_pipeline_order_csc_rsz_rot(gstreamer_s* pGstreamer_s, image_format_s*  input_format, image_format_s* output_format)
+_mm_link_pipeline_plan(gstreamer_s* pGstreamer_s, const imgp_plan_s* plan)
 {
-	if(_mm_check_rotate_format_label(input_format->format_label)) {
-		gst_bin_add_many(GST_BIN(pGstreamer_s->pipeline), pGstreamer_s->appsrc,  pGstreamer_s->videoscale, pGstreamer_s->videoflip, pGstreamer_s->colorspace, pGstreamer_s->appsink,  NULL);
-		if(!gst_element_link_many(pGstreamer_s->appsrc, pGstreamer_s->videoscale,  pGstreamer_s->videoflip,  pGstreamer_s->colorspace,  pGstreamer_s->appsink, NULL)) 	{
-			mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Fail to link b/w appsrc and ffmpeg in rotate\n", __func__, __LINE__);
-		}
-	}else if(_mm_check_rotate_format_label(output_format->format_label)) {
-		gst_bin_add_many(GST_BIN(pGstreamer_s->pipeline), pGstreamer_s->appsrc,  pGstreamer_s->colorspace, pGstreamer_s->videoscale,  pGstreamer_s->videoflip,pGstreamer_s->appsink,  NULL);
-		if(!gst_element_link_many(pGstreamer_s->appsrc,  pGstreamer_s->colorspace,  pGstreamer_s->videoscale, pGstreamer_s->videoflip, pGstreamer_s->appsink, NULL)) {
-			mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d]] Fail to link b/w ffmpeg and appsink in rotate\n", __func__, __LINE__);
+	GstElement* previous = pGstreamer_s->appsrc;
+	GstElement* element = NULL;
+	unsigned int i = 0;
+
+	gst_bin_add(GST_BIN(pGstreamer_s->pipeline), pGstreamer_s->appsrc);
+	for(i = 0; i <= plan->count; i++) {
+		element = (i < plan->count) ? _mm_imgp_plan_element(pGstreamer_s, plan->element[i]) : pGstreamer_s->appsink;
+		gst_bin_add(GST_BIN(pGstreamer_s->pipeline), element);
+		if(!gst_element_link(previous, element)) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] Fail to link b/w %s and %s of %s", __func__, __LINE__,
+				GST_ELEMENT_NAME(previous), GST_ELEMENT_NAME(element), plan->name);
 		}
+		previous = element;
 	}
 }
 
 
+static int
+_mm_get_videoscale_method(mm_util_img_resize_filter_e filter)
+{
+	/* GstVideoScaleMethod (0): nearest (1): bilinear (2): 4-tap */
+	switch(filter) {
+		case MM_UTIL_RESIZE_FILTER_NEAREST:
+			return 0;
+		case MM_UTIL_RESIZE_FILTER_BICUBIC:
+		case MM_UTIL_RESIZE_FILTER_LANCZOS:
+			return 2;
+		default:
+			return 1;
+	}
+}
+
 static void
 _mm_link_pipeline( gstreamer_s* pGstreamer_s, image_format_s* input_format, image_format_s* output_format, int _valuepGstreamer_sVideoFlipMethod)
 {
+	const imgp_plan_s* plan = NULL;
+	guint64 bytes = 0;
+
 	/* set property */
 	gst_app_src_set_caps(GST_APP_SRC(pGstreamer_s->appsrc), input_format->caps); //g_object_set(pGstreamer_s->appsrc, "caps", input_format->caps, NULL);  //  you can use appsrc'cap property
 	g_object_set(pGstreamer_s->appsrc, "num-buffers", 1, NULL);
@@ -289,18 +388,15 @@ _mm_link_pipeline( gstreamer_s* pGstreamer_s, image_format_s* input_format, imag
 	g_object_set(pGstreamer_s->appsink,  "drop", TRUE, NULL);
 	g_object_set(pGstreamer_s->appsink, "emit-signals", TRUE, "sync", FALSE, NULL);
 
-	if(_mm_check_rotate_format(_valuepGstreamer_sVideoFlipMethod)) { // when you want to rotate image
-		/*  because IYUV, I420, YV12 format can use vidoeflip*/
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d]  set_link_pipeline_order_csc_rsz_rot", __func__, __LINE__);
-		_mm_link_pipeline_order_csc_rsz_rot(pGstreamer_s,  input_format, output_format);
-	}else {
-		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d]  set_link_pipeline_order_csc_rsz", __func__, __LINE__);
-		_mm_link_pipeline_order_csc_rsz(pGstreamer_s, input_format,  output_format);
+	/* videoscale and videoflip go on the side of ffmpegcolorspace where they handle the format and touch the fewest bytes */
+	plan = _mm_imgp_plan_select(input_format->format_label, input_format->width, input_format->height,
+		output_format->format_label, output_format->width, output_format->height, _valuepGstreamer_sVideoFlipMethod, &bytes);
+	if(plan == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] no order of the elements handles %s -> %s", __func__, __LINE__, input_format->format_label, output_format->format_label);
+		plan = &_mm_imgp_plans[0];
 	}
-	/* Conecting to the new-buffer signal emited by the appsink*/ 
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start  G_CALLBACK (mm_sink_buffer)", __func__, __LINE__);
-	g_signal_connect (pGstreamer_s->appsink, "new-buffer",  G_CALLBACK (_mm_sink_buffer), pGstreamer_s);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End  G_CALLBACK (mm_sink_buffer)", __func__, __LINE__);
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] appsrc ! %s ! appsink: %" G_GUINT64_FORMAT " bytes", __func__, __LINE__, plan->name, bytes);
+	_mm_link_pipeline_plan(pGstreamer_s, plan);
 }
 
 
@@ -308,89 +404,54 @@ _mm_link_pipeline( gstreamer_s* pGstreamer_s, image_format_s* input_format, imag
 static void
 _mm_set_image_format_s_capabilities(image_format_s* __format)//_format_label: I420 _colorsapace: YUV
 {
-	char _a='A', _b='A', _c='A', _d='A';
-	int _bpp=0; int _depth=0; int _red_mask=0; int _green_mask=0; int  _blue_mask=0; int _alpha_mask=0; int _endianness=0;
+	const imgp_format_desc_s* desc = NULL;
 
 	if(__format == NULL) {
 		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Image format is NULL\n", __func__, __LINE__);
+		return;
 	}
 	__format->caps = NULL;
+	desc = __format->desc;
 
 	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] colorspace: %s\n", __func__, __LINE__, __format->colorspace);
 
-	if(strcmp(__format->colorspace,"YUV") == 0) {
-		if(strcmp(__format->format_label,"I420") == 0) {
-			_a='I'; _b='4', _c='2', _d='0';
-		}else if(strcmp(__format->format_label,"Y42B") == 0) {
-			_a='Y'; _b='4', _c='2', _d='B';
-		}else if(strcmp(__format->format_label,"Y444") == 0) {
-			_a='Y'; _b='4', _c='4', _d='4';
-		}else if(strcmp(__format->format_label,"YV12") == 0) {
-			_a='Y'; _b='V', _c='1', _d='2'; //GStreamer-CRITICAL **: gst_mini_object_ref: assertion `mini_object != NULL' failed
-		}else if(strcmp(__format->format_label,"NV12") == 0) {
-			_a='N'; _b='V', _c='1', _d='2';
-		}else if(strcmp(__format->format_label,"UYVY") == 0) {
-			_a='U'; _b='Y', _c='V', _d='Y';
-		}else if(strcmp(__format->format_label,"YUYV") == 0) {
-			_a='Y'; _b='U', _c='Y', _d='2';
-		}
-
+	if(desc == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] ***Wrong format cs type***\n", __func__, __LINE__);
+	}else if(desc->fourcc) {
 		__format->caps =  gst_caps_new_simple ("video/x-raw-yuv",
-			"format", GST_TYPE_FOURCC, GST_MAKE_FOURCC (_a, _b, _c, _d), //'I', '4', '2', '0'),
+			"format", GST_TYPE_FOURCC, desc->fourcc,
 			"framerate", GST_TYPE_FRACTION, 25, 1,
 			"pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
 			"width", G_TYPE_INT, __format->width,
 			"height", G_TYPE_INT, __format->height,
 			"framerate", GST_TYPE_FRACTION, 1, 1,
 			NULL);
-	}
-
-	else if(strcmp(__format->colorspace,"RGB") ==0 || strcmp(__format->colorspace,"BGRX") ==0) {
-		if(strcmp(__format->format_label,"RGB888") == 0) {
-			_bpp=24; _depth=24;  _red_mask=16711680; _green_mask=65280; _blue_mask=255; _endianness=4321;
-		}else if(strcmp(__format->format_label,"BGR888") == 0) {
-			_bpp=24; _depth=24;  _red_mask=255; _green_mask=65280; _blue_mask=16711680; _endianness=4321;
-		}else if(strcmp(__format->format_label,"RGB565") == 0) {
-			_bpp=16; _depth=16;  _red_mask=63488; _green_mask=2016; _blue_mask=31; _endianness=1234;
-		}else if( (strcmp(__format->format_label, "BGRX") == 0)) {
-			_bpp=32; _depth=24;  _red_mask=65280; _green_mask=16711680; _blue_mask=-16777216; _endianness=4321;
+		/* the default BT.601 keeps the caps without colorimetry, 0.10 caps only name the HD matrix besides it and have no range */
+		if(__format->color_matrix == MM_UTIL_COLOR_MATRIX_BT709) {
+			gst_caps_set_simple(__format->caps, "color-matrix", G_TYPE_STRING, "hdtv", NULL);
 		}
-		__format->caps  =  gst_caps_new_simple ("video/x-raw-rgb",
-			"bpp", G_TYPE_INT, _bpp,
-			"depth", G_TYPE_INT, _depth,
-			"red_mask", G_TYPE_INT, _red_mask,
-			"green_mask", G_TYPE_INT, _green_mask,
-			"blue_mask", G_TYPE_INT, _blue_mask,
+	}else if(desc->alpha_mask) {
+		__format->caps =  gst_caps_new_simple ("video/x-raw-rgb",
+			"bpp", G_TYPE_INT, desc->bpp,
+			"depth", G_TYPE_INT, desc->depth,
+			"red_mask", G_TYPE_INT, desc->red_mask,
+			"green_mask", G_TYPE_INT, desc->green_mask,
+			"blue_mask", G_TYPE_INT, desc->blue_mask,
 			"width", G_TYPE_INT, __format->width,
 			"height", G_TYPE_INT, __format->height,
-			"endianness", G_TYPE_INT, _endianness,
+			"alpha_mask", G_TYPE_INT, desc->alpha_mask,
+			"endianness", G_TYPE_INT, desc->endianness,
 			"framerate", GST_TYPE_FRACTION, 1, 1, NULL);
-	}
-
-	else if(strcmp(__format->colorspace,"RGBA") ==0)
-	{
-		if(strcmp(__format->format_label,"ARGB8888") == 0) { /*[Low Arrary Address] ARGBARGB... [High Array Address]*/
-			_bpp=32; _depth=32;  _red_mask=16711680; _green_mask=65280; _blue_mask=255; _alpha_mask=-16777216; _endianness=4321;
-		}else if(strcmp(__format->format_label,"BGRA8888") == 0) { /*[Low Arrary Address] BGRABGRA...[High Array Address]*/
-		_bpp=32; _depth=32;  _red_mask=65280; _green_mask=16711680; _blue_mask=-16777216; _alpha_mask=255; _endianness=4321;
-		}else if(strcmp(__format->format_label,"RGBA8888") == 0) { /*[Low Arrary Address] RGBARGBA...[High Array Address]*/
-			_bpp=32; _depth=32;  _red_mask=-16777216; _green_mask=16711680; _blue_mask=65280; _alpha_mask=255; _endianness=4321;
-		}else if(strcmp(__format->format_label,"ABGR8888") == 0) { /*[Low Arrary Address] ABGRABGR...[High Array Address]*/
-		_bpp=32; _depth=32;  _red_mask=255; _green_mask=65280; _blue_mask=16711680; _alpha_mask=-16777216; _endianness=4321;
-		}else {
-			mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] ***Wrong format cs type***\n", __func__, __LINE__);
-		}
-
-		__format->caps =  gst_caps_new_simple ("video/x-raw-rgb",
-			"bpp", G_TYPE_INT, _bpp,
-			"depth", G_TYPE_INT, _depth,
-			"red_mask", G_TYPE_INT, _red_mask,
-			"green_mask", G_TYPE_INT, _green_mask,
-			"blue_mask", G_TYPE_INT, _blue_mask,
+	}else if(desc->bpp) {
+		__format->caps  =  gst_caps_new_simple ("video/x-raw-rgb",
+			"bpp", G_TYPE_INT, desc->bpp,
+			"depth", G_TYPE_INT, desc->depth,
+			"red_mask", G_TYPE_INT, desc->red_mask,
+			"green_mask", G_TYPE_INT, desc->green_mask,
+			"blue_mask", G_TYPE_INT, desc->blue_mask,
 			"width", G_TYPE_INT, __format->width,
 			"height", G_TYPE_INT, __format->height,
-			"alpha_mask", G_TYPE_INT,_alpha_mask,
-			"endianness", G_TYPE_INT, _endianness,
+			"endianness", G_TYPE_INT, desc->endianness,
 			"framerate", GST_TYPE_FRACTION, 1, 1, NULL);
 	}
 	if(__format->caps) {
@@ -404,33 +465,49 @@ static void
 _mm_set_image_colorspace( image_format_s* __format)
 {
 	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] format_label: %s\n", __func__, __LINE__, __format->format_label);
-	if( (strcmp(__format->format_label, "I420") == 0) ||(strcmp(__format->format_label, "Y42B") == 0) || (strcmp(__format->format_label, "Y444") == 0)
-		|| (strcmp(__format->format_label, "YV12") == 0) ||(strcmp(__format->format_label, "NV12") == 0)  ||(strcmp(__format->format_label, "UYVY") == 0) ||(strcmp(__format->format_label, "YUYV") == 0)) {
-		strncpy(__format->colorspace, "YUV", sizeof(__format->colorspace));
-	}else if( (strcmp(__format->format_label, "RGB888") == 0) ||(strcmp(__format->format_label, "BGR888") == 0) ||(strcmp(__format->format_label, "RGB565") == 0)) {
-		strncpy(__format->colorspace, "RGB", sizeof(__format->colorspace));
-	}else if( (strcmp(__format->format_label, "ARGB8888") == 0)  || (strcmp(__format->format_label, "BGRA8888") == 0) 	||(strcmp(__format->format_label, "RGBA8888") == 0)	|| (strcmp(__format->format_label, "ABGR8888") == 0)) {
-		strncpy(__format->colorspace, "RGBA", sizeof(__format->colorspace));
-	}else if( (strcmp(__format->format_label, "BGRX") == 0)) {
-		strncpy(__format->colorspace, "BGRX", sizeof(__format->colorspace));
+	__format->desc = _mm_format_get_desc_by_label(__format->format_label);
+	if(__format->desc) {
+		strncpy(__format->colorspace, __format->desc->colorspace, sizeof(__format->colorspace));
 	}else {
+		__format->colorspace[0] = '\0';
 		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] Check your colorspace format label", __func__, __LINE__);
 	}
 }
 
+static void
+_mm_round_up_output_image_widh_height(image_format_s* pFormat)
+{
+	if(strcmp(pFormat->colorspace,"YUV") ==0) {
+		pFormat->stride=MM_UTIL_ROUND_UP_8(pFormat->width);
+		pFormat->elevation=MM_UTIL_ROUND_UP_8(pFormat->height);
+	}else if(strcmp(pFormat->colorspace, "RGB") ==0) {
+		pFormat->stride=MM_UTIL_ROUND_UP_4(pFormat->width);
+		pFormat->elevation=MM_UTIL_ROUND_UP_2(pFormat->height);
+	}else {
+		pFormat->stride=pFormat->width;
+		pFormat->elevation=pFormat->height;
+	}
+}
+
 static image_format_s*
 _mm_set_input_image_format_s_struct(imgp_info_s* pImgp_info) //char* __format_label, int __width, int __height)
 {
 	image_format_s* __format = NULL;
 
-	__format=(image_format_s*)malloc(sizeof(image_format_s));
-	memset(__format->format_label, 0, IMAGE_FORMAT_LABEL_BUFFER_SIZE);
-	strncpy(__format->format_label, pImgp_info->input_format_label, sizeof(__format->format_label));
+	/* the caps of a pipeline of the same format and size are reused */
+	__format = _mm_imgp_pool_format_take(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->color_matrix);
+	if(__format) {
+		return __format;
+	}
+	__format=(image_format_s*)calloc(1, sizeof(image_format_s));
+	strncpy(__format->format_label, pImgp_info->input_format_label, sizeof(__format->format_label) - 1);
 	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] input_format_label: %s\n", __func__, __LINE__, pImgp_info->input_format_label);
 	_mm_set_image_colorspace(__format);
 
 	__format->width=pImgp_info->src_width;
 	__format->height=pImgp_info->src_height;
+	__format->color_matrix = pImgp_info->color_matrix;
+	_mm_round_up_output_image_widh_height(__format);
 
 	__format->blocksize = mm_setup_image_size(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height);
 	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] input_format_label: %s\n", __func__, __LINE__, pImgp_info->input_format_label);
@@ -440,15 +517,19 @@ _mm_set_input_image_format_s_struct(imgp_info_s* pImgp_info) //char* __format_la
 }
 
 static void
-_mm_round_up_output_image_widh_height(image_format_s* pFormat)
+_mm_set_output_stride_elevation(imgp_info_s* pImgp_info)
 {
-	if(strcmp(pFormat->colorspace,"YUV") ==0) {
-		pFormat->stride=MM_UTIL_ROUND_UP_8(pFormat->width);
-		pFormat->elevation=MM_UTIL_ROUND_UP_8(pFormat->height);
-	}else if(strcmp(pFormat->colorspace, "RGB") ==0) {
-		pFormat->stride=MM_UTIL_ROUND_UP_4(pFormat->width);
-		pFormat->elevation=MM_UTIL_ROUND_UP_2(pFormat->height);
-	}
+	image_format_s _format;
+
+	memset(&_format, 0, sizeof(image_format_s));
+	strncpy(_format.format_label, pImgp_info->output_format_label, sizeof(_format.format_label) - 1);
+	_mm_set_image_colorspace(&_format);
+	_format.width = pImgp_info->dst_width;
+	_format.height = pImgp_info->dst_height;
+	_mm_round_up_output_image_widh_height(&_format);
+
+	pImgp_info->output_stride = _format.stride;
+	pImgp_info->output_elevation = _format.elevation;
 }
 
 static image_format_s*
@@ -456,13 +537,17 @@ _mm_set_output_image_format_s_struct(imgp_info_s* pImgp_info)
 {
 	image_format_s* __format = NULL;
 
-	__format=(image_format_s*)malloc(sizeof(image_format_s));
-	memset(__format->format_label, 0, IMAGE_FORMAT_LABEL_BUFFER_SIZE);
-	strncpy(__format->format_label, pImgp_info->output_format_label, sizeof(__format->format_label));
+	__format = _mm_imgp_pool_format_take(pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height, pImgp_info->color_matrix);
+	if(__format) {
+		return __format;
+	}
+	__format=(image_format_s*)calloc(1, sizeof(image_format_s));
+	strncpy(__format->format_label, pImgp_info->output_format_label, sizeof(__format->format_label) - 1);
 	_mm_set_image_colorspace(__format);
 
 	__format->width=pImgp_info->dst_width;
 	__format->height=pImgp_info->dst_height;
+	__format->color_matrix = pImgp_info->color_matrix;
 	_mm_round_up_output_image_widh_height(__format);
 
 	__format->blocksize = mm_setup_image_size(pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height);
@@ -503,259 +588,2384 @@ __mm_check_rotate_format(int angle, const char* input_format_label, const char*
 }
 
 static int
-_mm_push_buffer_into_pipeline(imgp_info_s* pImgp_info, gstreamer_s * pGstreamer_s, GstCaps*_caps)
+mm_setup_image_size(const char* _format_label, int width, int height)
 {
-	int ret = MM_ERROR_NONE;
-	if(_caps==NULL) {
-		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] caps is NULL\n", __func__, __LINE__);
-		return MM_ERROR_IMAGE_INVALID_VALUE;
-	}
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(_format_label);
+	int size=0;
 
-	if(pGstreamer_s->pipeline == NULL) {
-		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] pipeline is NULL\n", __func__, __LINE__);
-		return MM_ERROR_IMAGE_INVALID_VALUE;
+	if(desc) {
+		size = _mm_format_get_size(desc, width, height);
 	}
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s file_size: %d\n", __func__, __LINE__, _format_label, size);
+	return size;
+}
 
-	GstBuffer* gst_buf = (GstBuffer *) gst_mini_object_new (GST_TYPE_BUFFER);
-
-	if(gst_buf==NULL) 	{
-		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] buffer is NULL\n", __func__, __LINE__);
-		return MM_ERROR_IMAGE_INVALID_VALUE;
-	}
-	GST_BUFFER_DATA (gst_buf) = (guint8 *) pImgp_info->src;
-	GST_BUFFER_SIZE (gst_buf) = mm_setup_image_size(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height);
-	GST_BUFFER_FLAG_SET (gst_buf, GST_BUFFER_FLAG_READONLY);
+static mm_util_img_format_e
+_mm_get_native_format(const char* __format_label)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(__format_label);
 
-	gst_buffer_set_caps (gst_buf, _caps);
-	gst_app_src_push_buffer (GST_APP_SRC (pGstreamer_s->appsrc), gst_buf); //push buffer to pipeline
-	g_free(GST_BUFFER_MALLOCDATA(gst_buf)); gst_buf = NULL; //gst_buffer_finalize(gst_buf) { buffer->free_func (buffer->malloc_data); }
-	return ret;
+	return desc ? desc->format : MM_UTIL_IMG_FMT_NUM;
 }
 
+static gboolean
+_mm_imgp_has_src(imgp_info_s* pImgp_info)
+{
+	return pImgp_info->src != NULL || pImgp_info->src_planes[0] != NULL;
+}
 
 static int
-_mm_imgp_gstcs_processing( gstreamer_s* pGstreamer_s, image_format_s* input_format, image_format_s* output_format, imgp_info_s* pImgp_info)
+_mm_imgp_src_frame_init(imgp_frame_s* frame, imgp_info_s* pImgp_info)
 {
-	GstBus *bus = NULL;
-	GstStateChangeReturn ret_state;
 	int ret = MM_ERROR_NONE;
-	/*create pipeline*/
-	ret =  _mm_create_pipeline(pGstreamer_s);
-	if(ret != MM_ERROR_NONE) 	{
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR - mm_create_pipeline ", __func__, __LINE__);
-	}
-
 
-	/* Make appsink emit the "new-preroll" and "new-buffer" signals. This  option is by default disabled because  signal emission is expensive and unneeded when the application prefers  to operate in pull mode.   */
-	 gst_app_sink_set_emit_signals ((GstAppSink*)pGstreamer_s->appsink, TRUE);
-
-	bus = gst_pipeline_get_bus (GST_PIPELINE (pGstreamer_s->pipeline)); //GST_PIPELINE (pipeline));
-	gst_bus_add_watch (bus, (GstBusFunc) _mm_on_sink_message , pGstreamer_s); // thow to  appplicaton
-	gst_object_unref(bus);
-
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start mm_push_buffer_into_pipeline", __func__, __LINE__);
-	ret = _mm_push_buffer_into_pipeline(pImgp_info, pGstreamer_s, input_format->caps);
-	if(ret != MM_ERROR_NONE) 	{
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR - mm_push_buffer_into_pipeline ", __func__, __LINE__);
+	if(pImgp_info->src_planes[0] == NULL) {
+		return _mm_native_frame_init(frame, _mm_get_native_format(pImgp_info->input_format_label), pImgp_info->src_width, pImgp_info->src_height, pImgp_info->src);
 	}
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End mm_push_buffer_into_pipeline", __func__, __LINE__);
+	ret = _mm_native_frame_init(frame, _mm_get_native_format(pImgp_info->input_format_label), pImgp_info->src_width, pImgp_info->src_height, pImgp_info->src_planes[0]);
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_native_frame_set_planes(frame, pImgp_info->src_planes, pImgp_info->src_strides);
+	}
+	return ret;
+}
 
-	/*link pipeline*/
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start mm_link_pipeline", __func__, __LINE__);
-	_mm_link_pipeline( pGstreamer_s, input_format, output_format, pImgp_info->angle);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End mm_link_pipeline", __func__, __LINE__);
+static gboolean
+_mm_imgp_has_crop(imgp_info_s* pImgp_info)
+{
+	return pImgp_info->src_crop_width != 0 || pImgp_info->src_crop_height != 0;
+}
 
-	/* Conecting to the new-buffer signal emited by the appsink*/ 
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start  G_CALLBACK (_mm_sink_preroll)", __func__, __LINE__);
-	g_signal_connect (pGstreamer_s->appsink, "new-preroll",  G_CALLBACK (_mm_sink_preroll), pGstreamer_s);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End  G_CALLBACK (mm_sink_preroll)", __func__, __LINE__);
+/* pCrop is pImgp_info with the crop rectangle as the source: its planes start at the rectangle and keep the strides of the
+ * whole source, so the kernels and the copy into a pipeline only touch the rectangle. Without src, only the geometry is set */
+static int
+_mm_imgp_crop_source(imgp_info_s* pCrop, imgp_info_s* pImgp_info)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(pImgp_info->input_format_label);
+	imgp_frame_s frame;
+	unsigned int x_align = 1, y_align = 1;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int i = 0;
+	int ret = MM_ERROR_NONE;
 
-	/* GST_STATE_PLAYING*/
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start GST_STATE_PLAYING", __func__, __LINE__);
-	ret_state = gst_element_set_state (pGstreamer_s->pipeline, GST_STATE_PLAYING);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End GST_STATE_PLAYING ret_state: %d", __func__, __LINE__, ret_state);
-	ret_state = gst_element_get_state (pGstreamer_s->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Success Get GST_STATE_PLAYING ret_state: %d", __func__, __LINE__, ret_state);
-	#if 0
-	/* Conecting to the new-buffer signal emited by the appsink*/ 
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] Start  G_CALLBACK (mm_sink_buffer)", __func__, __LINE__);
-	g_signal_connect (pGstreamer_s->appsink, "new-buffer",  G_CALLBACK (_mm_sink_buffer), pGstreamer_s);
-	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End  G_CALLBACK (mm_sink_buffer)", __func__, __LINE__);
-	#endif
-	if(ret_state  == 1) 	{
-		mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] GST_STATE_PLAYING ret = %d( GST_STATE_CHANGE_SUCCESS)", __func__, __LINE__, ret_state);
-	}else if( ret_state == 2) {
-		mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] GST_STATE_PLAYING ret = %d( GST_STATE_CHANGE_ASYNC)", __func__, __LINE__, ret_state);
-	}
-
-	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] Sucess GST_STATE_CHANGE", __func__, __LINE__);
-
-	/* error */
-	if (ret_state == 0) 	{
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] GST_STATE_CHANGE_FAILURE", __func__, __LINE__);
+	memcpy(pCrop, pImgp_info, sizeof(imgp_info_s));
+	if(!_mm_imgp_has_crop(pImgp_info)) {
+		return MM_ERROR_NONE;
+	}
+	if(desc == NULL || desc->plane_count == 0 || (desc->flags & IMGP_FORMAT_FLAG_TILED)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s can not be cropped", __func__, __LINE__, pImgp_info->input_format_label);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	_mm_format_get_crop_align(desc, &x_align, &y_align);
+	if(pImgp_info->src_crop_width == 0 || pImgp_info->src_crop_height == 0
+		|| pImgp_info->src_crop_x > pImgp_info->src_width || pImgp_info->src_crop_width > pImgp_info->src_width - pImgp_info->src_crop_x
+		|| pImgp_info->src_crop_y > pImgp_info->src_height || pImgp_info->src_crop_height > pImgp_info->src_height - pImgp_info->src_crop_y
+		|| pImgp_info->src_crop_x % x_align != 0 || pImgp_info->src_crop_y % y_align != 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] crop %ux%u at (%u, %u) is out of the %ux%u source or not aligned to %ux%u for %s", __func__, __LINE__,
+			pImgp_info->src_crop_width, pImgp_info->src_crop_height, pImgp_info->src_crop_x, pImgp_info->src_crop_y,
+			pImgp_info->src_width, pImgp_info->src_height, x_align, y_align, pImgp_info->input_format_label);
 		return MM_ERROR_IMAGE_INVALID_VALUE;
-	}else {
-		#if 0
-			g_main_loop_run (pGstreamer_s->loop);
-		#endif
-		mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] Set GST_STATE_NULL", __func__, __LINE__);
+	}
+	pCrop->src_width = pImgp_info->src_crop_width;
+	pCrop->src_height = pImgp_info->src_crop_height;
+	pCrop->src_crop_x = 0;
+	pCrop->src_crop_y = 0;
+	pCrop->src_crop_width = 0;
+	pCrop->src_crop_height = 0;
+	if(!_mm_imgp_has_src(pImgp_info)) {
+		return MM_ERROR_NONE;
+	}
 
-		/*GST_STATE_NULL*/
-		gst_element_set_state (pGstreamer_s->pipeline, GST_STATE_NULL);
-		mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] End GST_STATE_NULL", __func__, __LINE__);
-		
-		mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] ###pGstreamer_s->output_buffer### : %p", __func__, __LINE__, pGstreamer_s->output_buffer);
+	ret = _mm_imgp_src_frame_init(&frame, pImgp_info);
+	if(ret != MM_ERROR_NONE) {
+		return ret;
+	}
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(frame.format, i, &elem, &x_shift, &y_shift);
+		pCrop->src_planes[i] = frame.data[i] + (gsize) (pImgp_info->src_crop_y >> y_shift) * frame.stride[i] + (pImgp_info->src_crop_x >> x_shift) * elem;
+		pCrop->src_strides[i] = frame.stride[i];
+	}
+	return MM_ERROR_NONE;
+}
 
-		ret_state = gst_element_get_state (pGstreamer_s->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+static gboolean
+_mm_imgp_has_dst_layout(imgp_info_s* pImgp_info)
+{
+	unsigned int i = 0;
 
-		if(ret_state  == 1) 	{
-			mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] GST_STATE_NULL ret_state = %d (GST_STATE_CHANGE_SUCCESS)\n", __func__, __LINE__, ret_state);
-		}else if( ret_state == 2) {
-			mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] GST_STATE_NULL ret_state = %d (GST_STATE_CHANGE_ASYNC)\n", __func__, __LINE__, ret_state);
+	for(i = 0; i < MM_UTIL_IMG_PLANE_MAX; i++) {
+		if(pImgp_info->dst_strides[i] != 0 || pImgp_info->dst_offsets[i] != 0) {
+			return TRUE;
 		}
+	}
+	return FALSE;
+}
 
-		mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] Success gst_element_get_state\n", __func__, __LINE__);
+static int
+_mm_imgp_dst_frame_init(imgp_frame_s* frame, imgp_info_s* pImgp_info)
+{
+	unsigned char* planes[MM_UTIL_IMG_PLANE_MAX] = { NULL, NULL, NULL };
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int offset = 0;
+	unsigned int i = 0;
+	int ret = MM_ERROR_NONE;
 
-		if (ret_state == 0) 	{
-			mmf_debug(MMF_DEBUG_ERROR, "GST_STATE_CHANGE_FAILURE");
-		}else {
-			if(pGstreamer_s->output_buffer != NULL) {
-				int buffer_size = GST_BUFFER_SIZE(pGstreamer_s->output_buffer);
-				mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] buffer size: %d\n", __func__, __LINE__, buffer_size);
-				if( buffer_size != mm_setup_image_size(pImgp_info->output_format_label, pImgp_info->output_stride, pImgp_info->output_elevation)) {
-					mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] Buffer size is different stride:%d elevation: %d\n", __func__, __LINE__, pImgp_info->output_stride, pImgp_info->output_elevation);
-				}
-				mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] pGstreamer_s->output_buffer: 0x%2x\n", __func__, __LINE__, pGstreamer_s->output_buffer);
-				memcpy( pImgp_info->dst, (char*)GST_BUFFER_DATA(pGstreamer_s->output_buffer), buffer_size);
-			}else {
-				mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] pGstreamer_s->output_buffer is NULL", __func__, __LINE__);
-			}
+	ret = _mm_native_frame_init(frame, _mm_get_native_format(pImgp_info->output_format_label), pImgp_info->dst_width, pImgp_info->dst_height, pImgp_info->dst);
+	if(ret != MM_ERROR_NONE || !_mm_imgp_has_dst_layout(pImgp_info)) {
+		return ret;
+	}
+	/* a plane without an offset follows the previous one */
+	for(i = 0; i < _mm_format_get_desc(frame->format)->plane_count; i++) {
+		if(i == 0 || pImgp_info->dst_offsets[i] != 0) {
+			offset = pImgp_info->dst_offsets[i];
 		}
-		gst_object_unref (pGstreamer_s->pipeline);
-		g_free(GST_BUFFER_MALLOCDATA(pGstreamer_s->output_buffer));
-		pGstreamer_s->output_buffer = NULL;
-		g_free (pGstreamer_s);
-
-		mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] End mm_convert_colorspace \n", __func__, __LINE__);
+		planes[i] = pImgp_info->dst + offset;
+		_mm_native_plane_layout(frame->format, i, &elem, &x_shift, &y_shift);
+		offset += (pImgp_info->dst_strides[i] ? pImgp_info->dst_strides[i] : frame->stride[i]) * ((frame->height + (1 << y_shift) - 1) >> y_shift);
 	}
-	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] pImgp_info->dst: %p", __func__, __LINE__, pImgp_info->dst);
-	return ret;
+	return _mm_native_frame_set_planes(frame, planes, pImgp_info->dst_strides);
 }
 
-
-static int
-mm_setup_image_size(const char* _format_label, int width, int height)
+static gboolean
+_mm_imgp_fused_enabled(void)
 {
-	int size=0;
-
-	if(strcmp(_format_label, "I420") == 0) {
-		setup_image_size_I420(width, height); //width * height *1.5;
-	}else if(strcmp(_format_label, "Y42B") == 0) {
-		setup_image_size_Y42B(width, height); //width * height *2;
-	}else if(strcmp(_format_label, "YUV422") == 0) {
-		setup_image_size_Y42B(width, height); //width * height *2;
-	}else if(strcmp(_format_label, "Y444") == 0) {
-		setup_image_size_Y444(width, height); //width * height *3;
-	}else if(strcmp(_format_label, "YV12") == 0) {
-		setup_image_size_YV12(width, height); //width * height *1;
-	}else if(strcmp(_format_label, "NV12") == 0) {
-		setup_image_size_NV12(width, height); //width * height *1.5;
-	}else if(strcmp(_format_label, "RGB565") == 0) {
-		setup_image_size_RGB565(width, height); //width * height *2;
-	}else if(strcmp(_format_label, "RGB888") == 0) {
-		setup_image_size_RGB888(width, height); //width * height *3;
-	}else if(strcmp(_format_label, "BGR888") == 0) {
-		setup_image_size_BGR888(width, height); //width * height *3;
-	}else if(strcmp(_format_label, "UYVY") == 0) {
-		setup_image_size_UYVY(width, height); //width * height *2;
-	}else if(strcmp(_format_label, "YUYV") == 0) {
-		setup_image_size_YUYV(width, height); //width * height *2;
-	}else if(strcmp(_format_label, "ARGB8888") == 0) {
-	size = width * height *4; mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] file_size: %d\n", __func__, __LINE__, size);
-	}else if(strcmp(_format_label, "BGRA8888") == 0) {
-		size = width * height *4; mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] file_size: %d\n", __func__, __LINE__, size);
-	}else if(strcmp(_format_label, "RGBA8888") == 0) {
-		size = width * height *4; mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] file_size: %d\n", __func__, __LINE__, size);
-	}else if(strcmp(_format_label, "ABGR8888") == 0) {
-		size = width * height *4; mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] file_size: %d\n", __func__, __LINE__, size);
-	}else if(strcmp(_format_label, "BGRX") == 0) {
-		size = width * height *4; mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] file_size: %d\n", __func__, __LINE__, size);
+	static gsize _init = 0;
+	static gboolean _enabled = TRUE;
+	const gchar* env = NULL;
+
+	/* MM_IMGP_FUSED=0 sends resize and rotation back to the videoscale / videoflip pipelines, to compare them */
+	if(g_once_init_enter(&_init)) {
+		env = g_getenv("MM_IMGP_FUSED");
+		if(env && atoi(env) == 0) {
+			_enabled = FALSE;
+		}
+		g_once_init_leave(&_init, 1);
 	}
+	return _enabled;
+}
 
-	return size;
+static gboolean
+_mm_imgp_tile_supported(const imgp_request_s* request)
+{
+	return !request->resize && request->angle == MM_UTIL_ROTATE_0 && _mm_native_tile_supported(request->src_format, request->dst_format);
 }
 
-static int
-_mm_imgp_gstcs(imgp_info_s* pImgp_info)
+static gboolean
+_mm_imgp_tile_simd(const imgp_request_s* request)
 {
-	image_format_s* input_format=NULL, *output_format=NULL;
-	gstreamer_s* pGstreamer_s;
-	int ret = MM_ERROR_NONE;
-	g_type_init();
-	if(pImgp_info == NULL) {
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] imgp_info_s is NULL", __func__, __LINE__);
-	}
+	/* the CbCr pairs of I420 are split / merged and the bands de-tiled to RGB converted by SIMD kernels, NV12 is only copied */
+	return request->src_format == MM_UTIL_IMG_FMT_I420 || request->dst_format == MM_UTIL_IMG_FMT_I420
+		|| (request->src_format == MM_UTIL_IMG_FMT_NV12_TILED && request->dst_format != MM_UTIL_IMG_FMT_NV12);
+}
 
-	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] [input] format label : %s width: %d height: %d\t[output] format label: %s width: %d height: %d rotation vaule: %d dst: 0x%2x", __func__, __LINE__,
-		pImgp_info->input_format_label,  pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label,  pImgp_info->dst_width, pImgp_info->dst_height, pImgp_info->angle, pImgp_info->dst);
+static gboolean
+_mm_imgp_csc_supported(const imgp_request_s* request)
+{
+	return !request->resize && request->angle == MM_UTIL_ROTATE_0 && _mm_native_csc_supported(request->src_format, request->dst_format);
+}
 
-	if(pImgp_info->dst == NULL) {
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] imgp_info_s->dst is NULL", __func__, __LINE__);
-	}
-	input_format= _mm_set_input_image_format_s_struct(pImgp_info);
-	output_format= _mm_set_output_image_format_s_struct(pImgp_info);
+static gboolean
+_mm_imgp_csc_simd(const imgp_request_s* request)
+{
+	/* only YUV -> RGB has SIMD rows */
+	return request->src_format == MM_UTIL_IMG_FMT_I420 || request->src_format == MM_UTIL_IMG_FMT_NV12;
+}
 
-	pImgp_info->output_stride = output_format->stride;
-	pImgp_info->output_elevation = output_format->elevation;
+static gboolean
+_mm_imgp_rotate_supported(const imgp_request_s* request)
+{
+	return !request->resize && request->src_format == request->dst_format && request->angle != MM_UTIL_ROTATE_0
+		&& _mm_native_rotate_supported(request->src_format, request->angle, request->src_width, request->src_height);
+}
 
-	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] mm_check_resize_format&&mm_check_rotate_format ", __func__, __LINE__);
+static gboolean
+_mm_imgp_resize_supported(const imgp_request_s* request)
+{
+	return request->resize && request->src_format == request->dst_format && request->angle == MM_UTIL_ROTATE_0
+		&& _mm_native_resize_supported(request->src_format, request->src_width, request->src_height, request->dst_width, request->dst_height);
+}
 
-	if(__mm_check_resize_format(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height)
-		&& __mm_check_rotate_format(pImgp_info->angle, pImgp_info->input_format_label, pImgp_info->output_format_label) ) {
-		#if 0 // def GST_EXT_TIME_ANALYSIS
-			MMTA_INIT();
-		#endif
-		gst_init (NULL, NULL);
+static gboolean
+_mm_imgp_fused_supported(const imgp_request_s* request)
+{
+	return _mm_imgp_fused_enabled() && (request->filter == MM_UTIL_RESIZE_FILTER_DEFAULT || request->filter == MM_UTIL_RESIZE_FILTER_BILINEAR
+		|| request->filter == MM_UTIL_RESIZE_FILTER_THUMBNAIL)
+		&& _mm_native_fused_supported(request->src_format, request->dst_format,
+		request->src_width, request->src_height, request->dst_width, request->dst_height);
+}
 
-		pGstreamer_s = g_new0 (gstreamer_s, 1);
+static gboolean
+_mm_imgp_simd_always(const imgp_request_s* request)
+{
+	return TRUE;
+}
 
-		#if 0 // def GST_EXT_TIME_ANALYSIS
-			 MMTA_ACUM_ITEM_BEGIN("ffmpegcolorspace", 0);
-		#endif
-		/* _format_label : I420, RGB888 etc*/
-		mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] Start mm_convert_colorspace ", __func__, __LINE__);
-		ret =_mm_imgp_gstcs_processing(pGstreamer_s, input_format, output_format, pImgp_info); //input: buffer pointer for input image , input  image format, input image width, input image height, output: buffer porinter for output image
+/* the native kernels convert the colorspace, rotate / flip or resize without a format change,
+ * or do all of resize, conversion and rotation in one bilinear pass, the rest goes through gstreamer.
+ * NV12 tiled has no caps, only the native kernels (de-)tile it */
+static const imgp_kernel_s _mm_imgp_kernels[] = {
+	{ "tile", _mm_imgp_tile_supported, _mm_imgp_tile_simd, _mm_native_tile_rows },
+	{ "csc", _mm_imgp_csc_supported, _mm_imgp_csc_simd, _mm_native_csc_rows },
+	{ "rotate", _mm_imgp_rotate_supported, _mm_imgp_simd_always, _mm_native_rotate_rows },
+	{ "resize", _mm_imgp_resize_supported, _mm_imgp_simd_always, _mm_native_resize_rows },
+	{ "fused", _mm_imgp_fused_supported, NULL, _mm_native_fused_rows },
+};
+
+/* ffmpegcolorspace converts between YUV and RGB with the BT.601 limited range matrix whatever the caps say */
+static gboolean
+_mm_imgp_pipeline_colorimetry_supported(imgp_info_s* pImgp_info)
+{
+	const imgp_format_desc_s* src_desc = _mm_format_get_desc_by_label(pImgp_info->input_format_label);
+	const imgp_format_desc_s* dst_desc = _mm_format_get_desc_by_label(pImgp_info->output_format_label);
 
-		if(ret == MM_ERROR_NONE) {
-			mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End mm_convert_colorspace [pImgp_info->dst: %p]", __func__, __LINE__, pImgp_info->dst);
-		}else if (ret != MM_ERROR_NONE) {
-			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR -mm_convert_colorspace", __func__, __LINE__);
-		}
-		#if 0 //def GST_EXT_TIME_ANALYSIS 
-			MMTA_ACUM_ITEM_END("ffmpegcolorspace", 0);
-			MMTA_ACUM_ITEM_SHOW_RESULT();
-			MMTA_ACUM_ITEM_SHOW_RESULT_TO(MMTA_SHOW_FILE);
-			MMTA_RELEASE ();
-		#endif
-	}else {
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] Error - Check your input / ouput image input_format_label: %s src_width: %d src_height: %d output_format_label: %s output_stride: %d output_elevation: %d  angle: %d ",__func__, __LINE__,
-		pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label, pImgp_info->output_stride, pImgp_info->output_elevation, pImgp_info->angle);
-		return MM_ERROR_IMAGE_INVALID_VALUE;
-	}
-	if(input_format) {
-		free(input_format); input_format = NULL;
+	if(_mm_native_get_coeffs(pImgp_info->color_matrix, pImgp_info->color_range) == NULL) {
+		return FALSE;
 	}
-	if(output_format) {
-		free(output_format); output_format  = NULL;
+	if(pImgp_info->color_matrix == MM_UTIL_COLOR_MATRIX_BT601 && pImgp_info->color_range == MM_UTIL_COLOR_RANGE_LIMITED) {
+		return TRUE;
 	}
-	return ret;
+	return src_desc != NULL && dst_desc != NULL && strcmp(src_desc->colorspace, dst_desc->colorspace) == 0;
 }
 
-int
-mm_imgp(imgp_info_s* pImgp_info, imgp_type_e _imgp_type)
+static gboolean
+_mm_imgp_pipeline_supported(imgp_info_s* pImgp_info)
 {
-	if (pImgp_info == NULL) {
-		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+	const imgp_format_desc_s* src_desc = _mm_format_get_desc_by_label(pImgp_info->input_format_label);
+	const imgp_format_desc_s* dst_desc = _mm_format_get_desc_by_label(pImgp_info->output_format_label);
+
+	/* formats without caps, e.g. NV12 tiled, can not be linked */
+	if(src_desc == NULL || dst_desc == NULL || !(src_desc->fourcc || src_desc->bpp) || !(dst_desc->fourcc || dst_desc->bpp)) {
+		return FALSE;
 	}
-	return _mm_imgp_gstcs(pImgp_info);
+	return __mm_check_resize_format(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height)
+		&& __mm_check_rotate_format(pImgp_info->angle, pImgp_info->input_format_label, pImgp_info->output_format_label)
+		&& _mm_imgp_pipeline_colorimetry_supported(pImgp_info);
+}
+
+static gboolean
+_mm_imgp_gstreamer_forced(void)
+{
+	static gsize _init = 0;
+	static gboolean _forced = FALSE;
+	const gchar* env = NULL;
+
+	/* MM_IMGP_TIER=gstreamer runs in a pipeline what a pipeline can do, to compare the native kernels with it.
+	 * The other values of it limit the instruction set of the native kernels */
+	if(g_once_init_enter(&_init)) {
+		env = g_getenv("MM_IMGP_TIER");
+		if(env && g_ascii_strcasecmp(env, "gstreamer") == 0) {
+			_forced = TRUE;
+		}
+		g_once_init_leave(&_init, 1);
+	}
+	return _forced;
+}
+
+static const imgp_kernel_s*
+_mm_imgp_kernel_select(imgp_info_s* pImgp_info, imgp_request_s* request)
+{
+	gboolean transposed = (pImgp_info->angle == MM_UTIL_ROTATE_90 || pImgp_info->angle == MM_UTIL_ROTATE_270);
+	unsigned int i = 0;
+
+	if(_mm_imgp_gstreamer_forced() && _mm_imgp_pipeline_supported(pImgp_info)) {
+		return NULL;
+	}
+	if(_mm_native_get_coeffs(pImgp_info->color_matrix, pImgp_info->color_range) == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] unknown color matrix %d or range %d", __func__, __LINE__, pImgp_info->color_matrix, pImgp_info->color_range);
+		return NULL;
+	}
+
+	request->src_format = _mm_get_native_format(pImgp_info->input_format_label);
+	request->dst_format = _mm_get_native_format(pImgp_info->output_format_label);
+	request->src_width = pImgp_info->src_width;
+	request->src_height = pImgp_info->src_height;
+	request->dst_width = pImgp_info->dst_width;
+	request->dst_height = pImgp_info->dst_height;
+	request->angle = pImgp_info->angle;
+	request->filter = pImgp_info->resize_filter;
+	/* the size of dst before the rotation */
+	if(transposed) {
+		request->resize = _mm_check_resize_format(pImgp_info->src_width, pImgp_info->src_height, pImgp_info->dst_height, pImgp_info->dst_width);
+	}else {
+		request->resize = _mm_check_resize_format(pImgp_info->src_width, pImgp_info->src_height, pImgp_info->dst_width, pImgp_info->dst_height);
+	}
+
+	for(i = 0; i < G_N_ELEMENTS(_mm_imgp_kernels); i++) {
+		if(_mm_imgp_kernels[i].supported(request)) {
+			return &_mm_imgp_kernels[i];
+		}
+	}
+	return NULL;
+}
+
+static imgp_native_stripe_f
+_mm_imgp_native_select(imgp_info_s* pImgp_info)
+{
+	imgp_request_s request;
+	const imgp_kernel_s* kernel = _mm_imgp_kernel_select(pImgp_info, &request);
+
+	return kernel ? kernel->func : NULL;
+}
+
+static void
+_mm_imgp_stripe_worker(gpointer data, gpointer user_data)
+{
+	imgp_stripe_s* pStripe = (imgp_stripe_s*) data;
+	imgp_stripes_s* pStripes = pStripe->stripes;
+	int ret = pStripes->func(pStripes->op, pStripe->y_start, pStripe->y_end);
+
+	g_mutex_lock(&pStripes->lock);
+	if(ret != MM_ERROR_NONE && pStripes->ret == MM_ERROR_NONE) {
+		pStripes->ret = ret;
+	}
+	pStripes->pending--;
+	if(pStripes->pending == 0) {
+		g_cond_signal(&pStripes->cond);
+	}
+	g_mutex_unlock(&pStripes->lock);
+}
+
+static GThreadPool*
+_mm_imgp_get_stripe_pool(void)
+{
+	GError* err = NULL;
+
+	G_LOCK(imgp_stripe_pool);
+	if(_mm_imgp_stripe_pool == NULL) {
+		_mm_imgp_stripe_pool = g_thread_pool_new(_mm_imgp_stripe_worker, NULL, MM_UTIL_IMGP_THREAD_MAX - 1, FALSE, &err);
+		if(_mm_imgp_stripe_pool == NULL) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to create the stripe pool: %s", __func__, __LINE__, err ? err->message : "");
+			g_clear_error(&err);
+		}
+	}
+	G_UNLOCK(imgp_stripe_pool);
+	return _mm_imgp_stripe_pool;
+}
+
+/* rows [y_start, y_end) of op->dst split in stripes of the worker pool */
+static int
+_mm_imgp_run_stripes_range(imgp_native_stripe_f func, const imgp_native_op_s* op, unsigned int y_start, unsigned int y_end, unsigned int thread_count)
+{
+	imgp_stripe_s stripe[MM_UTIL_IMGP_THREAD_MAX];
+	imgp_stripes_s stripes;
+	GThreadPool* pool = NULL;
+	unsigned int count = MIN(thread_count, MM_UTIL_IMGP_THREAD_MAX);
+	unsigned int rows = 0;
+	unsigned int i = 0;
+	int ret = MM_ERROR_NONE;
+
+	count = MIN(count, (y_end - y_start) / MM_UTIL_IMGP_STRIPE_MIN_ROWS);
+	if(count > 1) {
+		pool = _mm_imgp_get_stripe_pool();
+	}
+	if(pool == NULL) {
+		return func(op, y_start, y_end);
+	}
+
+	/* stripes start on even rows so that a 2x2 chroma block is never shared by two of them,
+	 * and tiled frames on a row of chroma tiles, 64 rows of the image, so that every tile is read or written by one of them */
+	rows = MM_UTIL_ROUND_UP_2((y_end - y_start + count - 1) / count);
+	if(func == _mm_native_tile_rows) {
+		rows = (rows + IMGP_NATIVE_TILE_HEIGHT * 2 - 1) / (IMGP_NATIVE_TILE_HEIGHT * 2) * (IMGP_NATIVE_TILE_HEIGHT * 2);
+	}
+	stripes.func = func;
+	stripes.op = op;
+	stripes.pending = 0;
+	stripes.ret = MM_ERROR_NONE;
+	g_mutex_init(&stripes.lock);
+	g_cond_init(&stripes.cond);
+
+	for(i = 0; i < count && i * rows < y_end - y_start; i++) {
+		stripe[i].stripes = &stripes;
+		stripe[i].y_start = y_start + i * rows;
+		stripe[i].y_end = MIN(y_start + (i + 1) * rows, y_end);
+	}
+	count = i;
+
+	/* the calling thread converts the first stripe while the workers take the others */
+	g_mutex_lock(&stripes.lock);
+	for(i = 1; i < count; i++) {
+		stripes.pending++;
+		g_thread_pool_push(pool, &stripe[i], NULL);
+	}
+	g_mutex_unlock(&stripes.lock);
+
+	ret = func(op, stripe[0].y_start, stripe[0].y_end);
+
+	g_mutex_lock(&stripes.lock);
+	while(stripes.pending > 0) {
+		g_cond_wait(&stripes.cond, &stripes.lock);
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = stripes.ret;
+	}
+	g_mutex_unlock(&stripes.lock);
+
+	g_cond_clear(&stripes.cond);
+	g_mutex_clear(&stripes.lock);
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %d rows in %d stripes ret: %d", __func__, __LINE__, y_end - y_start, count, ret);
+	return ret;
+}
+
+static int
+_mm_imgp_run_stripes(imgp_native_stripe_f func, const imgp_native_op_s* op, unsigned int thread_count)
+{
+	return _mm_imgp_run_stripes_range(func, op, 0, op->dst->height, thread_count);
+}
+
+static void
+_mm_imgp_timing_init(void)
+{
+	static gsize _init = 0;
+	const gchar* env = NULL;
+
+	if(g_once_init_enter(&_init)) {
+		env = g_getenv("MM_IMGP_TIMING");
+		if(env && atoi(env) != 0) {
+			g_atomic_int_set(&_mm_imgp_timing_enabled, 1);
+		}
+		_mm_imgp_timing_file = g_strdup(g_getenv("MM_IMGP_TIMING_FILE"));
+		g_once_init_leave(&_init, 1);
+	}
+}
+
+static gint64
+_mm_imgp_timing_start(void)
+{
+	/* 0 means the stage is not measured */
+	return g_atomic_int_get(&_mm_imgp_timing_enabled) ? g_get_monotonic_time() : 0;
+}
+
+static void
+_mm_imgp_timing_end(imgp_stage_e stage, gint64 start)
+{
+	unsigned long long elapsed = 0;
+
+	if(start == 0) {
+		return;
+	}
+	elapsed = (unsigned long long) (g_get_monotonic_time() - start);
+	_mm_imgp_timing_call[stage] += elapsed;
+
+	G_LOCK(imgp_timing);
+	_mm_imgp_timing.stage[stage].count++;
+	_mm_imgp_timing.stage[stage].total_us += elapsed;
+	if(elapsed > _mm_imgp_timing.stage[stage].max_us) {
+		_mm_imgp_timing.stage[stage].max_us = elapsed;
+	}
+	G_UNLOCK(imgp_timing);
+}
+
+static void
+_mm_imgp_timing_call_begin(void)
+{
+	_mm_imgp_timing_init();
+	/* calls of the API made by the library itself belong to the outermost one */
+	if(_mm_imgp_timing_depth++ == 0) {
+		memset(_mm_imgp_timing_call, 0, sizeof(_mm_imgp_timing_call));
+	}
+}
+
+static void
+_mm_imgp_timing_call_end(void)
+{
+	int i = 0;
+
+	if(--_mm_imgp_timing_depth > 0 || !g_atomic_int_get(&_mm_imgp_timing_enabled)) {
+		return;
+	}
+	G_LOCK(imgp_timing);
+	_mm_imgp_timing.calls++;
+	for(i = 0; i < IMGP_STAGE_NUM; i++) {
+		_mm_imgp_timing.stage[i].last_call_us = _mm_imgp_timing_call[i];
+	}
+	G_UNLOCK(imgp_timing);
+}
+
+static void __attribute__((destructor))
+_mm_imgp_timing_fini(void)
+{
+	if(_mm_imgp_timing_file && _mm_imgp_timing.calls > 0) {
+		mm_imgp_timing_dump(_mm_imgp_timing_file);
+	}
+}
+
+static int
+_mm_push_buffer_into_pipeline(imgp_info_s* pImgp_info, gstreamer_s * pGstreamer_s, GstCaps*_caps)
+{
+	imgp_frame_s planes_frame, packed_frame;
+	unsigned char* data = pImgp_info->src;
+	unsigned char* packed = NULL;
+	gint64 start = 0;
+	int ret = MM_ERROR_NONE;
+	if(_caps==NULL) {
+		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] caps is NULL\n", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	if(pGstreamer_s->pipeline == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] pipeline is NULL\n", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	if(pImgp_info->src_planes[0]) {
+		/* the caps of gstreamer 0.10 have no strides, planes which are not laid out as a packed buffer are packed into a block of the pool */
+		ret = _mm_imgp_src_frame_init(&planes_frame, pImgp_info);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_native_frame_init(&packed_frame, planes_frame.format, planes_frame.width, planes_frame.height, planes_frame.data[0]);
+		}
+		if(ret != MM_ERROR_NONE) {
+			mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] invalid planes of %s", __func__, __LINE__, pImgp_info->input_format_label);
+			return ret;
+		}
+		if(memcmp(&planes_frame, &packed_frame, sizeof(imgp_frame_s)) != 0) {
+			start = _mm_imgp_timing_start();
+			packed = (unsigned char*) _mm_imgp_pool_alloc(mm_setup_image_size(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height));
+			if(packed == NULL) {
+				return MM_ERROR_IMAGE_NO_FREE_SPACE;
+			}
+			_mm_native_frame_init(&packed_frame, planes_frame.format, planes_frame.width, planes_frame.height, packed);
+			_mm_native_frame_copy(&packed_frame, &planes_frame);
+			_mm_imgp_timing_end(IMGP_STAGE_COPY, start);
+		}
+		data = packed_frame.data[0];
+	}
+
+	GstBuffer* gst_buf = _mm_imgp_pool_buffer_new(); /* recycled once the pipeline is done with it */
+
+	if(gst_buf==NULL) 	{
+		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] buffer is NULL\n", __func__, __LINE__);
+		_mm_imgp_pool_free(packed);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	GST_BUFFER_DATA (gst_buf) = (guint8 *) data;
+	if(packed) {
+		/* released with the buffer */
+		GST_BUFFER_MALLOCDATA (gst_buf) = (guint8 *) packed;
+		GST_BUFFER_FREE_FUNC (gst_buf) = _mm_imgp_pool_free;
+	}
+	GST_BUFFER_SIZE (gst_buf) = mm_setup_image_size(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height);
+	GST_BUFFER_FLAG_SET (gst_buf, GST_BUFFER_FLAG_READONLY);
+	GST_BUFFER_TIMESTAMP (gst_buf) = pGstreamer_s->frame_count * GST_SECOND; /* caps framerate is 1/1 */
+	GST_BUFFER_DURATION (gst_buf) = GST_SECOND;
+	GST_BUFFER_OFFSET (gst_buf) = pGstreamer_s->frame_count; /* passed to the allocation of the output, see _mm_sink_buffer_alloc */
+	pGstreamer_s->frame_count++;
+
+	gst_buffer_set_caps (gst_buf, _caps);
+	/* appsrc takes the ownership of gst_buf, it must not be touched after this point because a running pipeline may already have released it */
+	gst_app_src_push_buffer (GST_APP_SRC (pGstreamer_s->appsrc), gst_buf); //push buffer to pipeline
+	gst_buf = NULL;
+	return ret;
+}
+
+static int
+_mm_imgp_native_processing(imgp_info_s* pImgp_info)
+{
+	imgp_frame_s src_frame, dst_frame;
+	imgp_native_op_s op;
+	imgp_native_stripe_f func = _mm_imgp_native_select(pImgp_info);
+	gint64 start = _mm_imgp_timing_start();
+	int ret = MM_ERROR_NONE;
+
+	if(func == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s -> %s is not supported natively", __func__, __LINE__, pImgp_info->input_format_label, pImgp_info->output_format_label);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	ret = _mm_imgp_src_frame_init(&src_frame, pImgp_info);
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_dst_frame_init(&dst_frame, pImgp_info);
+	}
+	if(ret == MM_ERROR_NONE) {
+		memset(&op, 0, sizeof(imgp_native_op_s));
+		op.src = &src_frame;
+		op.dst = &dst_frame;
+		op.angle = pImgp_info->angle;
+		op.filter = pImgp_info->resize_filter;
+		op.coeffs = _mm_native_get_coeffs(pImgp_info->color_matrix, pImgp_info->color_range);
+		if(func == _mm_native_resize_rows) {
+			ret = _mm_native_resize_prepare(&op);
+		}
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_run_stripes(func, &op, pImgp_info->thread_count);
+		_mm_native_resize_release(&op);
+	}
+	_mm_imgp_timing_end(IMGP_STAGE_NATIVE, start);
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s -> %s angle: %d with %s kernels ret: %d", __func__, __LINE__,
+		pImgp_info->input_format_label, pImgp_info->output_format_label, pImgp_info->angle, _mm_native_get_isa_name(_mm_native_get_isa()), ret);
+	return ret;
+}
+
+static int
+_mm_imgp_gstcs(imgp_info_s* pImgp_info);
+
+static unsigned int
+_mm_imgp_thumbnail_factor(unsigned int width, unsigned int height, unsigned int target_width, unsigned int target_height)
+{
+	unsigned int factor = 8;
+
+	/* the largest box which keeps the reduced frame at least as large as the target */
+	for(factor = 8; factor > 1; factor >>= 1) {
+		if(width / factor >= target_width && height / factor >= target_height) {
+			return factor;
+		}
+	}
+	return 1;
+}
+
+static int
+_mm_imgp_thumbnail(imgp_info_s* pImgp_info)
+{
+	imgp_info_s info;
+	imgp_frame_s src_frame, dst_frame;
+	imgp_native_op_s op;
+	mm_util_img_format_e format = _mm_get_native_format(pImgp_info->input_format_label);
+	const imgp_format_desc_s* desc = _mm_format_get_desc(format);
+	unsigned char* buffer[2] = { NULL, NULL };
+	unsigned int target_width = pImgp_info->dst_width;
+	unsigned int target_height = pImgp_info->dst_height;
+	unsigned int width = pImgp_info->src_width;
+	unsigned int height = pImgp_info->src_height;
+	unsigned int factor = 1;
+	unsigned int stage = 0;
+	gint64 start = 0;
+	int ret = MM_ERROR_NONE;
+
+	memcpy(&info, pImgp_info, sizeof(imgp_info_s));
+	info.resize_filter = MM_UTIL_RESIZE_FILTER_BILINEAR;
+	if(pImgp_info->angle == MM_UTIL_ROTATE_90 || pImgp_info->angle == MM_UTIL_ROTATE_270) {
+		target_width = pImgp_info->dst_height;
+		target_height = pImgp_info->dst_width;
+	}
+
+	/* box reductions of the source, in its own format, before any conversion: each one divides the samples to convert by up to 64 */
+	while(ret == MM_ERROR_NONE && desc != NULL
+		&& (factor = _mm_imgp_thumbnail_factor(width, height, target_width, target_height)) > 1
+		&& _mm_native_resize_supported(format, width, height, (width + factor - 1) / factor, (height + factor - 1) / factor)) {
+		start = _mm_imgp_timing_start();
+		_mm_imgp_pool_free(buffer[stage & 1]);
+		buffer[stage & 1] = (unsigned char*) _mm_imgp_pool_alloc(_mm_format_get_size(desc, (width + factor - 1) / factor, (height + factor - 1) / factor));
+		if(buffer[stage & 1] == NULL) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate the %ux%u reduced frame", __func__, __LINE__, (width + factor - 1) / factor, (height + factor - 1) / factor);
+			ret = MM_ERROR_IMAGE_NO_FREE_SPACE;
+			break;
+		}
+		ret = _mm_imgp_src_frame_init(&src_frame, &info);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_native_frame_init(&dst_frame, format, (width + factor - 1) / factor, (height + factor - 1) / factor, buffer[stage & 1]);
+		}
+		if(ret == MM_ERROR_NONE) {
+			memset(&op, 0, sizeof(imgp_native_op_s));
+			op.src = &src_frame;
+			op.dst = &dst_frame;
+			op.reduce = factor;
+			ret = _mm_native_resize_prepare(&op);
+		}
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_imgp_run_stripes(_mm_native_resize_rows, &op, pImgp_info->thread_count);
+			_mm_native_resize_release(&op);
+		}
+		_mm_imgp_timing_end(IMGP_STAGE_NATIVE, start);
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s %ux%u reduced by %u ret: %d", __func__, __LINE__, pImgp_info->input_format_label, width, height, factor, ret);
+
+		width = (width + factor - 1) / factor;
+		height = (height + factor - 1) / factor;
+		info.src = buffer[stage & 1];
+		memset(info.src_planes, 0, sizeof(info.src_planes));
+		info.src_width = width;
+		info.src_height = height;
+		stage++;
+	}
+
+	/* the precise resize, conversion and rotation of the reduced frame */
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_gstcs(&info);
+		pImgp_info->output_stride = info.output_stride;
+		pImgp_info->output_elevation = info.output_elevation;
+	}
+	_mm_imgp_pool_free(buffer[0]);
+	_mm_imgp_pool_free(buffer[1]);
+	return ret;
+}
+
+/* rows [y, y + rows) of frame as a frame of rows rows, y is even */
+static void
+_mm_imgp_band_frame(imgp_frame_s* band, const imgp_frame_s* frame, unsigned int y, unsigned int rows)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc(frame->format);
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int i = 0;
+
+	memcpy(band, frame, sizeof(imgp_frame_s));
+	band->height = rows;
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(frame->format, i, &elem, &x_shift, &y_shift);
+		band->data[i] = frame->data[i] + (gsize) (y >> y_shift) * frame->stride[i];
+	}
+}
+
+/* convert or copy src into dst of the same size */
+static int
+_mm_imgp_stream_convert(imgp_stream_s* pStream, const imgp_frame_s* src, const imgp_frame_s* dst)
+{
+	imgp_native_op_s op;
+
+	if(src->format == dst->format) {
+		_mm_native_frame_copy(dst, src);
+		return MM_ERROR_NONE;
+	}
+	memset(&op, 0, sizeof(imgp_native_op_s));
+	op.src = src;
+	op.dst = dst;
+	op.coeffs = pStream->coeffs;
+	return _mm_imgp_run_stripes(_mm_native_csc_rows, &op, pStream->thread_count);
+}
+
+/* append the rows [window_end, y_end) of the source to the window */
+static int
+_mm_imgp_stream_read(imgp_stream_s* pStream, unsigned int y_end)
+{
+	imgp_frame_s band, window_band;
+	unsigned int rows = y_end - pStream->window_end;
+	int ret = MM_ERROR_NONE;
+
+	if(rows == 0) {
+		return MM_ERROR_NONE;
+	}
+	_mm_imgp_band_frame(&window_band, &pStream->window, pStream->window_end - pStream->window_y, rows);
+	if(pStream->read_band == NULL) {
+		/* the rows of a single plane of the source format are read in place */
+		ret = pStream->read_cb(pStream->window_end, rows, window_band.data[0], pStream->user_data);
+	}else {
+		_mm_native_frame_init(&band, pStream->src_format, pStream->src_width, rows, pStream->read_band);
+		ret = pStream->read_cb(pStream->window_end, rows, pStream->read_band, pStream->user_data);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_imgp_stream_convert(pStream, &band, &window_band);
+		}
+	}
+	if(ret != MM_ERROR_NONE) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to read the rows [%u, %u) of the source ret: %d", __func__, __LINE__, pStream->window_end, y_end, ret);
+		return ret;
+	}
+	pStream->window_end = y_end;
+	return MM_ERROR_NONE;
+}
+
+/* keep the rows [src_start, src_end) of the source in the window, src_start is even and never goes back */
+static int
+_mm_imgp_stream_advance(imgp_stream_s* pStream, unsigned int src_start, unsigned int src_end)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc(pStream->work_format);
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int drop = 0, keep = 0;
+	unsigned int i = 0;
+	int ret = MM_ERROR_NONE;
+
+	/* rows of 4:2:0 chroma are read in pairs */
+	src_end = MIN(MM_UTIL_ROUND_UP_2(src_end), pStream->src_height);
+	src_end = MAX(src_end, pStream->window_end);
+
+	if(src_start >= pStream->window_end) {
+		/* the rows no band reads are still read in order, then dropped */
+		pStream->window_y = pStream->window_end;
+		while(ret == MM_ERROR_NONE && pStream->window_end < src_start) {
+			ret = _mm_imgp_stream_read(pStream, MIN(src_start, pStream->window_end + pStream->window_rows));
+			pStream->window_y = pStream->window_end;
+		}
+	}else if(src_start > pStream->window_y) {
+		drop = src_start - pStream->window_y;
+		for(i = 0; i < desc->plane_count; i++) {
+			_mm_native_plane_layout(pStream->work_format, i, &elem, &x_shift, &y_shift);
+			keep = ((pStream->window_end - pStream->window_y + (1 << y_shift) - 1) >> y_shift) - (drop >> y_shift);
+			memmove(pStream->window.data[i], pStream->window.data[i] + (gsize) (drop >> y_shift) * pStream->window.stride[i], (gsize) keep * pStream->window.stride[i]);
+		}
+		pStream->window_y = src_start;
+	}
+	if(ret == MM_ERROR_NONE && src_end - pStream->window_y > pStream->window_rows) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] the rows [%u, %u) do not fit the window of %u rows", __func__, __LINE__, pStream->window_y, src_end, pStream->window_rows);
+		ret = MM_ERROR_IMAGE_INTERNAL;
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_stream_read(pStream, src_end);
+	}
+	return ret;
+}
+
+static void
+_mm_imgp_stream_release(imgp_stream_s* pStream, imgp_native_op_s* op)
+{
+	_mm_native_resize_release(op);
+	_mm_imgp_pool_free(pStream->window.data[0]);
+	_mm_imgp_pool_free(pStream->read_band);
+	_mm_imgp_pool_free(pStream->work_band);
+	_mm_imgp_pool_free(pStream->dst_band);
+	memset(&pStream->window, 0, sizeof(imgp_frame_s));
+	pStream->read_band = NULL;
+	pStream->work_band = NULL;
+	pStream->dst_band = NULL;
+}
+
+static int
+_mm_imgp_stream_setup(imgp_stream_s* pStream, imgp_native_op_s* op, imgp_info_s* pImgp_info, unsigned int band_height)
+{
+	const imgp_format_desc_s* src_desc = NULL;
+	const imgp_format_desc_s* dst_desc = NULL;
+	const imgp_format_desc_s* work_desc = NULL;
+	gboolean resize = FALSE;
+	unsigned char* window = NULL;
+	unsigned int y = 0, rows = 0, src_start = 0, src_end = 0;
+	int ret = MM_ERROR_NONE;
+
+	pStream->src_format = _mm_get_native_format(pImgp_info->input_format_label);
+	pStream->dst_format = _mm_get_native_format(pImgp_info->output_format_label);
+	pStream->src_width = pImgp_info->src_width;
+	pStream->src_height = pImgp_info->src_height;
+	pStream->dst_width = pImgp_info->dst_width;
+	pStream->dst_height = pImgp_info->dst_height;
+	pStream->thread_count = pImgp_info->thread_count;
+	pStream->coeffs = _mm_native_get_coeffs(pImgp_info->color_matrix, pImgp_info->color_range);
+	src_desc = _mm_format_get_desc(pStream->src_format);
+	dst_desc = _mm_format_get_desc(pStream->dst_format);
+	if(src_desc == NULL || dst_desc == NULL || src_desc->plane_count == 0 || dst_desc->plane_count == 0
+		|| ((src_desc->flags | dst_desc->flags) & IMGP_FORMAT_FLAG_TILED)
+		|| pStream->src_width == 0 || pStream->src_height == 0 || pStream->dst_width == 0 || pStream->dst_height == 0
+		|| pStream->coeffs == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s %ux%u -> %s %ux%u can not be streamed", __func__, __LINE__,
+			pImgp_info->input_format_label, pStream->src_width, pStream->src_height, pImgp_info->output_format_label, pStream->dst_width, pStream->dst_height);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	if(pImgp_info->angle != MM_UTIL_ROTATE_0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] a rotation needs the whole frame, angle: %d", __func__, __LINE__, pImgp_info->angle);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	if(_mm_imgp_has_crop(pImgp_info)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] the bands of the source are whole rows, they can not be cropped", __func__, __LINE__);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+
+	/* the resize runs on the format it supports, the source one first as it usually has the fewer bytes */
+	resize = _mm_check_resize_format(pStream->src_width, pStream->src_height, pStream->dst_width, pStream->dst_height);
+	pStream->work_format = pStream->src_format;
+	if(resize && !_mm_native_resize_supported(pStream->src_format, pStream->src_width, pStream->src_height, pStream->dst_width, pStream->dst_height)) {
+		pStream->work_format = pStream->dst_format;
+	}
+	if((resize && !_mm_native_resize_supported(pStream->work_format, pStream->src_width, pStream->src_height, pStream->dst_width, pStream->dst_height))
+		|| (pStream->work_format != pStream->src_format && !_mm_native_csc_supported(pStream->src_format, pStream->work_format))
+		|| (pStream->work_format != pStream->dst_format && !_mm_native_csc_supported(pStream->work_format, pStream->dst_format))) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s -> %s resize: %d is not supported natively", __func__, __LINE__,
+			pImgp_info->input_format_label, pImgp_info->output_format_label, resize);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	work_desc = _mm_format_get_desc(pStream->work_format);
+
+	pStream->band_rows = MM_UTIL_ROUND_UP_2(band_height ? band_height : MM_UTIL_IMGP_STREAM_BAND_ROWS);
+	pStream->window_rows = pStream->band_rows;
+	if(resize) {
+		/* frames of the whole source and dst, their planes are pointed at the window and the band of each band */
+		memset(&pStream->resize_src, 0, sizeof(imgp_frame_s));
+		pStream->resize_src.format = pStream->work_format;
+		pStream->resize_src.width = pStream->src_width;
+		pStream->resize_src.height = pStream->src_height;
+		memset(&pStream->resize_dst, 0, sizeof(imgp_frame_s));
+		pStream->resize_dst.format = pStream->work_format;
+		pStream->resize_dst.width = pStream->dst_width;
+		pStream->resize_dst.height = pStream->dst_height;
+		op->src = &pStream->resize_src;
+		op->dst = &pStream->resize_dst;
+		op->filter = pImgp_info->resize_filter;
+		ret = _mm_native_resize_prepare(op);
+		if(ret != MM_ERROR_NONE) {
+			return ret;
+		}
+		/* the window holds the source rows of the band which reads the most */
+		pStream->window_rows = 2;
+		for(y = 0; y < pStream->dst_height; y += rows) {
+			rows = MIN(pStream->band_rows, pStream->dst_height - y);
+			_mm_native_resize_src_rows(op, y, y + rows, &src_start, &src_end);
+			src_end = MIN(MM_UTIL_ROUND_UP_2(src_end), pStream->src_height);
+			pStream->window_rows = MAX(pStream->window_rows, MM_UTIL_ROUND_UP_2(src_end - src_start));
+		}
+	}
+
+	window = (unsigned char*) _mm_imgp_pool_alloc(_mm_format_get_size(work_desc, pStream->src_width, pStream->window_rows));
+	if(pStream->work_format != pStream->src_format || src_desc->plane_count > 1) {
+		pStream->read_band = (unsigned char*) _mm_imgp_pool_alloc(_mm_format_get_size(src_desc, pStream->src_width, pStream->window_rows));
+	}
+	if(resize && pStream->work_format != pStream->dst_format) {
+		pStream->work_band = (unsigned char*) _mm_imgp_pool_alloc(_mm_format_get_size(work_desc, pStream->dst_width, pStream->band_rows));
+	}
+	pStream->dst_band = (unsigned char*) _mm_imgp_pool_alloc(_mm_format_get_size(dst_desc, pStream->dst_width, pStream->band_rows));
+	_mm_native_frame_init(&pStream->window, pStream->work_format, pStream->src_width, pStream->window_rows, window);
+	if(window == NULL || pStream->dst_band == NULL
+		|| (pStream->read_band == NULL && (pStream->work_format != pStream->src_format || src_desc->plane_count > 1))
+		|| (pStream->work_band == NULL && resize && pStream->work_format != pStream->dst_format)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate the window of %u rows and the bands of %u rows", __func__, __LINE__, pStream->window_rows, pStream->band_rows);
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s %ux%u -> %s %ux%u in bands of %u rows, window of %u rows of %s", __func__, __LINE__,
+		pImgp_info->input_format_label, pStream->src_width, pStream->src_height, pImgp_info->output_format_label, pStream->dst_width, pStream->dst_height,
+		pStream->band_rows, pStream->window_rows, work_desc->label);
+	return MM_ERROR_NONE;
+}
+
+static int
+_mm_imgp_stream_run(imgp_stream_s* pStream, imgp_native_op_s* op)
+{
+	imgp_frame_s work_band, dst_band;
+	unsigned int y = 0, rows = 0, src_start = 0, src_end = 0;
+	gint64 start = 0;
+	int ret = MM_ERROR_NONE;
+
+	for(y = 0; ret == MM_ERROR_NONE && y < pStream->dst_height; y += rows) {
+		rows = MIN(pStream->band_rows, pStream->dst_height - y);
+		src_start = y;
+		src_end = y + rows;
+		if(op->resize) {
+			_mm_native_resize_src_rows(op, y, y + rows, &src_start, &src_end);
+		}
+		ret = _mm_imgp_stream_advance(pStream, src_start, src_end);
+		if(ret != MM_ERROR_NONE) {
+			break;
+		}
+
+		start = _mm_imgp_timing_start();
+		_mm_native_frame_init(&dst_band, pStream->dst_format, pStream->dst_width, rows, pStream->dst_band);
+		if(op->resize) {
+			_mm_native_frame_init(&work_band, pStream->work_format, pStream->dst_width, rows, pStream->work_band ? pStream->work_band : pStream->dst_band);
+			memcpy(pStream->resize_src.data, pStream->window.data, sizeof(pStream->resize_src.data));
+			memcpy(pStream->resize_src.stride, pStream->window.stride, sizeof(pStream->resize_src.stride));
+			memcpy(pStream->resize_dst.data, work_band.data, sizeof(pStream->resize_dst.data));
+			memcpy(pStream->resize_dst.stride, work_band.stride, sizeof(pStream->resize_dst.stride));
+			op->src_y = pStream->window_y;
+			op->dst_y = y;
+			ret = _mm_imgp_run_stripes_range(_mm_native_resize_rows, op, y, y + rows, pStream->thread_count);
+			if(ret == MM_ERROR_NONE && pStream->work_band) {
+				ret = _mm_imgp_stream_convert(pStream, &work_band, &dst_band);
+			}
+		}else {
+			_mm_imgp_band_frame(&work_band, &pStream->window, y - pStream->window_y, rows);
+			ret = _mm_imgp_stream_convert(pStream, &work_band, &dst_band);
+		}
+		_mm_imgp_timing_end(IMGP_STAGE_NATIVE, start);
+
+		if(ret == MM_ERROR_NONE) {
+			ret = pStream->write_cb(y, rows, pStream->dst_band, pStream->user_data);
+			if(ret != MM_ERROR_NONE) {
+				mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to write the rows [%u, %u) of dst ret: %d", __func__, __LINE__, y, y + rows, ret);
+			}
+		}
+	}
+	/* the source rows below the ones the last band read are pulled as well, a pipe or a decoder expects to be drained */
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_stream_advance(pStream, pStream->src_height, pStream->src_height);
+	}
+	return ret;
+}
+
+/* release the pages of the rows of every plane before y_end, they are not read or written anymore */
+static void
+_mm_imgp_stream_file_release(imgp_stream_file_s* pFile, unsigned int y_end)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc(pFile->frame.format);
+	gsize page = (gsize) sysconf(_SC_PAGESIZE);
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	gsize end = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(pFile->frame.format, i, &elem, &x_shift, &y_shift);
+		end = (pFile->frame.data[i] - pFile->map) + (gsize) (y_end >> y_shift) * pFile->frame.stride[i];
+		end &= ~(page - 1);
+		if(end > pFile->released[i]) {
+			madvise(pFile->map + pFile->released[i], end - pFile->released[i], MADV_DONTNEED);
+			pFile->released[i] = end;
+		}
+	}
+}
+
+static int
+_mm_imgp_stream_file_read(unsigned int y, unsigned int rows, unsigned char* band, void* user_data)
+{
+	imgp_stream_file_s* pFile = &((imgp_stream_file_s*) user_data)[0];
+	imgp_frame_s src, dst;
+
+	_mm_imgp_band_frame(&src, &pFile->frame, y, rows);
+	_mm_native_frame_init(&dst, pFile->frame.format, pFile->frame.width, rows, band);
+	_mm_native_frame_copy(&dst, &src);
+	_mm_imgp_stream_file_release(pFile, y + rows);
+	return MM_ERROR_NONE;
+}
+
+static int
+_mm_imgp_stream_file_write(unsigned int y, unsigned int rows, const unsigned char* band, void* user_data)
+{
+	imgp_stream_file_s* pFile = &((imgp_stream_file_s*) user_data)[1];
+	imgp_frame_s src, dst;
+
+	_mm_native_frame_init(&src, pFile->frame.format, pFile->frame.width, rows, (unsigned char*) band);
+	_mm_imgp_band_frame(&dst, &pFile->frame, y, rows);
+	_mm_native_frame_copy(&dst, &src);
+	/* the dirty pages stay in the page cache of the file until they are written back */
+	_mm_imgp_stream_file_release(pFile, y + rows);
+	return MM_ERROR_NONE;
+}
+
+static int
+_mm_imgp_stream_file_open(imgp_stream_file_s* pFile, const char* path, const char* format_label, unsigned int width, unsigned int height, gboolean write)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc_by_label(format_label);
+	gsize page = (gsize) sysconf(_SC_PAGESIZE);
+	struct stat st;
+	unsigned int i = 0;
+	int fd = -1;
+
+	memset(pFile, 0, sizeof(imgp_stream_file_s));
+	if(desc == NULL || desc->plane_count == 0 || width == 0 || height == 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s %ux%u has no linear layout", __func__, __LINE__, format_label, width, height);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	pFile->size = _mm_format_get_size(desc, width, height);
+
+	fd = write ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path, O_RDONLY);
+	if(fd < 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to open %s", __func__, __LINE__, path);
+		return MM_ERROR_IMAGE_FILEOPEN;
+	}
+	if(write ? ftruncate(fd, pFile->size) != 0 : (fstat(fd, &st) != 0 || (gsize) st.st_size < pFile->size)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s can not hold %u bytes", __func__, __LINE__, path, (unsigned int) pFile->size);
+		close(fd);
+		return write ? MM_ERROR_IMAGE_FILEOPEN : MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	pFile->map = (unsigned char*) mmap(NULL, pFile->size, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(pFile->map == MAP_FAILED) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to map %s", __func__, __LINE__, path);
+		pFile->map = NULL;
+		return MM_ERROR_IMAGE_FILEOPEN;
+	}
+	madvise(pFile->map, pFile->size, MADV_SEQUENTIAL);
+	_mm_native_frame_init(&pFile->frame, desc->format, width, height, pFile->map);
+	/* a page shared with the previous plane is released with it */
+	for(i = 0; i < desc->plane_count; i++) {
+		pFile->released[i] = ((pFile->frame.data[i] - pFile->map) + page - 1) & ~(page - 1);
+	}
+	return MM_ERROR_NONE;
+}
+
+static void
+_mm_imgp_stream_file_close(imgp_stream_file_s* pFile)
+{
+	if(pFile->map) {
+		munmap(pFile->map, pFile->size);
+	}
+	memset(pFile, 0, sizeof(imgp_stream_file_s));
+}
+
+static void
+_mm_free_image_format_s(image_format_s* __format)
+{
+	/* the format and its caps are kept for the next pipeline of the same format and size */
+	_mm_imgp_pool_format_release(__format);
+}
+
+static void
+_mm_destroy_pipeline(gstreamer_s* pGstreamer_s)
+{
+	GstElement* _elements[] = { pGstreamer_s->appsrc, pGstreamer_s->colorspace, pGstreamer_s->videoscale, pGstreamer_s->videoflip, pGstreamer_s->appsink };
+	unsigned int i = 0;
+
+	/* elements which were not added to the bin by the link order are not released together with the pipeline */
+	for(i = 0; i < G_N_ELEMENTS(_elements); i++) {
+		if(_elements[i] && GST_OBJECT_PARENT(_elements[i]) == NULL) {
+			gst_object_unref(_elements[i]);
+		}
+	}
+	if(pGstreamer_s->pipeline) {
+		gst_object_unref(pGstreamer_s->pipeline);
+	}
+	pGstreamer_s->pipeline = NULL;
+	pGstreamer_s->appsrc = NULL;
+	pGstreamer_s->colorspace = NULL;
+	pGstreamer_s->videoscale = NULL;
+	pGstreamer_s->videoflip = NULL;
+	pGstreamer_s->appsink = NULL;
+}
+
+static void
+_mm_context_sink_buffer(GstElement * appsink, gpointer  user_data)
+{
+	gstreamer_s * pGstreamer_s = (gstreamer_s*) user_data;
+	GstBuffer *_buf = gst_app_sink_pull_buffer((GstAppSink*)appsink);
+
+	g_mutex_lock(&pGstreamer_s->lock);
+	g_queue_push_tail(&pGstreamer_s->output_buffers, _buf);
+	g_cond_signal(&pGstreamer_s->cond);
+	g_mutex_unlock(&pGstreamer_s->lock);
+}
+
+static GstFlowReturn
+_mm_sink_buffer_alloc(GstPad * pad, guint64 offset, guint size, GstCaps * caps, GstBuffer ** buf)
+{
+	gstreamer_s * pGstreamer_s = (gstreamer_s*) g_object_get_data(G_OBJECT(pad), MM_UTIL_IMGP_GSTREAMER_KEY);
+	GstBuffer *_buf = NULL;
+	unsigned char *_dst = NULL;
+	GList *item = NULL;
+
+	/* the elements allocate the output of a frame with the offset of its input buffer, which is the frame number.
+	 * Allocations of no frame in flight, e.g. for a renegotiation, get a buffer of the pool and leave the dst of the next frames alone.
+	 * The dst stays queued until the frame is collected, so an element which allocates twice for a frame gets it both times */
+	g_mutex_lock(&pGstreamer_s->lock);
+	for(item = pGstreamer_s->dsts.head; item != NULL; item = item->next) {
+		if(((imgp_dst_s*) item->data)->frame == offset) {
+			_dst = ((imgp_dst_s*) item->data)->dst;
+			break;
+		}
+	}
+	if(_dst != NULL && size <= pGstreamer_s->dst_size) {
+		/* wrap the memory of the caller, it is not freed with the buffer */
+		_buf = _mm_imgp_pool_buffer_new();
+		GST_BUFFER_DATA(_buf) = _dst;
+		GST_BUFFER_SIZE(_buf) = size;
+	}
+	g_mutex_unlock(&pGstreamer_s->lock);
+
+	if(_buf == NULL) {
+		_buf = _mm_imgp_pool_buffer_new_and_alloc(size);
+		if(_buf == NULL) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate %d bytes", __func__, __LINE__, size);
+			return GST_FLOW_ERROR;
+		}
+	}
+	GST_BUFFER_OFFSET(_buf) = offset;
+	gst_buffer_set_caps(_buf, caps);
+	*buf = _buf;
+	return GST_FLOW_OK;
+}
+
+static GstBusSyncReply
+_mm_context_bus_sync_handler(GstBus * bus, GstMessage * message, gpointer user_data)
+{
+	gstreamer_s * pGstreamer_s = (gstreamer_s*) user_data;
+
+	/* nobody runs a main loop for the bus of a kept alive pipeline, so the messages are handled and dropped here */
+	_mm_on_sink_message(bus, message, pGstreamer_s);
+	if(GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR || GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS) {
+		mmf_debug(MMF_DEBUG_ERROR,"[%s][%05d] [%s] %s\n", __func__, __LINE__, GST_MESSAGE_SRC_NAME(message), GST_MESSAGE_TYPE_NAME(message));
+		g_mutex_lock(&pGstreamer_s->lock);
+		pGstreamer_s->error = TRUE;
+		g_cond_signal(&pGstreamer_s->cond);
+		g_mutex_unlock(&pGstreamer_s->lock);
+	}
+	gst_message_unref(message);
+	return GST_BUS_DROP;
+}
+
+static void
+_mm_imgp_context_free(imgp_context_s* pContext)
+{
+	gstreamer_s* pGstreamer_s = pContext->gstreamer;
+	gint64 start = _mm_imgp_timing_start();
+
+	if(pGstreamer_s) {
+		if(pGstreamer_s->pipeline) {
+			gst_element_set_state (pGstreamer_s->pipeline, GST_STATE_NULL);
+			gst_element_get_state (pGstreamer_s->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+		}
+		_mm_destroy_pipeline(pGstreamer_s);
+		while(!g_queue_is_empty(&pGstreamer_s->output_buffers)) {
+			gst_buffer_unref((GstBuffer*)g_queue_pop_head(&pGstreamer_s->output_buffers));
+		}
+		g_queue_foreach(&pGstreamer_s->dsts, (GFunc) g_free, NULL);
+		g_queue_clear(&pGstreamer_s->dsts);
+		g_cond_clear(&pGstreamer_s->cond);
+		g_mutex_clear(&pGstreamer_s->lock);
+		g_free(pGstreamer_s);
+	}
+	_mm_free_image_format_s(pContext->input_format);
+	_mm_free_image_format_s(pContext->output_format);
+	g_free(pContext);
+	_mm_imgp_timing_end(IMGP_STAGE_TEARDOWN, start);
+}
+
+/* the buffers and layouts of a frame processed with the geometry of the context */
+static void
+_mm_imgp_context_set_frame(imgp_context_s* pContext, imgp_info_s* pFrame)
+{
+	pContext->info.src = pFrame->src;
+	pContext->info.dst = pFrame->dst;
+	memcpy(pContext->info.src_planes, pFrame->src_planes, sizeof(pContext->info.src_planes));
+	memcpy(pContext->info.src_strides, pFrame->src_strides, sizeof(pContext->info.src_strides));
+	memcpy(pContext->info.dst_strides, pFrame->dst_strides, sizeof(pContext->info.dst_strides));
+	memcpy(pContext->info.dst_offsets, pFrame->dst_offsets, sizeof(pContext->info.dst_offsets));
+}
+
+static void
+_mm_imgp_context_clear_frame(imgp_context_s* pContext)
+{
+	pContext->info.src = NULL;
+	pContext->info.dst = NULL;
+	memset(pContext->info.src_planes, 0, sizeof(pContext->info.src_planes));
+	memset(pContext->info.src_strides, 0, sizeof(pContext->info.src_strides));
+	memset(pContext->info.dst_strides, 0, sizeof(pContext->info.dst_strides));
+	memset(pContext->info.dst_offsets, 0, sizeof(pContext->info.dst_offsets));
+}
+
+static int
+_mm_imgp_context_submit(imgp_context_s* pContext, imgp_info_s* pFrame)
+{
+	unsigned char *dst = pFrame->dst;
+	gstreamer_s* pGstreamer_s = pContext->gstreamer;
+	imgp_frame_s dst_frame, packed_frame;
+	imgp_dst_s* pDst = NULL;
+	int ret = MM_ERROR_NONE;
+
+	_mm_imgp_context_set_frame(pContext, pFrame);
+	if(_mm_imgp_has_dst_layout(&pContext->info)) {
+		/* the pipeline writes a packed frame, it goes to dst only when the layout of dst is the packed one */
+		ret = _mm_imgp_dst_frame_init(&dst_frame, &pContext->info);
+		if(ret == MM_ERROR_NONE) {
+			_mm_native_frame_init(&packed_frame, dst_frame.format, dst_frame.width, dst_frame.height, dst);
+			if(memcmp(&dst_frame, &packed_frame, sizeof(imgp_frame_s)) != 0) {
+				dst = NULL;
+			}
+		}
+	}
+	if(ret != MM_ERROR_NONE) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid layout of dst for %s", __func__, __LINE__, pContext->info.output_format_label);
+		_mm_imgp_context_clear_frame(pContext);
+		return ret;
+	}
+
+	/* the last element of the pipeline allocates its output buffer in dst, see _mm_sink_buffer_alloc */
+	pDst = g_new0(imgp_dst_s, 1);
+	pDst->dst = dst;
+	g_mutex_lock(&pGstreamer_s->lock);
+	pDst->frame = pGstreamer_s->frame_count;
+	g_queue_push_tail(&pGstreamer_s->dsts, pDst);
+	pGstreamer_s->dst_size = pContext->output_format->blocksize;
+	g_mutex_unlock(&pGstreamer_s->lock);
+
+	ret = _mm_push_buffer_into_pipeline(&pContext->info, pGstreamer_s, pContext->input_format->caps);
+	_mm_imgp_context_clear_frame(pContext);
+	if(ret != MM_ERROR_NONE) {
+		/* no frame was pushed, the next one takes the frame number */
+		g_mutex_lock(&pGstreamer_s->lock);
+		g_queue_remove(&pGstreamer_s->dsts, pDst);
+		g_mutex_unlock(&pGstreamer_s->lock);
+		g_free(pDst);
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR - mm_push_buffer_into_pipeline ", __func__, __LINE__);
+	}
+	return ret;
+}
+
+static int
+_mm_imgp_context_collect(imgp_context_s* pContext, imgp_info_s* pFrame)
+{
+	gstreamer_s* pGstreamer_s = pContext->gstreamer;
+	GstBuffer* output_buffer = NULL;
+	imgp_frame_s dst_frame, output_frame;
+	unsigned char *dst = pFrame->dst;
+	int buffer_size = 0;
+	int ret = MM_ERROR_NONE;
+	gint64 start = _mm_imgp_timing_start();
+
+	g_mutex_lock(&pGstreamer_s->lock);
+	while(g_queue_is_empty(&pGstreamer_s->output_buffers) && !pGstreamer_s->error) {
+		g_cond_wait(&pGstreamer_s->cond, &pGstreamer_s->lock);
+	}
+	output_buffer = (GstBuffer*) g_queue_pop_head(&pGstreamer_s->output_buffers);
+	g_free(g_queue_pop_head(&pGstreamer_s->dsts)); /* the frame is done, its dst can not be allocated anymore */
+	g_mutex_unlock(&pGstreamer_s->lock);
+	_mm_imgp_timing_end(IMGP_STAGE_FRAME, start);
+
+	if(output_buffer == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] pipeline of context %p is in error", __func__, __LINE__, pContext);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	buffer_size = GST_BUFFER_SIZE(output_buffer);
+	if( buffer_size != mm_setup_image_size(pContext->info.output_format_label, pContext->info.output_stride, pContext->info.output_elevation)) {
+		mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] Buffer size is different stride:%d elevation: %d\n", __func__, __LINE__, pContext->info.output_stride, pContext->info.output_elevation);
+	}
+	if(GST_BUFFER_DATA(output_buffer) != dst) {
+		/* an element in passthrough, an allocation which did not fit dst or a layout of dst the pipeline can not write */
+		pGstreamer_s->copy_count++;
+		mmf_debug (MMF_DEBUG_LOG, "[%s][%05d] output buffer is not dst, copy %d bytes (%" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " frames copied)",
+			__func__, __LINE__, buffer_size, pGstreamer_s->copy_count, pGstreamer_s->frame_count);
+		start = _mm_imgp_timing_start();
+		_mm_imgp_context_set_frame(pContext, pFrame);
+		if(!_mm_imgp_has_dst_layout(&pContext->info)) {
+			memcpy(dst, GST_BUFFER_DATA(output_buffer), buffer_size);
+		}else if(buffer_size < pContext->output_format->blocksize) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] output buffer of %d bytes is smaller than a frame", __func__, __LINE__, buffer_size);
+			ret = MM_ERROR_IMAGE_INVALID_VALUE;
+		}else {
+			ret = _mm_imgp_dst_frame_init(&dst_frame, &pContext->info);
+			if(ret == MM_ERROR_NONE) {
+				_mm_native_frame_init(&output_frame, dst_frame.format, dst_frame.width, dst_frame.height, GST_BUFFER_DATA(output_buffer));
+				_mm_native_frame_copy(&dst_frame, &output_frame);
+			}
+		}
+		_mm_imgp_context_clear_frame(pContext);
+		_mm_imgp_timing_end(IMGP_STAGE_COPY, start);
+	}
+	gst_buffer_unref(output_buffer);
+	return ret;
+}
+
+static void
+_mm_imgp_context_reset(imgp_context_s* pContext)
+{
+	gstreamer_s* pGstreamer_s = pContext->gstreamer;
+
+	/* dst which were not taken by an allocation, e.g. when the last element works in passthrough, must not be used for a later frame */
+	g_mutex_lock(&pGstreamer_s->lock);
+	g_queue_foreach(&pGstreamer_s->dsts, (GFunc) g_free, NULL);
+	g_queue_clear(&pGstreamer_s->dsts);
+	g_mutex_unlock(&pGstreamer_s->lock);
+}
+
+static int
+_mm_imgp_context_run(imgp_context_s* pContext, imgp_info_s* pFrame)
+{
+	imgp_info_s source, cropped;
+	int ret = MM_ERROR_NONE;
+
+	/* the buffers of the frame have the size of the whole source, the context was set up for the crop of it */
+	if(_mm_imgp_has_crop(&pContext->source)) {
+		memcpy(&source, &pContext->source, sizeof(imgp_info_s));
+		source.src = pFrame->src;
+		source.dst = pFrame->dst;
+		memcpy(source.src_planes, pFrame->src_planes, sizeof(source.src_planes));
+		memcpy(source.src_strides, pFrame->src_strides, sizeof(source.src_strides));
+		memcpy(source.dst_strides, pFrame->dst_strides, sizeof(source.dst_strides));
+		memcpy(source.dst_offsets, pFrame->dst_offsets, sizeof(source.dst_offsets));
+		ret = _mm_imgp_crop_source(&cropped, &source);
+		if(ret != MM_ERROR_NONE) {
+			return ret;
+		}
+		pFrame = &cropped;
+	}
+
+	if(pContext->native) {
+		_mm_imgp_context_set_frame(pContext, pFrame);
+		ret = _mm_imgp_native_processing(&pContext->info);
+		_mm_imgp_context_clear_frame(pContext);
+	}else {
+		ret = _mm_imgp_context_submit(pContext, pFrame);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_imgp_context_collect(pContext, pFrame);
+		}
+		_mm_imgp_context_reset(pContext);
+	}
+	return ret;
+}
+
+static gboolean
+_mm_imgp_context_match(imgp_context_s* pContext, imgp_info_s* pImgp_info)
+{
+	/* the link order of the pipeline only depends on these values */
+	return (strcmp(pContext->info.input_format_label, pImgp_info->input_format_label) == 0
+		&& strcmp(pContext->info.output_format_label, pImgp_info->output_format_label) == 0
+		&& pContext->info.src_width == pImgp_info->src_width && pContext->info.src_height == pImgp_info->src_height
+		&& pContext->info.dst_width == pImgp_info->dst_width && pContext->info.dst_height == pImgp_info->dst_height
+		&& pContext->info.angle == pImgp_info->angle && pContext->info.resize_filter == pImgp_info->resize_filter
+		&& pContext->info.color_matrix == pImgp_info->color_matrix && pContext->info.color_range == pImgp_info->color_range);
+}
+
+static int
+_mm_imgp_cache_acquire(imgp_info_s* pImgp_info, imgp_context_s** ppContext)
+{
+	GList* _list = NULL;
+	imgp_context_s* pContext = NULL;
+
+	G_LOCK(imgp_cache);
+	for(_list = _mm_imgp_cache.head; _list != NULL; _list = _list->next) {
+		if(_mm_imgp_context_match((imgp_context_s*)_list->data, pImgp_info)) {
+			pContext = (imgp_context_s*)_list->data;
+			g_queue_delete_link(&_mm_imgp_cache, _list); /* the caller owns the context until it is released */
+			break;
+		}
+	}
+	if(pContext) {
+		_mm_imgp_cache_stats.hits++;
+	}else {
+		_mm_imgp_cache_stats.misses++;
+	}
+	G_UNLOCK(imgp_cache);
+
+	if(pContext) {
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] cache hit context: %p", __func__, __LINE__, pContext);
+		pImgp_info->output_stride = pContext->info.output_stride;
+		pImgp_info->output_elevation = pContext->info.output_elevation;
+		*ppContext = pContext;
+		return MM_ERROR_NONE;
+	}
+	return mm_imgp_context_create((imgp_context_h*)ppContext, pImgp_info, IMGP_CSC);
+}
+
+static void
+_mm_imgp_cache_release(imgp_context_s* pContext, gboolean reusable)
+{
+	GSList* _evicted = NULL;
+
+	G_LOCK(imgp_cache);
+	if(reusable && _mm_imgp_cache_size > 0) {
+		g_queue_push_head(&_mm_imgp_cache, pContext);
+		pContext = NULL;
+		while(g_queue_get_length(&_mm_imgp_cache) > _mm_imgp_cache_size) {
+			_evicted = g_slist_prepend(_evicted, g_queue_pop_tail(&_mm_imgp_cache));
+			_mm_imgp_cache_stats.evictions++;
+		}
+	}
+	G_UNLOCK(imgp_cache);
+
+	/* pipelines are stopped outside of the lock because the state change can take a while */
+	if(pContext) {
+		_mm_imgp_context_free(pContext);
+	}
+	while(_evicted) {
+		_mm_imgp_context_free((imgp_context_s*)_evicted->data);
+		_evicted = g_slist_delete_link(_evicted, _evicted);
+	}
+}
+
+static int
+_mm_imgp_gstcs(imgp_info_s* pImgp_info)
+{
+	imgp_context_s* pContext = NULL;
+	imgp_info_s cropped;
+	int ret = MM_ERROR_NONE;
+
+	if(pImgp_info == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] imgp_info_s is NULL", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] [input] format label : %s width: %d height: %d\t[output] format label: %s width: %d height: %d rotation vaule: %d dst: %p", __func__, __LINE__,
+		pImgp_info->input_format_label,  pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label,  pImgp_info->dst_width, pImgp_info->dst_height, pImgp_info->angle, pImgp_info->dst);
+
+	if(!_mm_imgp_has_src(pImgp_info) || pImgp_info->dst == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] imgp_info_s->src or imgp_info_s->dst is NULL", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	/* the rectangle is processed as if it were the whole source, nothing reads the rest of it */
+	if(_mm_imgp_has_crop(pImgp_info)) {
+		ret = _mm_imgp_crop_source(&cropped, pImgp_info);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_imgp_gstcs(&cropped);
+			pImgp_info->output_stride = cropped.output_stride;
+			pImgp_info->output_elevation = cropped.output_elevation;
+		}
+		return ret;
+	}
+
+	if(pImgp_info->resize_filter == MM_UTIL_RESIZE_FILTER_THUMBNAIL) {
+		return _mm_imgp_thumbnail(pImgp_info);
+	}
+
+	if(_mm_imgp_native_select(pImgp_info) != NULL) {
+		_mm_set_output_stride_elevation(pImgp_info);
+		return _mm_imgp_native_processing(pImgp_info);
+	}
+
+	ret = _mm_imgp_cache_acquire(pImgp_info, &pContext);
+	if(ret != MM_ERROR_NONE) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] Error - Check your input / ouput image input_format_label: %s src_width: %d src_height: %d output_format_label: %s output_stride: %d output_elevation: %d  angle: %d ",__func__, __LINE__,
+		pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label, pImgp_info->output_stride, pImgp_info->output_elevation, pImgp_info->angle);
+		return ret;
+	}
+
+	/* _format_label : I420, RGB888 etc*/
+	mmf_debug(MMF_DEBUG_LOG,"[%s][%05d] Start mm_convert_colorspace ", __func__, __LINE__);
+	ret = _mm_imgp_context_run(pContext, pImgp_info);
+	if(ret == MM_ERROR_NONE) {
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] End mm_convert_colorspace [pImgp_info->dst: %p]", __func__, __LINE__, pImgp_info->dst);
+	}else {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR -mm_convert_colorspace", __func__, __LINE__);
+	}
+
+	/* a pipeline which went to error is not kept for the next call */
+	_mm_imgp_cache_release(pContext, ret == MM_ERROR_NONE);
+	return ret;
+}
+
+int
+mm_imgp(imgp_info_s* pImgp_info, imgp_type_e _imgp_type)
+{
+	int ret = MM_ERROR_NONE;
+
+	if (pImgp_info == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+	}
+	_mm_imgp_timing_call_begin();
+	ret = _mm_imgp_gstcs(pImgp_info);
+	_mm_imgp_timing_call_end();
+	return ret;
+}
+
+int
+mm_imgp_query(imgp_info_s* pImgp_info, imgp_kernel_info_s* info)
+{
+	imgp_info_s query;
+	imgp_request_s request;
+	const imgp_kernel_s* kernel = NULL;
+	const imgp_plan_s* plan = NULL;
+	guint64 bytes = 0;
+	mm_util_img_format_e format = MM_UTIL_IMG_FMT_NUM;
+	unsigned int target_width = 0, target_height = 0;
+	unsigned int factor = 1;
+	int ret = MM_ERROR_NONE;
+
+	if(pImgp_info == NULL || info == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	/* a crop is processed as a source of its size */
+	ret = _mm_imgp_crop_source(&query, pImgp_info);
+	if(ret != MM_ERROR_NONE) {
+		return ret;
+	}
+
+	/* a thumbnail runs the implementation of the bilinear process of its source reduced as _mm_imgp_thumbnail does */
+	if(query.resize_filter == MM_UTIL_RESIZE_FILTER_THUMBNAIL) {
+		format = _mm_get_native_format(query.input_format_label);
+		target_width = (query.angle == MM_UTIL_ROTATE_90 || query.angle == MM_UTIL_ROTATE_270) ? query.dst_height : query.dst_width;
+		target_height = (query.angle == MM_UTIL_ROTATE_90 || query.angle == MM_UTIL_ROTATE_270) ? query.dst_width : query.dst_height;
+		while((factor = _mm_imgp_thumbnail_factor(query.src_width, query.src_height, target_width, target_height)) > 1
+			&& _mm_native_resize_supported(format, query.src_width, query.src_height, (query.src_width + factor - 1) / factor, (query.src_height + factor - 1) / factor)) {
+			query.src_width = (query.src_width + factor - 1) / factor;
+			query.src_height = (query.src_height + factor - 1) / factor;
+		}
+		query.resize_filter = MM_UTIL_RESIZE_FILTER_BILINEAR;
+	}
+
+	info->pipeline = "";
+	info->bytes = 0;
+	kernel = _mm_imgp_kernel_select(&query, &request);
+	if(kernel != NULL) {
+		info->tier = (kernel->simd && kernel->simd(&request) && _mm_native_get_isa() != IMGP_NATIVE_ISA_C) ? MM_UTIL_IMGP_TIER_NATIVE_SIMD : MM_UTIL_IMGP_TIER_NATIVE_C;
+		info->kernel = kernel->name;
+		info->isa = _mm_native_get_isa_name(info->tier == MM_UTIL_IMGP_TIER_NATIVE_SIMD ? _mm_native_get_isa() : IMGP_NATIVE_ISA_C);
+	}else if(_mm_imgp_pipeline_supported(&query)) {
+		info->tier = MM_UTIL_IMGP_TIER_GSTREAMER;
+		info->kernel = "pipeline";
+		info->isa = "";
+		plan = _mm_imgp_plan_select(query.input_format_label, query.src_width, query.src_height,
+			query.output_format_label, query.dst_width, query.dst_height, query.angle, &bytes);
+		if(plan != NULL) {
+			info->pipeline = plan->name;
+			info->bytes = bytes;
+		}
+	}else {
+		info->tier = MM_UTIL_IMGP_TIER_NONE;
+		info->kernel = "";
+		info->isa = "";
+		ret = MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s %dx%d -> %s %dx%d angle: %d: %s %s %s", __func__, __LINE__, query.input_format_label, query.src_width, query.src_height,
+		query.output_format_label, query.dst_width, query.dst_height, query.angle, info->kernel, info->isa, info->pipeline);
+	return ret;
+}
+
+static int
+_mm_imgp_batch_run(imgp_context_s* pContext, imgp_info_s* frames, unsigned int n, int* results)
+{
+	unsigned int pushed = 0;
+	unsigned int collected = 0;
+	int ret = MM_ERROR_NONE;
+
+	/* keep a few frames in the pipeline so that each element works on the next frame while the current one is collected */
+	while(collected < n) {
+		while(ret == MM_ERROR_NONE && pushed < n && pushed - collected < MM_UTIL_IMGP_BATCH_MAX_IN_FLIGHT) {
+			frames[pushed].output_stride = pContext->info.output_stride;
+			frames[pushed].output_elevation = pContext->info.output_elevation;
+			ret = _mm_imgp_context_submit(pContext, &frames[pushed]);
+			if(ret == MM_ERROR_NONE) {
+				pushed++;
+			}
+		}
+		if(collected == pushed) {
+			break;
+		}
+		results[collected] = _mm_imgp_context_collect(pContext, &frames[collected]);
+		if(results[collected] != MM_ERROR_NONE) {
+			ret = results[collected];
+			break; /* the pipeline is in error, nothing else will come out of it */
+		}
+		collected++;
+	}
+	_mm_imgp_context_reset(pContext);
+
+	for(; collected < n; collected++) {
+		if(results[collected] == MM_ERROR_NONE) {
+			results[collected] = ret;
+		}
+	}
+	return ret;
+}
+
+static int
+_mm_imgp_batch_needs_pipeline(imgp_info_s* pImgp_info)
+{
+	/* the reductions of a thumbnail come before its pipeline and a crop moves the planes, each such frame goes through _mm_imgp_gstcs */
+	return _mm_imgp_has_src(pImgp_info) && pImgp_info->dst != NULL && pImgp_info->resize_filter != MM_UTIL_RESIZE_FILTER_THUMBNAIL
+		&& !_mm_imgp_has_crop(pImgp_info) && _mm_imgp_native_select(pImgp_info) == NULL;
+}
+
+int
+mm_imgp_batch(imgp_info_s* frames, unsigned int n, imgp_type_e _imgp_type, int* results)
+{
+	imgp_context_s* pContext = NULL;
+	int* _results = results;
+	int first_error = MM_ERROR_NONE;
+	unsigned int i = 0;
+	unsigned int run = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(frames == NULL || n == 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	if(_results == NULL) {
+		_results = g_new0(int, n);
+	}else {
+		memset(_results, 0, sizeof(int) * n);
+	}
+	_mm_imgp_timing_call_begin();
+
+	while(i < n) {
+		if(!_mm_imgp_batch_needs_pipeline(&frames[i])) {
+			/* invalid frames and frames of the native converter do not need a pipeline */
+			_results[i] = _mm_imgp_gstcs(&frames[i]);
+			run = 1;
+		}else {
+			ret = _mm_imgp_cache_acquire(&frames[i], &pContext);
+			if(ret != MM_ERROR_NONE) {
+				mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to get a pipeline for frame %d", __func__, __LINE__, i);
+				_results[i] = ret;
+				run = 1;
+			}else {
+				/* consecutive frames of the same geometry go through the same pipeline */
+				for(run = 1; i + run < n; run++) {
+					if(!_mm_imgp_batch_needs_pipeline(&frames[i + run]) || !_mm_imgp_context_match(pContext, &frames[i + run])) {
+						break;
+					}
+				}
+				mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] frames %d - %d through context %p", __func__, __LINE__, i, i + run - 1, pContext);
+				ret = _mm_imgp_batch_run(pContext, &frames[i], run, &_results[i]);
+				_mm_imgp_cache_release(pContext, ret == MM_ERROR_NONE);
+				pContext = NULL;
+			}
+		}
+		for(; run > 0; run--, i++) {
+			if(first_error == MM_ERROR_NONE && _results[i] != MM_ERROR_NONE) {
+				first_error = _results[i];
+			}
+		}
+	}
+
+	_mm_imgp_timing_call_end();
+	if(_results != results) {
+		g_free(_results);
+	}
+	return first_error;
+}
+
+/* rows [src_start, src_end) of the source which the rows [y_start, y_end) of a banded output read */
+static void
+_mm_imgp_fanout_src_rows(imgp_fanout_s* pOutput, unsigned int y_start, unsigned int y_end, unsigned int* src_start, unsigned int* src_end)
+{
+	if(pOutput->func == _mm_native_resize_rows) {
+		_mm_native_resize_src_rows(&pOutput->op, y_start, y_end, src_start, src_end);
+	}else if(pOutput->func == _mm_native_fused_rows) {
+		_mm_native_fused_src_rows(&pOutput->op, y_start, y_end, src_start, src_end);
+	}else {
+		*src_start = y_start;
+		*src_end = y_end;
+	}
+}
+
+static void
+_mm_imgp_fanout_setup(imgp_fanout_s* pOutput, imgp_info_s* pOutput_info, imgp_info_s* pSource)
+{
+	memcpy(&pOutput->info, pOutput_info, sizeof(imgp_info_s));
+	pOutput->info.src = pSource->src;
+	memcpy(pOutput->info.input_format_label, pSource->input_format_label, sizeof(pOutput->info.input_format_label));
+	pOutput->info.src_format = pSource->src_format;
+	pOutput->info.src_width = pSource->src_width;
+	pOutput->info.src_height = pSource->src_height;
+	memcpy(pOutput->info.src_planes, pSource->src_planes, sizeof(pOutput->info.src_planes));
+	memcpy(pOutput->info.src_strides, pSource->src_strides, sizeof(pOutput->info.src_strides));
+	/* pSource is already the crop of the source */
+	pOutput->info.src_crop_x = 0;
+	pOutput->info.src_crop_y = 0;
+	pOutput->info.src_crop_width = 0;
+	pOutput->info.src_crop_height = 0;
+
+	if(!_mm_imgp_has_src(&pOutput->info) || pOutput->info.dst == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] src or dst is NULL", __func__, __LINE__);
+		pOutput->ret = MM_ERROR_IMAGE_INVALID_VALUE;
+		return;
+	}
+	/* a thumbnail reduces the source itself before its precise resize */
+	if(pOutput->info.resize_filter == MM_UTIL_RESIZE_FILTER_THUMBNAIL) {
+		return;
+	}
+	pOutput->func = _mm_imgp_native_select(&pOutput->info);
+	if(pOutput->func == NULL) {
+		return;
+	}
+	pOutput->ret = _mm_imgp_src_frame_init(&pOutput->src, &pOutput->info);
+	if(pOutput->ret == MM_ERROR_NONE) {
+		pOutput->ret = _mm_imgp_dst_frame_init(&pOutput->dst, &pOutput->info);
+	}
+	if(pOutput->ret == MM_ERROR_NONE) {
+		pOutput->op.src = &pOutput->src;
+		pOutput->op.dst = &pOutput->dst;
+		pOutput->op.angle = pOutput->info.angle;
+		pOutput->op.filter = pOutput->info.resize_filter;
+		pOutput->op.coeffs = _mm_native_get_coeffs(pOutput->info.color_matrix, pOutput->info.color_range);
+		if(pOutput->func == _mm_native_resize_rows) {
+			pOutput->ret = _mm_native_resize_prepare(&pOutput->op);
+		}
+	}
+	_mm_set_output_stride_elevation(&pOutput->info);
+	pOutput->banded = (pOutput->func == _mm_native_csc_rows || pOutput->func == _mm_native_resize_rows
+		|| (pOutput->func == _mm_native_fused_rows && (pOutput->info.angle == MM_UTIL_ROTATE_0 || pOutput->info.angle == MM_UTIL_ROTATE_FLIP_HORZ)));
+}
+
+static gboolean
+_mm_imgp_fanout_needs_pipeline(imgp_fanout_s* pOutput)
+{
+	return pOutput->ret == MM_ERROR_NONE && pOutput->func == NULL && pOutput->info.resize_filter != MM_UTIL_RESIZE_FILTER_THUMBNAIL;
+}
+
+/* planes of the source which are not laid out as a packed buffer are packed once for every pipeline, NULL when they need not be */
+static unsigned char*
+_mm_imgp_fanout_pack_source(imgp_fanout_s* fanout, unsigned int n)
+{
+	imgp_frame_s planes_frame, packed_frame;
+	unsigned char* packed = NULL;
+	gint64 start = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < n && !_mm_imgp_fanout_needs_pipeline(&fanout[i]); i++);
+	if(i == n || fanout[i].info.src_planes[0] == NULL
+		|| _mm_imgp_src_frame_init(&planes_frame, &fanout[i].info) != MM_ERROR_NONE
+		|| _mm_native_frame_init(&packed_frame, planes_frame.format, planes_frame.width, planes_frame.height, planes_frame.data[0]) != MM_ERROR_NONE
+		|| memcmp(&planes_frame, &packed_frame, sizeof(imgp_frame_s)) == 0) {
+		return NULL;
+	}
+	start = _mm_imgp_timing_start();
+	packed = (unsigned char*) _mm_imgp_pool_alloc(mm_setup_image_size(fanout[i].info.input_format_label, fanout[i].info.src_width, fanout[i].info.src_height));
+	if(packed != NULL) {
+		_mm_native_frame_init(&packed_frame, planes_frame.format, planes_frame.width, planes_frame.height, packed);
+		_mm_native_frame_copy(&packed_frame, &planes_frame);
+		for(; i < n; i++) {
+			if(_mm_imgp_fanout_needs_pipeline(&fanout[i])) {
+				fanout[i].info.src = packed;
+				memset(fanout[i].info.src_planes, 0, sizeof(fanout[i].info.src_planes));
+				memset(fanout[i].info.src_strides, 0, sizeof(fanout[i].info.src_strides));
+			}
+		}
+	}
+	_mm_imgp_timing_end(IMGP_STAGE_COPY, start);
+	return packed;
+}
+
+/* the source is walked once in bands which stay in the cache, every banded output converts the rows of dst the band completes */
+static void
+_mm_imgp_fanout_bands(imgp_fanout_s* fanout, unsigned int n)
+{
+	imgp_fanout_s* pOutput = NULL;
+	const imgp_frame_s* src = NULL;
+	unsigned int band_rows = 0, row_bytes = 0, avail = 0;
+	unsigned int y_end = 0, next = 0, src_start = 0, src_end = 0;
+	unsigned int i = 0;
+	gint64 start = 0;
+
+	for(i = 0; i < n && !(fanout[i].banded && fanout[i].ret == MM_ERROR_NONE); i++);
+	if(i == n) {
+		return;
+	}
+	src = &fanout[i].src;
+	row_bytes = _mm_format_get_size(_mm_format_get_desc(src->format), src->width, 2) / 2;
+	band_rows = MAX((MM_UTIL_IMGP_FANOUT_BAND_BYTES / MAX(row_bytes, 1)) & ~1u, 2);
+
+	start = _mm_imgp_timing_start();
+	while(avail < src->height) {
+		avail = MIN(avail + band_rows, src->height);
+		for(i = 0; i < n; i++) {
+			pOutput = &fanout[i];
+			if(!pOutput->banded || pOutput->ret != MM_ERROR_NONE) {
+				continue;
+			}
+			for(y_end = pOutput->y; y_end < pOutput->dst.height; y_end = next) {
+				next = MIN(y_end + 2, pOutput->dst.height);
+				_mm_imgp_fanout_src_rows(pOutput, y_end, next, &src_start, &src_end);
+				if(src_end > avail) {
+					break;
+				}
+			}
+			if(y_end > pOutput->y) {
+				pOutput->ret = _mm_imgp_run_stripes_range(pOutput->func, &pOutput->op, pOutput->y, y_end, pOutput->info.thread_count);
+				pOutput->y = y_end;
+			}
+		}
+	}
+	_mm_imgp_timing_end(IMGP_STAGE_NATIVE, start);
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %u rows of the source in bands of %u rows", __func__, __LINE__, src->height, band_rows);
+}
+
+int
+mm_imgp_fanout(imgp_info_s* outputs, unsigned int n, imgp_type_e _imgp_type, int* results)
+{
+	imgp_fanout_s* fanout = NULL;
+	imgp_fanout_s* pOutput = NULL;
+	imgp_info_s source;
+	unsigned char* packed = NULL;
+	int first_error = MM_ERROR_NONE;
+	unsigned int i = 0;
+	gint64 start = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(outputs == NULL || n == 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	/* the crop of outputs[0] is the one of the source, every output is made of the rectangle */
+	ret = _mm_imgp_crop_source(&source, &outputs[0]);
+	if(ret != MM_ERROR_NONE) {
+		for(i = 0; results && i < n; i++) {
+			results[i] = ret;
+		}
+		return ret;
+	}
+	fanout = g_new0(imgp_fanout_s, n);
+	_mm_imgp_timing_call_begin();
+
+	for(i = 0; i < n; i++) {
+		_mm_imgp_fanout_setup(&fanout[i], &outputs[i], &source);
+	}
+
+	/* the frame is pushed to the pipelines first, they convert it in their threads while the native kernels run */
+	packed = _mm_imgp_fanout_pack_source(fanout, n);
+	for(i = 0; i < n; i++) {
+		pOutput = &fanout[i];
+		if(!_mm_imgp_fanout_needs_pipeline(pOutput)) {
+			continue;
+		}
+		pOutput->ret = _mm_imgp_cache_acquire(&pOutput->info, &pOutput->context);
+		if(pOutput->ret == MM_ERROR_NONE) {
+			pOutput->ret = _mm_imgp_context_submit(pOutput->context, &pOutput->info);
+		}
+		if(pOutput->ret != MM_ERROR_NONE && pOutput->context) {
+			_mm_imgp_context_reset(pOutput->context);
+			_mm_imgp_cache_release(pOutput->context, FALSE);
+			pOutput->context = NULL;
+		}
+	}
+
+	_mm_imgp_fanout_bands(fanout, n);
+	for(i = 0; i < n; i++) {
+		pOutput = &fanout[i];
+		if(pOutput->ret != MM_ERROR_NONE) {
+			continue;
+		}
+		if(pOutput->func != NULL && !pOutput->banded) {
+			start = _mm_imgp_timing_start();
+			pOutput->ret = _mm_imgp_run_stripes(pOutput->func, &pOutput->op, pOutput->info.thread_count);
+			_mm_imgp_timing_end(IMGP_STAGE_NATIVE, start);
+		}else if(pOutput->func == NULL && pOutput->context == NULL) {
+			pOutput->ret = _mm_imgp_gstcs(&pOutput->info);
+		}
+	}
+
+	for(i = 0; i < n; i++) {
+		pOutput = &fanout[i];
+		if(pOutput->context) {
+			pOutput->ret = _mm_imgp_context_collect(pOutput->context, &pOutput->info);
+			_mm_imgp_context_reset(pOutput->context);
+			_mm_imgp_cache_release(pOutput->context, pOutput->ret == MM_ERROR_NONE);
+		}
+		_mm_native_resize_release(&pOutput->op);
+		outputs[i].output_stride = pOutput->info.output_stride;
+		outputs[i].output_elevation = pOutput->info.output_elevation;
+		if(results) {
+			results[i] = pOutput->ret;
+		}
+		if(first_error == MM_ERROR_NONE && pOutput->ret != MM_ERROR_NONE) {
+			first_error = pOutput->ret;
+		}
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] output %u: %s %ux%u angle: %d %s ret: %d", __func__, __LINE__, i, pOutput->info.output_format_label,
+			pOutput->info.dst_width, pOutput->info.dst_height, pOutput->info.angle, pOutput->func ? (pOutput->banded ? "banded" : "native") : "pipeline", pOutput->ret);
+	}
+
+	_mm_imgp_pool_free(packed);
+	_mm_imgp_timing_call_end();
+	g_free(fanout);
+	return first_error;
+}
+
+static int
+_mm_imgp_context_create(imgp_context_h *context, imgp_info_s* pImgp_info, imgp_type_e _imgp_type)
+{
+	imgp_context_s* pContext = NULL;
+	gstreamer_s* pGstreamer_s = NULL;
+	GstBus *bus = NULL;
+	GstPad *sinkpad = NULL;
+	GstStateChangeReturn ret_state;
+	gint64 start = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(context == NULL || pImgp_info == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	*context = NULL;
+
+	/* the pipeline or the kernels are set up for the rectangle, _mm_imgp_context_run crops every frame */
+	if(_mm_imgp_has_crop(pImgp_info)) {
+		imgp_info_s cropped;
+
+		ret = _mm_imgp_crop_source(&cropped, pImgp_info);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_imgp_context_create(context, &cropped, _imgp_type);
+		}
+		if(ret == MM_ERROR_NONE) {
+			pContext = (imgp_context_s*) *context;
+			memcpy(&pContext->source, pImgp_info, sizeof(imgp_info_s));
+			pImgp_info->output_stride = cropped.output_stride;
+			pImgp_info->output_elevation = cropped.output_elevation;
+		}
+		return ret;
+	}
+
+	if(_mm_imgp_native_select(pImgp_info) != NULL) {
+		pContext = g_new0(imgp_context_s, 1);
+		_mm_set_output_stride_elevation(pImgp_info);
+		memcpy(&pContext->info, pImgp_info, sizeof(imgp_info_s));
+		_mm_imgp_context_clear_frame(pContext);
+		pContext->native = TRUE;
+		*context = (imgp_context_h)pContext;
+		return MM_ERROR_NONE;
+	}
+
+	if(!(__mm_check_resize_format(pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height)
+		&& __mm_check_rotate_format(pImgp_info->angle, pImgp_info->input_format_label, pImgp_info->output_format_label))) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] Error - Check your input / ouput image input_format_label: %s output_format_label: %s angle: %d", __func__, __LINE__,
+			pImgp_info->input_format_label, pImgp_info->output_format_label, pImgp_info->angle);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	if(!_mm_imgp_pipeline_colorimetry_supported(pImgp_info)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %s -> %s with color matrix %d range %d can not be converted by a pipeline", __func__, __LINE__,
+			pImgp_info->input_format_label, pImgp_info->output_format_label, pImgp_info->color_matrix, pImgp_info->color_range);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	start = _mm_imgp_timing_start();
+	ret = _mm_imgp_gst_init();
+	_mm_imgp_timing_end(IMGP_STAGE_PIPELINE_CREATE, start);
+	if(ret != MM_ERROR_NONE) {
+		return ret;
+	}
+
+	start = _mm_imgp_timing_start();
+	pContext = g_new0(imgp_context_s, 1);
+	pContext->input_format = _mm_set_input_image_format_s_struct(pImgp_info);
+	pContext->output_format = _mm_set_output_image_format_s_struct(pImgp_info);
+	_mm_imgp_timing_end(IMGP_STAGE_FORMAT_SETUP, start);
+	pImgp_info->output_stride = pContext->output_format->stride;
+	pImgp_info->output_elevation = pContext->output_format->elevation;
+	memcpy(&pContext->info, pImgp_info, sizeof(imgp_info_s));
+	_mm_imgp_context_clear_frame(pContext);
+
+	pGstreamer_s = g_new0(gstreamer_s, 1);
+	g_mutex_init(&pGstreamer_s->lock);
+	g_cond_init(&pGstreamer_s->cond);
+	g_queue_init(&pGstreamer_s->output_buffers);
+	g_queue_init(&pGstreamer_s->dsts);
+	pContext->gstreamer = pGstreamer_s;
+
+	start = _mm_imgp_timing_start();
+	ret = _mm_create_pipeline(pGstreamer_s);
+	_mm_imgp_timing_end(IMGP_STAGE_PIPELINE_CREATE, start);
+	if(ret != MM_ERROR_NONE) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] ERROR - mm_create_pipeline ", __func__, __LINE__);
+		_mm_imgp_context_free(pContext);
+		return ret;
+	}
+
+	start = _mm_imgp_timing_start();
+	bus = gst_pipeline_get_bus (GST_PIPELINE (pGstreamer_s->pipeline));
+	gst_bus_set_sync_handler (bus, _mm_context_bus_sync_handler, pGstreamer_s);
+	gst_object_unref(bus);
+
+	_mm_link_pipeline(pGstreamer_s, pContext->input_format, pContext->output_format, pImgp_info->angle);
+	g_object_set(pGstreamer_s->videoscale, "method", _mm_get_videoscale_method(pImgp_info->resize_filter), NULL);
+	g_object_set(pGstreamer_s->appsrc, "num-buffers", -1, NULL); /* the stream stays open for every frame of the context */
+
+	/* output buffers are allocated in the dst of the caller, appsink must not keep them after the frame */
+	g_object_set(pGstreamer_s->appsink, "enable-last-buffer", FALSE, NULL);
+	sinkpad = gst_element_get_static_pad(pGstreamer_s->appsink, "sink");
+	g_object_set_data(G_OBJECT(sinkpad), MM_UTIL_IMGP_GSTREAMER_KEY, pGstreamer_s);
+	gst_pad_set_bufferalloc_function(sinkpad, _mm_sink_buffer_alloc);
+	gst_object_unref(sinkpad);
+	g_signal_connect (pGstreamer_s->appsink, "new-buffer",  G_CALLBACK (_mm_context_sink_buffer), pGstreamer_s);
+	gst_app_sink_set_emit_signals ((GstAppSink*)pGstreamer_s->appsink, TRUE);
+	_mm_imgp_timing_end(IMGP_STAGE_LINK, start);
+
+	start = _mm_imgp_timing_start();
+	ret_state = gst_element_set_state (pGstreamer_s->pipeline, GST_STATE_PLAYING);
+	if(ret_state != GST_STATE_CHANGE_FAILURE) {
+		ret_state = gst_element_get_state (pGstreamer_s->pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+	}
+	_mm_imgp_timing_end(IMGP_STAGE_PLAYING, start);
+	if(ret_state == GST_STATE_CHANGE_FAILURE) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] GST_STATE_CHANGE_FAILURE", __func__, __LINE__);
+		_mm_imgp_context_free(pContext);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] context: %p GST_STATE_PLAYING ret_state: %d", __func__, __LINE__, pContext, ret_state);
+
+	*context = (imgp_context_h)pContext;
+	return ret;
+}
+
+int
+mm_imgp_context_create(imgp_context_h *context, imgp_info_s* pImgp_info, imgp_type_e _imgp_type)
+{
+	int ret = MM_ERROR_NONE;
+
+	_mm_imgp_timing_call_begin();
+	ret = _mm_imgp_context_create(context, pImgp_info, _imgp_type);
+	_mm_imgp_timing_call_end();
+	return ret;
+}
+
+int
+mm_imgp_context_process(imgp_context_h context, unsigned char *src, unsigned char *dst)
+{
+	imgp_context_s* pContext = (imgp_context_s*)context;
+	imgp_info_s frame;
+	int ret = MM_ERROR_NONE;
+
+	if(pContext == NULL || src == NULL || dst == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	_mm_imgp_timing_call_begin();
+	memset(&frame, 0, sizeof(imgp_info_s));
+	frame.src = src;
+	frame.dst = dst;
+	ret = _mm_imgp_context_run(pContext, &frame);
+	_mm_imgp_timing_call_end();
+	return ret;
+}
+
+int
+mm_imgp_context_destroy(imgp_context_h context)
+{
+	if(context == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	_mm_imgp_timing_call_begin();
+	_mm_imgp_context_free((imgp_context_s*)context);
+	_mm_imgp_timing_call_end();
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_cache_set_size(unsigned int max_size)
+{
+	GSList* _evicted = NULL;
+
+	G_LOCK(imgp_cache);
+	_mm_imgp_cache_size = max_size;
+	while(g_queue_get_length(&_mm_imgp_cache) > _mm_imgp_cache_size) {
+		_evicted = g_slist_prepend(_evicted, g_queue_pop_tail(&_mm_imgp_cache));
+		_mm_imgp_cache_stats.evictions++;
+	}
+	G_UNLOCK(imgp_cache);
+
+	while(_evicted) {
+		_mm_imgp_context_free((imgp_context_s*)_evicted->data);
+		_evicted = g_slist_delete_link(_evicted, _evicted);
+	}
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_cache_get_stats(imgp_cache_stats_s *stats)
+{
+	if(stats == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	G_LOCK(imgp_cache);
+	memcpy(stats, &_mm_imgp_cache_stats, sizeof(imgp_cache_stats_s));
+	stats->count = g_queue_get_length(&_mm_imgp_cache);
+	stats->max_size = _mm_imgp_cache_size;
+	G_UNLOCK(imgp_cache);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_cache_flush(void)
+{
+	GList* _flushed = NULL;
+	GList* _list = NULL;
+
+	G_LOCK(imgp_cache);
+	_flushed = _mm_imgp_cache.head;
+	g_queue_init(&_mm_imgp_cache);
+	G_UNLOCK(imgp_cache);
+
+	for(_list = _flushed; _list != NULL; _list = _list->next) {
+		_mm_imgp_context_free((imgp_context_s*)_list->data);
+	}
+	g_list_free(_flushed);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_prewarm(void)
+{
+	imgp_context_h context = NULL;
+	imgp_info_s info;
+	imgp_info_s frame;
+	unsigned char* src = NULL;
+	unsigned char* dst = NULL;
+	int ret = MM_ERROR_NONE;
+
+	/* the cpu probe of the native kernels and their stripe workers */
+	_mm_native_get_kernels();
+	_mm_imgp_get_stripe_pool();
+
+	ret = _mm_imgp_gst_init();
+	if(ret != MM_ERROR_NONE) {
+		return ret;
+	}
+
+	/* a frame through a small pipeline which the native kernels do not handle: the classes of the elements,
+	 * the caps negotiation and the tables of ffmpegcolorspace are set up once for the process */
+	memset(&info, 0, sizeof(imgp_info_s));
+	g_strlcpy(info.input_format_label, "Y42B", IMAGE_FORMAT_LABEL_BUFFER_SIZE);
+	g_strlcpy(info.output_format_label, "I420", IMAGE_FORMAT_LABEL_BUFFER_SIZE);
+	info.src_width = info.dst_width = MM_UTIL_IMGP_PREWARM_SIZE;
+	info.src_height = info.dst_height = MM_UTIL_IMGP_PREWARM_SIZE;
+	ret = _mm_imgp_context_create(&context, &info, IMGP_CSC);
+	if(ret == MM_ERROR_NONE) {
+		src = g_malloc0(mm_setup_image_size(info.input_format_label, info.src_width, info.src_height));
+		dst = g_malloc0(mm_setup_image_size(info.output_format_label, info.dst_width, info.dst_height));
+		memset(&frame, 0, sizeof(imgp_info_s));
+		frame.src = src;
+		frame.dst = dst;
+		ret = _mm_imgp_context_run((imgp_context_s*)context, &frame);
+		_mm_imgp_context_free((imgp_context_s*)context);
+		g_free(src);
+		g_free(dst);
+	}
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] ret: %d", __func__, __LINE__, ret);
+	return ret;
+}
+
+static void
+_mm_imgp_async_worker(gpointer data, gpointer user_data)
+{
+	imgp_job_s* pJob = (imgp_job_s*) data;
+	int ret = MM_ERROR_NONE;
+
+	ret = mm_imgp(&pJob->info, pJob->type);
+
+	/* the threads of the pool are shared with the other pools of the process, the flag only covers the callback */
+	_mm_imgp_async_in_worker = TRUE;
+	pJob->completed_cb(&pJob->info, ret, pJob->user_data);
+	_mm_imgp_async_in_worker = FALSE;
+	g_free(pJob);
+
+	g_mutex_lock(&_mm_imgp_async_lock);
+	_mm_imgp_async_pending--;
+	g_cond_broadcast(&_mm_imgp_async_cond);
+	g_mutex_unlock(&_mm_imgp_async_lock);
+}
+
+int
+mm_imgp_async(imgp_info_s* pImgp_info, imgp_type_e _imgp_type, imgp_completed_cb completed_cb, void* user_data)
+{
+	imgp_job_s* pJob = NULL;
+	GError* err = NULL;
+
+	if(pImgp_info == NULL || completed_cb == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	g_mutex_lock(&_mm_imgp_async_lock);
+	if(_mm_imgp_async_pool == NULL) {
+		_mm_imgp_async_pool = g_thread_pool_new(_mm_imgp_async_worker, NULL, MM_UTIL_IMGP_ASYNC_THREADS, FALSE, &err);
+		if(_mm_imgp_async_pool == NULL) {
+			g_mutex_unlock(&_mm_imgp_async_lock);
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to create the job pool: %s", __func__, __LINE__, err ? err->message : "");
+			g_clear_error(&err);
+			return MM_ERROR_IMAGE_INTERNAL;
+		}
+	}
+	/* the submitter waits for a free slot so that a fast producer can not queue an unbounded amount of frames.
+	 * A job chained from completed_cb goes over the limit: the pool threads would all wait for a slot only they can free */
+	while(_mm_imgp_async_pending >= MM_UTIL_IMGP_ASYNC_MAX_JOBS && !_mm_imgp_async_in_worker) {
+		g_cond_wait(&_mm_imgp_async_cond, &_mm_imgp_async_lock);
+	}
+	_mm_imgp_async_pending++;
+	g_mutex_unlock(&_mm_imgp_async_lock);
+
+	pJob = g_new0(imgp_job_s, 1);
+	memcpy(&pJob->info, pImgp_info, sizeof(imgp_info_s));
+	pJob->type = _imgp_type;
+	pJob->completed_cb = completed_cb;
+	pJob->user_data = user_data;
+
+	if(!g_thread_pool_push(_mm_imgp_async_pool, pJob, &err)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to queue the job: %s", __func__, __LINE__, err ? err->message : "");
+		g_clear_error(&err);
+		g_free(pJob);
+		g_mutex_lock(&_mm_imgp_async_lock);
+		_mm_imgp_async_pending--;
+		g_cond_broadcast(&_mm_imgp_async_cond);
+		g_mutex_unlock(&_mm_imgp_async_lock);
+		return MM_ERROR_IMAGE_INTERNAL;
+	}
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_async_wait_all(void)
+{
+	/* the job of the calling completed_cb is pending until it returns */
+	if(_mm_imgp_async_in_worker) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] can not wait for the jobs from completed_cb", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	g_mutex_lock(&_mm_imgp_async_lock);
+	while(_mm_imgp_async_pending > 0) {
+		g_cond_wait(&_mm_imgp_async_cond, &_mm_imgp_async_lock);
+	}
+	g_mutex_unlock(&_mm_imgp_async_lock);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_timing_set_enabled(int enable)
+{
+	_mm_imgp_timing_init();
+	g_atomic_int_set(&_mm_imgp_timing_enabled, enable ? 1 : 0);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_timing_get(imgp_timing_s *timing)
+{
+	if(timing == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	G_LOCK(imgp_timing);
+	memcpy(timing, &_mm_imgp_timing, sizeof(imgp_timing_s));
+	G_UNLOCK(imgp_timing);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_timing_reset(void)
+{
+	G_LOCK(imgp_timing);
+	memset(&_mm_imgp_timing, 0, sizeof(imgp_timing_s));
+	G_UNLOCK(imgp_timing);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_timing_dump(const char *path)
+{
+	imgp_timing_s timing;
+	FILE* fp = NULL;
+	int i = 0;
+
+	if(path == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	fp = fopen(path, "a");
+	if(fp == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to open %s", __func__, __LINE__, path);
+		return MM_ERROR_IMAGE_FILEOPEN;
+	}
+
+	mm_imgp_timing_get(&timing);
+	fprintf(fp, "[mm_imgp timing] pid: %d calls: %llu\n", (int) getpid(), timing.calls);
+	fprintf(fp, "%-16s %10s %14s %12s %12s %14s\n", "stage", "count", "total_us", "avg_us", "max_us", "last_call_us");
+	for(i = 0; i < IMGP_STAGE_NUM; i++) {
+		fprintf(fp, "%-16s %10llu %14llu %12llu %12llu %14llu\n", _mm_imgp_stage_names[i], timing.stage[i].count, timing.stage[i].total_us,
+			timing.stage[i].count ? timing.stage[i].total_us / timing.stage[i].count : 0, timing.stage[i].max_us, timing.stage[i].last_call_us);
+	}
+	fclose(fp);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_stream(imgp_info_s* pImgp_info, imgp_type_e _imgp_type, unsigned int band_height,
+	imgp_stream_read_cb read_cb, imgp_stream_write_cb write_cb, void* user_data)
+{
+	imgp_stream_s stream;
+	imgp_native_op_s op;
+	int ret = MM_ERROR_NONE;
+
+	if(pImgp_info == NULL || read_cb == NULL || write_cb == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	memset(&stream, 0, sizeof(imgp_stream_s));
+	memset(&op, 0, sizeof(imgp_native_op_s));
+	stream.read_cb = read_cb;
+	stream.write_cb = write_cb;
+	stream.user_data = user_data;
+
+	_mm_imgp_timing_call_begin();
+	ret = _mm_imgp_stream_setup(&stream, &op, pImgp_info, band_height);
+	if(ret == MM_ERROR_NONE) {
+		_mm_set_output_stride_elevation(pImgp_info);
+		ret = _mm_imgp_stream_run(&stream, &op);
+	}
+	_mm_imgp_stream_release(&stream, &op);
+	_mm_imgp_timing_call_end();
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] %s -> %s ret: %d", __func__, __LINE__, pImgp_info->input_format_label, pImgp_info->output_format_label, ret);
+	return ret;
+}
+
+int
+mm_imgp_stream_file(imgp_info_s* pImgp_info, imgp_type_e _imgp_type, unsigned int band_height, const char* src_path, const char* dst_path)
+{
+	imgp_stream_file_s files[2]; /* the source and dst, both callbacks take them */
+	int ret = MM_ERROR_NONE;
+
+	if(pImgp_info == NULL || src_path == NULL || dst_path == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	memset(files, 0, sizeof(files));
+	ret = _mm_imgp_stream_file_open(&files[0], src_path, pImgp_info->input_format_label, pImgp_info->src_width, pImgp_info->src_height, FALSE);
+	if(ret == MM_ERROR_NONE) {
+		ret = _mm_imgp_stream_file_open(&files[1], dst_path, pImgp_info->output_format_label, pImgp_info->dst_width, pImgp_info->dst_height, TRUE);
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = mm_imgp_stream(pImgp_info, _imgp_type, band_height, _mm_imgp_stream_file_read, _mm_imgp_stream_file_write, files);
+	}
+	_mm_imgp_stream_file_close(&files[0]);
+	_mm_imgp_stream_file_close(&files[1]);
+	return ret;
 }
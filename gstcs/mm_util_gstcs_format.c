@@ -0,0 +1,170 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_format.h"
+
+#define IMGP_FOURCC(a, b, c, d) ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+/* planes:                 width_align, height_align, x_shift, y_shift, pixel_bytes, stride_align */
+#define IMGP_PLANE_LUMA_420    { 4, 2, 0, 0, 1, 1 }   /* stride ROUND_UP_4(width), ROUND_UP_2(height) rows */
+#define IMGP_PLANE_CHROMA_420  { 8, 2, 1, 1, 1, 1 }   /* stride ROUND_UP_8(width) / 2 */
+#define IMGP_PLANE_LUMA_422    { 4, 1, 0, 0, 1, 1 }
+#define IMGP_PLANE_CHROMA_422  { 8, 1, 1, 0, 1, 1 }
+#define IMGP_PLANE_444         { 4, 1, 0, 0, 1, 1 }
+#define IMGP_PLANE_CHROMA_NV12 { 4, 2, 0, 1, 1, 1 }   /* interleaved CbCr, stride of the luma */
+#define IMGP_PLANE_PACKED_422  { 2, 1, 0, 0, 2, 1 }   /* stride ROUND_UP_2(width) * 2 */
+#define IMGP_PLANE_RGB16       { 1, 1, 0, 0, 2, 4 }   /* stride ROUND_UP_4(width * 2) */
+#define IMGP_PLANE_RGB24       { 1, 1, 0, 0, 3, 4 }   /* stride ROUND_UP_4(width * 3) */
+#define IMGP_PLANE_RGB32       { 1, 1, 0, 0, 4, 1 }
+#define IMGP_PLANE_LUMA_TILED   { 128, 32, 0, 0, 1, 1 }  /* rows of 64x32 tiles, pairs of tiles wide */
+#define IMGP_PLANE_CHROMA_TILED { 128, 64, 0, 1, 1, 1 }  /* interleaved CbCr in tiles of 32 pairs x 32 rows */
+
+#define IMGP_FORMAT_YUV(_format, _label, a, b, c, d, _flags, _count, ...) \
+	[_format] = { .format = _format, .label = _label, .colorspace = "YUV", .fourcc = IMGP_FOURCC(a, b, c, d), \
+		.plane_count = _count, .plane = { __VA_ARGS__ }, .flags = _flags }
+
+#define IMGP_FORMAT_RGB(_format, _label, _colorspace, _bpp, _depth, _red, _green, _blue, _alpha, _endianness, _flags, _plane) \
+	[_format] = { .format = _format, .label = _label, .colorspace = _colorspace, \
+		.bpp = _bpp, .depth = _depth, .red_mask = _red, .green_mask = _green, .blue_mask = _blue, .alpha_mask = _alpha, .endianness = _endianness, \
+		.plane_count = 1, .plane = { _plane }, .flags = _flags }
+
+#define IMGP_RSZ IMGP_FORMAT_FLAG_RESIZE
+#define IMGP_ROT IMGP_FORMAT_FLAG_ROTATE
+
+static const imgp_format_desc_s _mm_format_table[MM_UTIL_IMG_FMT_NUM] = {
+	/* YUV420 has the layout of I420, which is the label used for both */
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_YUV420, "I420", 'I', '4', '2', '0', IMGP_RSZ | IMGP_ROT, 3, IMGP_PLANE_LUMA_420, IMGP_PLANE_CHROMA_420, IMGP_PLANE_CHROMA_420),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_YUV422, "Y42B", 'Y', '4', '2', 'B', IMGP_RSZ, 3, IMGP_PLANE_LUMA_422, IMGP_PLANE_CHROMA_422, IMGP_PLANE_CHROMA_422),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_I420, "I420", 'I', '4', '2', '0', IMGP_RSZ | IMGP_ROT, 3, IMGP_PLANE_LUMA_420, IMGP_PLANE_CHROMA_420, IMGP_PLANE_CHROMA_420),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_NV12, "NV12", 'N', 'V', '1', '2', 0, 2, IMGP_PLANE_LUMA_420, IMGP_PLANE_CHROMA_NV12),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_UYVY, "UYVY", 'U', 'Y', 'V', 'Y', IMGP_RSZ | IMGP_ROT, 1, IMGP_PLANE_PACKED_422),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_YUYV, "YUYV", 'Y', 'U', 'Y', '2', IMGP_RSZ | IMGP_ROT, 1, IMGP_PLANE_PACKED_422),
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_RGB565, "RGB565", "RGB", 16, 16, 0xf800, 0x07e0, 0x001f, 0, 1234, IMGP_RSZ, IMGP_PLANE_RGB16),
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_RGB888, "RGB888", "RGB", 24, 24, 0xff0000, 0x00ff00, 0x0000ff, 0, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB24),
+	/* [Low Address] A R G B [High Address] */
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_ARGB8888, "ARGB8888", "RGBA", 32, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, (int)0xff000000, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB32),
+	/* [Low Address] B G R A [High Address] */
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_BGRA8888, "BGRA8888", "RGBA", 32, 32, 0x0000ff00, 0x00ff0000, (int)0xff000000, 0x000000ff, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB32),
+	/* [Low Address] R G B A [High Address] */
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_RGBA8888, "RGBA8888", "RGBA", 32, 32, (int)0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB32),
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_BGRX8888, "BGRX", "BGRX", 32, 24, 0x0000ff00, 0x00ff0000, (int)0xff000000, 0, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB32),
+	/* 64x32 tiles of the s5pc110 decoder in Z flipped Z order, only the native kernels know it: it has no fourcc for the caps.
+	 * The stride of a plane is the bytes of a row of tiles divided by the tile height */
+	[MM_UTIL_IMG_FMT_NV12_TILED] = { .format = MM_UTIL_IMG_FMT_NV12_TILED, .label = "NV12T", .colorspace = "YUV",
+		.plane_count = 2, .plane = { IMGP_PLANE_LUMA_TILED, IMGP_PLANE_CHROMA_TILED }, .flags = IMGP_FORMAT_FLAG_TILED },
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_YV12, "YV12", 'Y', 'V', '1', '2', IMGP_RSZ | IMGP_ROT, 3, IMGP_PLANE_LUMA_420, IMGP_PLANE_CHROMA_420, IMGP_PLANE_CHROMA_420),
+	IMGP_FORMAT_YUV(MM_UTIL_IMG_FMT_Y444, "Y444", 'Y', '4', '4', '4', IMGP_RSZ | IMGP_ROT, 3, IMGP_PLANE_444, IMGP_PLANE_444, IMGP_PLANE_444),
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_BGR888, "BGR888", "RGB", 24, 24, 0x0000ff, 0x00ff00, 0xff0000, 0, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB24),
+	/* [Low Address] A B G R [High Address] */
+	IMGP_FORMAT_RGB(MM_UTIL_IMG_FMT_ABGR8888, "ABGR8888", "RGBA", 32, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, (int)0xff000000, 4321, IMGP_RSZ | IMGP_ROT, IMGP_PLANE_RGB32),
+};
+
+const imgp_format_desc_s*
+_mm_format_get_desc(mm_util_img_format_e format)
+{
+	if((unsigned int) format >= MM_UTIL_IMG_FMT_NUM) {
+		return NULL;
+	}
+	return &_mm_format_table[format];
+}
+
+const imgp_format_desc_s*
+_mm_format_get_desc_by_label(const char* label)
+{
+	mm_util_img_format_e format = MM_UTIL_IMG_FMT_NUM;
+	const char* _label = NULL;
+
+	if(label == NULL || !label[0] || !label[1] || !label[2] || !label[3]) {
+		return NULL;
+	}
+
+	switch(IMGP_FOURCC(label[0], label[1], label[2], label[3])) {
+		case IMGP_FOURCC('I', '4', '2', '0'): format = MM_UTIL_IMG_FMT_I420; break;
+		case IMGP_FOURCC('Y', '4', '2', 'B'): format = MM_UTIL_IMG_FMT_YUV422; break;
+		case IMGP_FOURCC('Y', 'U', 'V', '4'): format = MM_UTIL_IMG_FMT_YUV422; _label = "YUV422"; break;
+		case IMGP_FOURCC('Y', '4', '4', '4'): format = MM_UTIL_IMG_FMT_Y444; break;
+		case IMGP_FOURCC('Y', 'V', '1', '2'): format = MM_UTIL_IMG_FMT_YV12; break;
+		case IMGP_FOURCC('N', 'V', '1', '2'): format = (label[4] == 'T') ? MM_UTIL_IMG_FMT_NV12_TILED : MM_UTIL_IMG_FMT_NV12; break;
+		case IMGP_FOURCC('U', 'Y', 'V', 'Y'): format = MM_UTIL_IMG_FMT_UYVY; break;
+		case IMGP_FOURCC('Y', 'U', 'Y', 'V'): format = MM_UTIL_IMG_FMT_YUYV; break;
+		case IMGP_FOURCC('R', 'G', 'B', '5'): format = MM_UTIL_IMG_FMT_RGB565; break;
+		case IMGP_FOURCC('R', 'G', 'B', '8'): format = MM_UTIL_IMG_FMT_RGB888; break;
+		case IMGP_FOURCC('B', 'G', 'R', '8'): format = MM_UTIL_IMG_FMT_BGR888; break;
+		case IMGP_FOURCC('A', 'R', 'G', 'B'): format = MM_UTIL_IMG_FMT_ARGB8888; break;
+		case IMGP_FOURCC('B', 'G', 'R', 'A'): format = MM_UTIL_IMG_FMT_BGRA8888; break;
+		case IMGP_FOURCC('R', 'G', 'B', 'A'): format = MM_UTIL_IMG_FMT_RGBA8888; break;
+		case IMGP_FOURCC('A', 'B', 'G', 'R'): format = MM_UTIL_IMG_FMT_ABGR8888; break;
+		case IMGP_FOURCC('B', 'G', 'R', 'X'): format = MM_UTIL_IMG_FMT_BGRX8888; break;
+		default:
+			return NULL;
+	}
+
+	if(strcmp(label, _label ? _label : _mm_format_table[format].label) != 0) {
+		return NULL;
+	}
+	return &_mm_format_table[format];
+}
+
+void
+_mm_format_get_plane_size(const imgp_format_desc_s* desc, unsigned int plane, unsigned int width, unsigned int height, unsigned int* stride, unsigned int* rows)
+{
+	const imgp_plane_desc_s* _plane = &desc->plane[plane];
+	unsigned int _width = ((width + _plane->width_align - 1) / _plane->width_align * _plane->width_align) >> _plane->x_shift;
+	unsigned int _height = ((height + _plane->height_align - 1) / _plane->height_align * _plane->height_align) >> _plane->y_shift;
+
+	*stride = (_width * _plane->pixel_bytes + _plane->stride_align - 1) / _plane->stride_align * _plane->stride_align;
+	*rows = _height;
+}
+
+unsigned int
+_mm_format_get_size(const imgp_format_desc_s* desc, unsigned int width, unsigned int height)
+{
+	unsigned int stride = 0, rows = 0;
+	unsigned int size = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_format_get_plane_size(desc, i, width, height, &stride, &rows);
+		size += stride * rows;
+	}
+	return size;
+}
+
+void
+_mm_format_get_crop_align(const imgp_format_desc_s* desc, unsigned int* x_align, unsigned int* y_align)
+{
+	unsigned int i = 0;
+
+	*x_align = 1;
+	*y_align = 1;
+	for(i = 0; i < desc->plane_count; i++) {
+		if((1u << desc->plane[i].x_shift) > *x_align) {
+			*x_align = 1u << desc->plane[i].x_shift;
+		}
+		if((1u << desc->plane[i].y_shift) > *y_align) {
+			*y_align = 1u << desc->plane[i].y_shift;
+		}
+	}
+	/* a Cb Cr pair of NV12 and a macropixel of packed 4:2:2 are 2 pixels wide */
+	if(desc->format == MM_UTIL_IMG_FMT_NV12 || desc->format == MM_UTIL_IMG_FMT_NV12_TILED
+		|| desc->format == MM_UTIL_IMG_FMT_UYVY || desc->format == MM_UTIL_IMG_FMT_YUYV) {
+		*x_align = (*x_align > 2) ? *x_align : 2;
+	}
+}
@@ -0,0 +1,699 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_format.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <mm_debug.h>
+#include <mm_error.h>
+
+#define IMGP_NATIVE_ONE_HALF (1 << (IMGP_NATIVE_SCALEBITS - 1))
+#define IMGP_NATIVE_CHUNK 256 /* pixels of the intermediate line kept on the stack, must be even */
+
+/* coefficients of the luma weights kr and kb for Y spanning y_range above y_offset and Cb / Cr spanning c_range around 128,
+ * folded at compile time so a conversion only looks its table up. BT.601 limited range gives the CCIR 601 ones of ffmpegcolorspace */
+#define IMGP_NATIVE_KG(kr, kb) (1.0 - (kr) - (kb))
+#define IMGP_NATIVE_YUV_COEFFS(kr, kb, y_offset, y_range, c_range) { \
+	y_offset, IMGP_NATIVE_FIX(255.0/(y_range)), \
+	IMGP_NATIVE_FIX(2.0*(1.0-(kr))*255.0/(c_range)), -IMGP_NATIVE_FIX(2.0*(1.0-(kb))*(kb)/IMGP_NATIVE_KG(kr, kb)*255.0/(c_range)), \
+	-IMGP_NATIVE_FIX(2.0*(1.0-(kr))*(kr)/IMGP_NATIVE_KG(kr, kb)*255.0/(c_range)), IMGP_NATIVE_FIX(2.0*(1.0-(kb))*255.0/(c_range)), \
+	IMGP_NATIVE_FIX((kr)*(y_range)/255.0), IMGP_NATIVE_FIX(IMGP_NATIVE_KG(kr, kb)*(y_range)/255.0), IMGP_NATIVE_FIX((kb)*(y_range)/255.0), \
+	-IMGP_NATIVE_FIX((kr)/(2.0*(1.0-(kb)))*(c_range)/255.0), -IMGP_NATIVE_FIX(IMGP_NATIVE_KG(kr, kb)/(2.0*(1.0-(kb)))*(c_range)/255.0), IMGP_NATIVE_FIX(0.5*(c_range)/255.0), \
+	IMGP_NATIVE_FIX(0.5*(c_range)/255.0), -IMGP_NATIVE_FIX(IMGP_NATIVE_KG(kr, kb)/(2.0*(1.0-(kr)))*(c_range)/255.0), -IMGP_NATIVE_FIX((kb)/(2.0*(1.0-(kr)))*(c_range)/255.0), \
+}
+
+static const imgp_yuv_coeffs_s _mm_native_coeffs[MM_UTIL_COLOR_MATRIX_NUM][MM_UTIL_COLOR_RANGE_NUM] = {
+	{ IMGP_NATIVE_YUV_COEFFS(0.2990, 0.1140, 16, 219.0, 224.0), IMGP_NATIVE_YUV_COEFFS(0.2990, 0.1140, 0, 255.0, 255.0) }, /* BT.601 */
+	{ IMGP_NATIVE_YUV_COEFFS(0.2126, 0.0722, 16, 219.0, 224.0), IMGP_NATIVE_YUV_COEFFS(0.2126, 0.0722, 0, 255.0, 255.0) }, /* BT.709 */
+	{ IMGP_NATIVE_YUV_COEFFS(0.2627, 0.0593, 16, 219.0, 224.0), IMGP_NATIVE_YUV_COEFFS(0.2627, 0.0593, 0, 255.0, 255.0) }, /* BT.2020 */
+};
+
+static pthread_once_t _mm_native_once = PTHREAD_ONCE_INIT;
+static imgp_native_kernels_s _mm_native_kernels = {
+	IMGP_NATIVE_ISA_C, NULL,
+	_mm_native_transpose_u8_c, _mm_native_transpose_u16_c, _mm_native_transpose_u32_c,
+	NULL, NULL, NULL,
+	NULL, NULL,
+	NULL, NULL,
+};
+
+/* MM_IMGP_TIER=c, sse2 or avx2 limits the instruction set of the kernels, the other values leave it to the cpu */
+static imgp_native_isa_e
+_mm_native_isa_limit(void)
+{
+	const char *env = getenv("MM_IMGP_TIER");
+	imgp_native_isa_e isa = IMGP_NATIVE_ISA_C;
+
+	for(isa = IMGP_NATIVE_ISA_C; env != NULL && isa < IMGP_NATIVE_ISA_NUM; isa++) {
+		if(strcasecmp(env, _mm_native_get_isa_name(isa)) == 0) {
+			return isa;
+		}
+	}
+	return IMGP_NATIVE_ISA_NUM;
+}
+
+static void
+_mm_native_init(void)
+{
+	imgp_native_kernels_s* k = &_mm_native_kernels;
+	imgp_native_isa_e limit = _mm_native_isa_limit();
+
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_cpu_init();
+	if(limit >= IMGP_NATIVE_ISA_SSE2 && __builtin_cpu_supports("sse2")) {
+		k->isa = IMGP_NATIVE_ISA_SSE2;
+		k->yuv420_to_rgb32_row = _mm_native_yuv420_to_rgb32_row_sse2;
+		k->transpose_u8 = _mm_native_transpose_u8_sse2;
+		k->transpose_u16 = _mm_native_transpose_u16_sse2;
+		k->transpose_u32 = _mm_native_transpose_u32_sse2;
+		k->reverse_u8 = _mm_native_reverse_u8_sse2;
+		k->reverse_u16 = _mm_native_reverse_u16_sse2;
+		k->reverse_u32 = _mm_native_reverse_u32_sse2;
+		k->resize_vertical = _mm_native_resize_vertical_sse2;
+		k->resize_horizontal_u8x4 = _mm_native_resize_horizontal_u8x4_sse2;
+		k->split_uv = _mm_native_split_uv_sse2;
+		k->merge_uv = _mm_native_merge_uv_sse2;
+	}
+	if(limit >= IMGP_NATIVE_ISA_AVX2 && __builtin_cpu_supports("avx2")) {
+		/* the data movement kernels are bound by memory, SSE2 ones are kept for them */
+		k->isa = IMGP_NATIVE_ISA_AVX2;
+		k->yuv420_to_rgb32_row = _mm_native_yuv420_to_rgb32_row_avx2;
+	}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	/* the NEON kernels are only built when the target has NEON */
+	if(limit != IMGP_NATIVE_ISA_C) {
+		k->isa = IMGP_NATIVE_ISA_NEON;
+		k->yuv420_to_rgb32_row = _mm_native_yuv420_to_rgb32_row_neon;
+		k->transpose_u8 = _mm_native_transpose_u8_neon;
+		k->transpose_u16 = _mm_native_transpose_u16_neon;
+		k->transpose_u32 = _mm_native_transpose_u32_neon;
+		k->reverse_u8 = _mm_native_reverse_u8_neon;
+		k->reverse_u16 = _mm_native_reverse_u16_neon;
+		k->reverse_u32 = _mm_native_reverse_u32_neon;
+		k->resize_vertical = _mm_native_resize_vertical_neon;
+		k->resize_horizontal_u8x4 = _mm_native_resize_horizontal_u8x4_neon;
+		k->split_uv = _mm_native_split_uv_neon;
+		k->merge_uv = _mm_native_merge_uv_neon;
+	}
+#endif
+	mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] native kernels use %s", __func__, __LINE__, _mm_native_get_isa_name(k->isa));
+}
+
+const imgp_native_kernels_s*
+_mm_native_get_kernels(void)
+{
+	pthread_once(&_mm_native_once, _mm_native_init);
+	return &_mm_native_kernels;
+}
+
+imgp_native_isa_e
+_mm_native_get_isa(void)
+{
+	return _mm_native_get_kernels()->isa;
+}
+
+const char*
+_mm_native_get_isa_name(imgp_native_isa_e isa)
+{
+	switch(isa) {
+		case IMGP_NATIVE_ISA_C:
+			return "C";
+		case IMGP_NATIVE_ISA_SSE2:
+			return "SSE2";
+		case IMGP_NATIVE_ISA_AVX2:
+			return "AVX2";
+		case IMGP_NATIVE_ISA_NEON:
+			return "NEON";
+		default:
+			return "unknown";
+	}
+}
+
+static inline unsigned char
+_mm_native_clip(int value)
+{
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+/* low bits of an expanded RGB565 component are copies of its lowest bit, as ffmpegcolorspace does */
+static inline unsigned int
+_mm_native_bitcopy_n(unsigned int a, int n)
+{
+	int mask = (1 << n) - 1;
+	return (a & (0xff & ~mask)) | ((-((a >> n) & 1)) & mask);
+}
+
+static int
+_mm_native_is_yuv420(mm_util_img_format_e format)
+{
+	return (format == MM_UTIL_IMG_FMT_I420 || format == MM_UTIL_IMG_FMT_NV12);
+}
+
+static int
+_mm_native_is_rgb(mm_util_img_format_e format)
+{
+	return (format == MM_UTIL_IMG_FMT_RGB888 || format == MM_UTIL_IMG_FMT_RGB565
+		|| format == MM_UTIL_IMG_FMT_ARGB8888 || format == MM_UTIL_IMG_FMT_BGRA8888);
+}
+
+void
+_mm_native_plane_layout(mm_util_img_format_e format, unsigned int plane, unsigned int *elem, unsigned int *x_shift, unsigned int *y_shift)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc(format);
+
+	*elem = desc->plane[plane].pixel_bytes;
+	*x_shift = desc->plane[plane].x_shift;
+	*y_shift = desc->plane[plane].y_shift;
+	if((format == MM_UTIL_IMG_FMT_NV12 || format == MM_UTIL_IMG_FMT_NV12_TILED) && plane == 1) {
+		/* a Cb Cr pair is one sample of a half width plane */
+		*elem = 2;
+		*x_shift = 1;
+	}
+}
+
+int
+_mm_native_frame_init(imgp_frame_s *frame, mm_util_img_format_e format, unsigned int width, unsigned int height, unsigned char *buffer)
+{
+	const imgp_format_desc_s* desc = NULL;
+	unsigned int rows = 0;
+	unsigned int i = 0;
+
+	if(frame == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] frame is NULL", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	memset(frame, 0, sizeof(imgp_frame_s));
+	frame->format = format;
+	frame->width = width;
+	frame->height = height;
+	frame->data[0] = buffer;
+
+	desc = _mm_format_get_desc(format);
+	if(desc == NULL || desc->plane_count == 0) {
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] format %d has no native layout", __func__, __LINE__, format);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	/* the planes follow each other as mm_setup_image_size counts them */
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_format_get_plane_size(desc, i, width, height, &frame->stride[i], &rows);
+		if(i + 1 < desc->plane_count) {
+			frame->data[i + 1] = frame->data[i] + frame->stride[i] * rows;
+		}
+	}
+	return MM_ERROR_NONE;
+}
+
+int
+_mm_native_frame_set_planes(imgp_frame_s *frame, unsigned char *const *planes, const unsigned int *strides)
+{
+	const imgp_format_desc_s* desc = NULL;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int row_bytes = 0;
+	unsigned int i = 0;
+
+	if(frame == NULL || planes == NULL || strides == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid frame or planes", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	desc = _mm_format_get_desc(frame->format);
+	if(desc == NULL || desc->plane_count == 0) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] format %d has no planes", __func__, __LINE__, frame->format);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(frame->format, i, &elem, &x_shift, &y_shift);
+		row_bytes = ((frame->width + (1 << x_shift) - 1) >> x_shift) * elem;
+		if(planes[i] == NULL || (strides[i] != 0 && strides[i] < row_bytes)) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] plane %u: %p stride %u for rows of %u bytes", __func__, __LINE__, i, planes[i], strides[i], row_bytes);
+			return MM_ERROR_IMAGE_INVALID_VALUE;
+		}
+		frame->data[i] = planes[i];
+		if(strides[i] != 0) {
+			frame->stride[i] = strides[i];
+		}
+	}
+	return MM_ERROR_NONE;
+}
+
+void
+_mm_native_frame_copy(const imgp_frame_s *dst, const imgp_frame_s *src)
+{
+	const imgp_format_desc_s* desc = _mm_format_get_desc(src->format);
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int row_bytes = 0, rows = 0;
+	unsigned int i = 0, y = 0;
+
+	for(i = 0; desc != NULL && i < desc->plane_count; i++) {
+		_mm_native_plane_layout(src->format, i, &elem, &x_shift, &y_shift);
+		row_bytes = ((src->width + (1 << x_shift) - 1) >> x_shift) * elem;
+		rows = (src->height + (1 << y_shift) - 1) >> y_shift;
+		if(src->stride[i] == row_bytes && dst->stride[i] == row_bytes) {
+			memcpy(dst->data[i], src->data[i], (size_t) row_bytes * rows);
+			continue;
+		}
+		for(y = 0; y < rows; y++) {
+			memcpy(dst->data[i] + (size_t) y * dst->stride[i], src->data[i] + (size_t) y * src->stride[i], row_bytes);
+		}
+	}
+}
+
+int
+_mm_native_csc_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format)
+{
+	if(_mm_native_is_yuv420(src_format) && _mm_native_is_rgb(dst_format)) {
+		return 1;
+	}
+	if(_mm_native_is_rgb(src_format) && _mm_native_is_yuv420(dst_format)) {
+		return 1;
+	}
+	if((src_format == MM_UTIL_IMG_FMT_YUYV || src_format == MM_UTIL_IMG_FMT_UYVY) && dst_format == MM_UTIL_IMG_FMT_I420) {
+		return 1;
+	}
+	return 0;
+}
+
+static void
+_mm_native_yuv420_to_rgb32_row_c(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int x, unsigned int width, const imgp_yuv_coeffs_s *c, imgp_native_rgb32_order_e order)
+{
+	for(; x < width; x++) {
+		int cb = u[(x >> 1) * uv_step] - 128;
+		int cr = v[(x >> 1) * uv_step] - 128;
+		int yy = (y[x] - c->y_offset) * c->y_scale;
+		unsigned char r = _mm_native_clip((yy + c->r_cr * cr + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+		unsigned char g = _mm_native_clip((yy + c->g_cb * cb + c->g_cr * cr + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+		unsigned char b = _mm_native_clip((yy + c->b_cb * cb + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+		unsigned char *p = dst + x * 4;
+
+		if(order == IMGP_NATIVE_RGB32_ARGB) {
+			p[0] = 0xff; p[1] = r; p[2] = g; p[3] = b;
+		}else {
+			p[0] = b; p[1] = g; p[2] = r; p[3] = 0xff;
+		}
+	}
+}
+
+static void
+_mm_native_yuv420_to_rgb32_row(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *c, imgp_native_rgb32_order_e order)
+{
+	const imgp_native_kernels_s* k = _mm_native_get_kernels();
+	unsigned int x = 0;
+
+	if(k->yuv420_to_rgb32_row) {
+		x = k->yuv420_to_rgb32_row(y, u, v, uv_step, dst, width, c, order);
+	}
+	_mm_native_yuv420_to_rgb32_row_c(y, u, v, uv_step, dst, x, width, c, order);
+}
+
+static void
+_mm_native_pack_bgra(const unsigned char *bgra, unsigned char *dst, unsigned int count, mm_util_img_format_e format)
+{
+	unsigned int i = 0;
+
+	if(format == MM_UTIL_IMG_FMT_RGB888) {
+		for(i = 0; i < count; i++, bgra += 4, dst += 3) {
+			dst[0] = bgra[2]; dst[1] = bgra[1]; dst[2] = bgra[0];
+		}
+	}else if(format == MM_UTIL_IMG_FMT_RGB565) { /* endianness 1234 */
+		for(i = 0; i < count; i++, bgra += 4, dst += 2) {
+			unsigned int pixel = ((bgra[2] >> 3) << 11) | ((bgra[1] >> 2) << 5) | (bgra[0] >> 3);
+			dst[0] = pixel & 0xff; dst[1] = pixel >> 8;
+		}
+	}
+}
+
+static void
+_mm_native_unpack_bgra(const unsigned char *src, unsigned char *bgra, unsigned int count, mm_util_img_format_e format)
+{
+	unsigned int i = 0;
+
+	switch(format) {
+		case MM_UTIL_IMG_FMT_RGB888:
+			for(i = 0; i < count; i++, src += 3, bgra += 4) {
+				bgra[0] = src[2]; bgra[1] = src[1]; bgra[2] = src[0];
+			}
+			break;
+		case MM_UTIL_IMG_FMT_RGB565:
+			for(i = 0; i < count; i++, src += 2, bgra += 4) {
+				unsigned int pixel = src[0] | (src[1] << 8);
+				bgra[0] = _mm_native_bitcopy_n(pixel << 3, 3);
+				bgra[1] = _mm_native_bitcopy_n(pixel >> (5 - 2), 2);
+				bgra[2] = _mm_native_bitcopy_n(pixel >> (11 - 3), 3);
+			}
+			break;
+		case MM_UTIL_IMG_FMT_ARGB8888:
+			for(i = 0; i < count; i++, src += 4, bgra += 4) {
+				bgra[0] = src[3]; bgra[1] = src[2]; bgra[2] = src[1];
+			}
+			break;
+		case MM_UTIL_IMG_FMT_BGRA8888:
+			memcpy(bgra, src, count * 4);
+			break;
+		default:
+			break;
+	}
+}
+
+static void
+_mm_native_yuv420_to_rgb(const imgp_frame_s *src, const imgp_frame_s *dst, const imgp_yuv_coeffs_s *c, unsigned int y_start, unsigned int y_end)
+{
+	unsigned int uv_step = (src->format == MM_UTIL_IMG_FMT_NV12) ? 2 : 1;
+	unsigned int v_index = (src->format == MM_UTIL_IMG_FMT_NV12) ? 1 : 2;
+	unsigned int bpp = (dst->format == MM_UTIL_IMG_FMT_RGB888) ? 3 : 2;
+	unsigned char line[IMGP_NATIVE_CHUNK * 4];
+	unsigned int row = 0, x = 0;
+
+	for(row = y_start; row < y_end; row++) {
+		const unsigned char *y = src->data[0] + row * src->stride[0];
+		const unsigned char *u = src->data[1] + (row >> 1) * src->stride[1];
+		const unsigned char *v = (uv_step == 2) ? u + 1 : src->data[v_index] + (row >> 1) * src->stride[v_index];
+		unsigned char *out = dst->data[0] + row * dst->stride[0];
+
+		if(dst->format == MM_UTIL_IMG_FMT_ARGB8888) {
+			_mm_native_yuv420_to_rgb32_row(y, u, v, uv_step, out, src->width, c, IMGP_NATIVE_RGB32_ARGB);
+		}else if(dst->format == MM_UTIL_IMG_FMT_BGRA8888) {
+			_mm_native_yuv420_to_rgb32_row(y, u, v, uv_step, out, src->width, c, IMGP_NATIVE_RGB32_BGRA);
+		}else {
+			for(x = 0; x < src->width; x += IMGP_NATIVE_CHUNK) {
+				unsigned int count = (src->width - x < IMGP_NATIVE_CHUNK) ? src->width - x : IMGP_NATIVE_CHUNK;
+				_mm_native_yuv420_to_rgb32_row(y + x, u + (x >> 1) * uv_step, v + (x >> 1) * uv_step, uv_step, line, count, c, IMGP_NATIVE_RGB32_BGRA);
+				_mm_native_pack_bgra(line, out + x * bpp, count, dst->format);
+			}
+		}
+	}
+}
+
+static void
+_mm_native_rgb_to_yuv420(const imgp_frame_s *src, const imgp_frame_s *dst, const imgp_yuv_coeffs_s *c, unsigned int y_start, unsigned int y_end)
+{
+	unsigned int bpp = (src->format == MM_UTIL_IMG_FMT_RGB888) ? 3 : ((src->format == MM_UTIL_IMG_FMT_RGB565) ? 2 : 4);
+	unsigned char line[2][IMGP_NATIVE_CHUNK * 4];
+	unsigned int row = 0, x = 0, i = 0, j = 0;
+
+	for(row = y_start; row < y_end; row += 2) {
+		unsigned int rows = (row + 1 < y_end) ? 2 : 1;
+		unsigned char *out_y = dst->data[0] + row * dst->stride[0];
+		unsigned char *out_u = dst->data[1] + (row >> 1) * dst->stride[1];
+		unsigned char *out_v = (dst->format == MM_UTIL_IMG_FMT_NV12) ? out_u + 1 : dst->data[2] + (row >> 1) * dst->stride[2];
+		unsigned int uv_step = (dst->format == MM_UTIL_IMG_FMT_NV12) ? 2 : 1;
+
+		for(x = 0; x < src->width; x += IMGP_NATIVE_CHUNK) {
+			unsigned int count = (src->width - x < IMGP_NATIVE_CHUNK) ? src->width - x : IMGP_NATIVE_CHUNK;
+
+			for(j = 0; j < rows; j++) {
+				const unsigned char *in = src->data[0] + (row + j) * src->stride[0] + x * bpp;
+				unsigned char *out = out_y + j * dst->stride[0] + x;
+
+				_mm_native_unpack_bgra(in, line[j], count, src->format);
+				for(i = 0; i < count; i++) {
+					const unsigned char *p = line[j] + i * 4;
+					out[i] = (c->y_r * p[2] + c->y_g * p[1] + c->y_b * p[0] + (IMGP_NATIVE_ONE_HALF + (c->y_offset << IMGP_NATIVE_SCALEBITS))) >> IMGP_NATIVE_SCALEBITS;
+				}
+			}
+
+			for(i = 0; i < count; i += 2) {
+				unsigned int cols = (i + 1 < count) ? 2 : 1;
+				int shift = (cols == 2) + (rows == 2);
+				int r = 0, g = 0, b = 0;
+				unsigned int index = ((x + i) >> 1) * uv_step;
+
+				for(j = 0; j < rows; j++) {
+					const unsigned char *p = line[j] + i * 4;
+					b += p[0]; g += p[1]; r += p[2];
+					if(cols == 2) {
+						b += p[4]; g += p[5]; r += p[6];
+					}
+				}
+				out_u[index] = ((c->u_r * r + c->u_g * g + c->u_b * b + (IMGP_NATIVE_ONE_HALF << shift) - 1) >> (IMGP_NATIVE_SCALEBITS + shift)) + 128;
+				out_v[index] = ((c->v_r * r + c->v_g * g + c->v_b * b + (IMGP_NATIVE_ONE_HALF << shift) - 1) >> (IMGP_NATIVE_SCALEBITS + shift)) + 128;
+			}
+		}
+	}
+}
+
+static void
+_mm_native_yuv422_to_i420(const imgp_frame_s *src, const imgp_frame_s *dst, unsigned int y_start, unsigned int y_end)
+{
+	unsigned int y_pos = (src->format == MM_UTIL_IMG_FMT_YUYV) ? 0 : 1;
+	unsigned int u_pos = (src->format == MM_UTIL_IMG_FMT_YUYV) ? 1 : 0;
+	unsigned int v_pos = u_pos + 2;
+	unsigned int row = 0, x = 0;
+
+	for(row = y_start; row < y_end; row++) {
+		const unsigned char *in = src->data[0] + row * src->stride[0];
+		unsigned char *out_y = dst->data[0] + row * dst->stride[0];
+
+		for(x = 0; x < src->width; x++) {
+			out_y[x] = in[x * 2 + y_pos];
+		}
+		if((row & 1) == 0) {
+			unsigned char *out_u = dst->data[1] + (row >> 1) * dst->stride[1];
+			unsigned char *out_v = dst->data[2] + (row >> 1) * dst->stride[2];
+
+			for(x = 0; x < (src->width + 1) / 2; x++) {
+				out_u[x] = in[x * 4 + u_pos];
+				out_v[x] = in[x * 4 + v_pos];
+			}
+		}
+	}
+}
+
+const imgp_yuv_coeffs_s*
+_mm_native_get_coeffs(mm_util_img_color_matrix_e matrix, mm_util_img_color_range_e range)
+{
+	if((unsigned int) matrix >= MM_UTIL_COLOR_MATRIX_NUM || (unsigned int) range >= MM_UTIL_COLOR_RANGE_NUM) {
+		return NULL;
+	}
+	return &_mm_native_coeffs[matrix][range];
+}
+
+int
+_mm_native_csc(const imgp_frame_s *src, const imgp_frame_s *dst, const imgp_yuv_coeffs_s *coeffs, unsigned int y_start, unsigned int y_end)
+{
+	if(src == NULL || dst == NULL || src->width != dst->width || src->height != dst->height || y_start > y_end || y_end > src->height) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid frames or rows [%u, %u)", __func__, __LINE__, y_start, y_end);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	pthread_once(&_mm_native_once, _mm_native_init);
+	if(coeffs == NULL) {
+		coeffs = &_mm_native_coeffs[MM_UTIL_COLOR_MATRIX_BT601][MM_UTIL_COLOR_RANGE_LIMITED];
+	}
+
+	if(_mm_native_is_yuv420(src->format) && _mm_native_is_rgb(dst->format)) {
+		_mm_native_yuv420_to_rgb(src, dst, coeffs, y_start, y_end);
+	}else if(_mm_native_is_rgb(src->format) && _mm_native_is_yuv420(dst->format)) {
+		_mm_native_rgb_to_yuv420(src, dst, coeffs, y_start, y_end);
+	}else if((src->format == MM_UTIL_IMG_FMT_YUYV || src->format == MM_UTIL_IMG_FMT_UYVY) && dst->format == MM_UTIL_IMG_FMT_I420) {
+		_mm_native_yuv422_to_i420(src, dst, y_start, y_end);
+	}else {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %d -> %d is not supported", __func__, __LINE__, src->format, dst->format);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+	return MM_ERROR_NONE;
+}
+
+int
+_mm_native_csc_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end)
+{
+	return _mm_native_csc(op->src, op->dst, op->coeffs, y_start, y_end);
+}
+
+/*
+ * Fused scale + convert + rotate of YUV 4:2:0 to RGB. dst is walked in tiles, every pixel is mapped back through
+ * the rotation to the scaled frame and then to the source, where Y, Cb and Cr are sampled bilinearly and converted
+ * in registers, so the source is read once and dst written once without intermediate frames.
+ */
+
+/* pixel centres of the scaled frame are mapped to the source as videoscale does: (u + 0.5) * src / dst - 0.5 */
+static inline int
+_mm_native_fused_step(unsigned int src_size, unsigned int dst_size)
+{
+	return (int) ((((unsigned long long) src_size << 16) + dst_size / 2) / dst_size);
+}
+
+/* bilinear sample of a plane at the 16.16 position, clamped to the border */
+static inline int
+_mm_native_fused_sample(const unsigned char *plane, unsigned int stride, unsigned int step, int width, int height, int fx, int fy)
+{
+	const unsigned char *row0 = NULL, *row1 = NULL;
+	int x0 = 0, x1 = 0, wx = 0, wy = 0, p0 = 0, p1 = 0;
+
+	fx = (fx < 0) ? 0 : ((fx > ((width - 1) << 16)) ? (width - 1) << 16 : fx);
+	fy = (fy < 0) ? 0 : ((fy > ((height - 1) << 16)) ? (height - 1) << 16 : fy);
+	x0 = fx >> 16;
+	x1 = x0 + (x0 < width - 1);
+	wx = (fx >> 8) & 0xff;
+	wy = (fy >> 8) & 0xff;
+	row0 = plane + (fy >> 16) * stride;
+	row1 = row0 + (((fy >> 16) < height - 1) ? stride : 0);
+	p0 = row0[x0 * step] * (256 - wx) + row0[x1 * step] * wx;
+	p1 = row1[x0 * step] * (256 - wx) + row1[x1 * step] * wx;
+	return (p0 * (256 - wy) + p1 * wy + (1 << 15)) >> 16;
+}
+
+int
+_mm_native_fused_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format,
+	unsigned int src_width, unsigned int src_height, unsigned int dst_width, unsigned int dst_height)
+{
+	if(!_mm_native_is_yuv420(src_format) || !_mm_native_is_rgb(dst_format)) {
+		return 0;
+	}
+	/* the 16.16 source positions must fit in an int */
+	return src_width > 0 && src_height > 0 && dst_width > 0 && dst_height > 0
+		&& src_width <= IMGP_NATIVE_FUSED_MAX_SIZE && src_height <= IMGP_NATIVE_FUSED_MAX_SIZE
+		&& dst_width <= IMGP_NATIVE_FUSED_MAX_SIZE && dst_height <= IMGP_NATIVE_FUSED_MAX_SIZE;
+}
+
+int
+_mm_native_fused_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end)
+{
+	const imgp_yuv_coeffs_s *c = NULL;
+	const imgp_frame_s *src = NULL;
+	const imgp_frame_s *dst = NULL;
+	unsigned int uv_step = 0, v_index = 0, bpp = 0;
+	unsigned int scaled_width = 0, scaled_height = 0;
+	int chroma_width = 0, chroma_height = 0;
+	int step_x = 0, step_y = 0, offset_x = 0, offset_y = 0;
+	int u_x = 0, u_y = 0, u_c = 0, v_x = 0, v_y = 0, v_c = 0;
+	unsigned int tx = 0, ty = 0, x = 0, y = 0, x_end = 0;
+
+	if(op == NULL || op->src == NULL || op->dst == NULL || y_start > y_end || y_end > op->dst->height
+		|| !_mm_native_fused_supported(op->src->format, op->dst->format, op->src->width, op->src->height, op->dst->width, op->dst->height)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid op or rows [%u, %u)", __func__, __LINE__, y_start, y_end);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	src = op->src;
+	dst = op->dst;
+	c = op->coeffs ? op->coeffs : &_mm_native_coeffs[MM_UTIL_COLOR_MATRIX_BT601][MM_UTIL_COLOR_RANGE_LIMITED];
+	uv_step = (src->format == MM_UTIL_IMG_FMT_NV12) ? 2 : 1;
+	v_index = (src->format == MM_UTIL_IMG_FMT_NV12) ? 1 : 2;
+	bpp = (dst->format == MM_UTIL_IMG_FMT_RGB888) ? 3 : ((dst->format == MM_UTIL_IMG_FMT_RGB565) ? 2 : 4);
+	chroma_width = (src->width + 1) >> 1;
+	chroma_height = (src->height + 1) >> 1;
+
+	/* (u, v) of the scaled frame = (u_x * x + u_y * y + u_c, v_x * x + v_y * y + v_c) for the pixel (x, y) of dst */
+	if(op->angle == MM_UTIL_ROTATE_90 || op->angle == MM_UTIL_ROTATE_270) {
+		scaled_width = dst->height;
+		scaled_height = dst->width;
+	}else {
+		scaled_width = dst->width;
+		scaled_height = dst->height;
+	}
+	switch(op->angle) {
+		case MM_UTIL_ROTATE_90:
+			u_y = 1; v_x = -1; v_c = scaled_height - 1;
+			break;
+		case MM_UTIL_ROTATE_180:
+			u_x = -1; u_c = scaled_width - 1; v_y = -1; v_c = scaled_height - 1;
+			break;
+		case MM_UTIL_ROTATE_270:
+			u_y = -1; u_c = scaled_width - 1; v_x = 1;
+			break;
+		case MM_UTIL_ROTATE_FLIP_HORZ:
+			u_x = -1; u_c = scaled_width - 1; v_y = 1;
+			break;
+		case MM_UTIL_ROTATE_FLIP_VERT:
+			u_x = 1; v_y = -1; v_c = scaled_height - 1;
+			break;
+		default:
+			u_x = 1; v_y = 1;
+			break;
+	}
+	step_x = _mm_native_fused_step(src->width, scaled_width);
+	step_y = _mm_native_fused_step(src->height, scaled_height);
+	offset_x = step_x / 2 - (1 << 15);
+	offset_y = step_y / 2 - (1 << 15);
+
+	for(ty = y_start; ty < y_end; ty += IMGP_NATIVE_FUSED_TILE) {
+		for(tx = 0; tx < dst->width; tx += IMGP_NATIVE_FUSED_TILE) {
+			x_end = IMGP_NATIVE_MIN(tx + IMGP_NATIVE_FUSED_TILE, dst->width);
+			for(y = ty; y < IMGP_NATIVE_MIN(ty + IMGP_NATIVE_FUSED_TILE, y_end); y++) {
+				unsigned char *out = dst->data[0] + y * dst->stride[0] + tx * bpp;
+				int fx = offset_x + (u_x * (int) tx + u_y * (int) y + u_c) * step_x;
+				int fy = offset_y + (v_x * (int) tx + v_y * (int) y + v_c) * step_y;
+
+				for(x = tx; x < x_end; x++, fx += u_x * step_x, fy += v_x * step_y, out += bpp) {
+					/* chroma sample k is centred on the luma position 2k + 0.5 */
+					int cfx = (fx - (1 << 15)) >> 1;
+					int cfy = (fy - (1 << 15)) >> 1;
+					int yy = (_mm_native_fused_sample(src->data[0], src->stride[0], 1, src->width, src->height, fx, fy) - c->y_offset) * c->y_scale;
+					int cb = _mm_native_fused_sample(src->data[1], src->stride[1], uv_step, chroma_width, chroma_height, cfx, cfy) - 128;
+					int cr = _mm_native_fused_sample(src->data[v_index] + (uv_step == 2), src->stride[v_index], uv_step, chroma_width, chroma_height, cfx, cfy) - 128;
+					unsigned char r = _mm_native_clip((yy + c->r_cr * cr + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+					unsigned char g = _mm_native_clip((yy + c->g_cb * cb + c->g_cr * cr + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+					unsigned char b = _mm_native_clip((yy + c->b_cb * cb + IMGP_NATIVE_ONE_HALF) >> IMGP_NATIVE_SCALEBITS);
+
+					switch(dst->format) {
+						case MM_UTIL_IMG_FMT_RGB888:
+							out[0] = r; out[1] = g; out[2] = b;
+							break;
+						case MM_UTIL_IMG_FMT_RGB565: { /* endianness 1234 */
+							unsigned int pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+							out[0] = pixel & 0xff; out[1] = pixel >> 8;
+							break;
+						}
+						case MM_UTIL_IMG_FMT_ARGB8888:
+							out[0] = 0xff; out[1] = r; out[2] = g; out[3] = b;
+							break;
+						default:
+							out[0] = b; out[1] = g; out[2] = r; out[3] = 0xff;
+							break;
+					}
+				}
+			}
+		}
+	}
+	return MM_ERROR_NONE;
+}
+
+void
+_mm_native_fused_src_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end, unsigned int *src_start, unsigned int *src_end)
+{
+	const imgp_frame_s *src = op->src;
+	int step_y = 0, offset_y = 0, fy = 0, cfy = 0;
+	unsigned int luma = 0, chroma = 0, first = 0, last = 0;
+
+	/* the other angles map the rows of dst to columns of the source or walk it backwards */
+	if(op->angle != MM_UTIL_ROTATE_0 && op->angle != MM_UTIL_ROTATE_FLIP_HORZ) {
+		*src_start = 0;
+		*src_end = src->height;
+		return;
+	}
+	step_y = _mm_native_fused_step(src->height, op->dst->height);
+	offset_y = step_y / 2 - (1 << 15);
+
+	/* the luma row of a position and the luma rows of the chroma row sampled half a row above it */
+	fy = offset_y + (int) y_start * step_y;
+	cfy = (fy - (1 << 15)) >> 1;
+	luma = (fy < 0) ? 0 : fy >> 16;
+	chroma = (cfy < 0) ? 0 : cfy >> 16;
+	first = IMGP_NATIVE_MIN(luma, chroma * 2);
+	fy = offset_y + (int) (y_end - 1) * step_y;
+	cfy = (fy - (1 << 15)) >> 1;
+	luma = ((fy < 0) ? 0 : fy >> 16) + 2;
+	chroma = ((cfy < 0) ? 0 : cfy >> 16) + 2;
+	last = (luma > chroma * 2) ? luma : chroma * 2;
+
+	*src_start = IMGP_NATIVE_MIN(first, src->height) & ~1u;
+	*src_end = IMGP_NATIVE_MIN(last, src->height);
+}
@@ -0,0 +1,486 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_format.h"
+#include <math.h>
+#include <mm_debug.h>
+#include <mm_error.h>
+
+/*
+ * Separable resize: every plane is filtered horizontally into a ring of rows, then vertically into dst.
+ * The coefficients of both passes are computed once for a frame as IMGP_NATIVE_RESIZE_BITS fixed point
+ * weights, the window of a dst sample grows with the downscale factor so that it is never aliased.
+ * Integer downscales with MM_UTIL_RESIZE_FILTER_AREA only sum the blocks of source samples,
+ * as the early reductions of the thumbnails do.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IMGP_NATIVE_RESIZE_ONE (1 << IMGP_NATIVE_RESIZE_BITS)
+#define IMGP_NATIVE_RESIZE_BOX_MAX 256 /* horizontal sums of a box stay in 16 bits */
+
+typedef struct _imgp_native_filter_s
+{
+	unsigned int size;   /* dst samples */
+	unsigned int taps;   /* source samples of every dst sample, the window is padded with zero weights */
+	int *start;          /* first source sample of every dst sample */
+	short *weights;      /* size x taps */
+} imgp_native_filter_s;
+
+struct _imgp_native_resize_s
+{
+	unsigned int plane_count;
+	imgp_native_filter_s x[IMGP_NATIVE_PLANE_MAX];
+	imgp_native_filter_s y[IMGP_NATIVE_PLANE_MAX];
+	unsigned int box_x[IMGP_NATIVE_PLANE_MAX];  /* integer factor of the area fast path, 0 when it is not used */
+	unsigned int box_y[IMGP_NATIVE_PLANE_MAX];
+};
+
+static double
+_mm_native_filter_box(double x)
+{
+	return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+}
+
+static double
+_mm_native_filter_bilinear(double x)
+{
+	x = fabs(x);
+	return (x < 1.0) ? 1.0 - x : 0.0;
+}
+
+static double
+_mm_native_filter_bicubic(double x)
+{
+	const double a = -0.5; /* as videoscale and most image libraries */
+
+	x = fabs(x);
+	if(x < 1.0) {
+		return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+	}
+	if(x < 2.0) {
+		return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+	}
+	return 0.0;
+}
+
+static double
+_mm_native_sinc(double x)
+{
+	if(x == 0.0) {
+		return 1.0;
+	}
+	x *= M_PI;
+	return sin(x) / x;
+}
+
+static double
+_mm_native_filter_lanczos(double x)
+{
+	return (x > -3.0 && x < 3.0) ? _mm_native_sinc(x) * _mm_native_sinc(x / 3.0) : 0.0;
+}
+
+static void
+_mm_native_filter_free(imgp_native_filter_s *filter)
+{
+	free(filter->start);
+	free(filter->weights);
+	memset(filter, 0, sizeof(imgp_native_filter_s));
+}
+
+static int
+_mm_native_filter_init(imgp_native_filter_s *filter, mm_util_img_resize_filter_e type, unsigned int src_size, unsigned int dst_size)
+{
+	double (*func)(double) = _mm_native_filter_bilinear;
+	double support = 1.0;
+	double scale = (double) src_size / dst_size;
+	double filter_scale = (scale > 1.0) ? scale : 1.0;
+	double *window = NULL;
+	unsigned int i = 0, j = 0;
+
+	switch((src_size == dst_size) ? MM_UTIL_RESIZE_FILTER_NEAREST : type) {
+		case MM_UTIL_RESIZE_FILTER_NEAREST: func = NULL; support = 0.5; break;
+		case MM_UTIL_RESIZE_FILTER_BICUBIC: func = _mm_native_filter_bicubic; support = 2.0; break;
+		case MM_UTIL_RESIZE_FILTER_LANCZOS: func = _mm_native_filter_lanczos; support = 3.0; break;
+		case MM_UTIL_RESIZE_FILTER_AREA: func = _mm_native_filter_box; support = 0.5; break;
+		default: break;
+	}
+	support *= filter_scale;
+
+	memset(filter, 0, sizeof(imgp_native_filter_s));
+	filter->size = dst_size;
+	filter->taps = (func == NULL) ? 1 : IMGP_NATIVE_MIN((unsigned int) ceil(support) * 2 + 1, src_size);
+	filter->start = (int*) malloc(dst_size * sizeof(int));
+	filter->weights = (short*) calloc(dst_size * filter->taps, sizeof(short));
+	window = (double*) malloc(filter->taps * sizeof(double));
+	if(filter->start == NULL || filter->weights == NULL || window == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate the filter of %u taps", __func__, __LINE__, filter->taps);
+		free(window);
+		_mm_native_filter_free(filter);
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+
+	for(i = 0; i < dst_size; i++) {
+		double center = (i + 0.5) * scale;
+		short *weights = filter->weights + i * filter->taps;
+		int min = 0, max = 0, sum_fixed = 0, peak = 0;
+		double sum = 0.0;
+
+		if(func == NULL) {
+			filter->start[i] = IMGP_NATIVE_MIN((unsigned int) center, src_size - 1);
+			weights[0] = IMGP_NATIVE_RESIZE_ONE;
+			continue;
+		}
+		min = (int) (center - support + 0.5);
+		max = (int) (center + support + 0.5);
+		min = (min < 0) ? 0 : min;
+		max = IMGP_NATIVE_MIN(max, (int) src_size);
+		max = IMGP_NATIVE_MIN(max, min + (int) filter->taps);
+		for(j = 0; j < (unsigned int) (max - min); j++) {
+			window[j] = func((min + j + 0.5 - center) / filter_scale);
+			sum += window[j];
+		}
+		/* the window is moved inside the source and padded, so that the passes always read taps samples */
+		filter->start[i] = IMGP_NATIVE_MIN(min, (int) (src_size - filter->taps));
+		weights += min - filter->start[i];
+		for(j = 0; j < (unsigned int) (max - min); j++) {
+			weights[j] = (short) floor(window[j] / (sum != 0.0 ? sum : 1.0) * IMGP_NATIVE_RESIZE_ONE + 0.5);
+			sum_fixed += weights[j];
+			if(weights[j] > weights[peak]) {
+				peak = j;
+			}
+		}
+		/* flat areas keep their value exactly */
+		weights[peak] += IMGP_NATIVE_RESIZE_ONE - sum_fixed;
+	}
+	free(window);
+	return MM_ERROR_NONE;
+}
+
+static inline unsigned char
+_mm_native_resize_clip(int value)
+{
+	value >>= IMGP_NATIVE_RESIZE_BITS;
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+static void
+_mm_native_resize_horizontal(const imgp_native_kernels_s *k, const imgp_native_filter_s *filter, const unsigned char *src, unsigned char *dst, unsigned int channels)
+{
+	unsigned int i = 0, c = 0, t = 0;
+
+	if(channels == 4 && k->resize_horizontal_u8x4) {
+		i = k->resize_horizontal_u8x4(src, filter->start, filter->weights, filter->taps, dst, filter->size);
+	}
+	for(; i < filter->size; i++) {
+		const short *weights = filter->weights + i * filter->taps;
+		const unsigned char *in = src + filter->start[i] * channels;
+
+		for(c = 0; c < channels; c++) {
+			int sum = 1 << (IMGP_NATIVE_RESIZE_BITS - 1);
+			for(t = 0; t < filter->taps; t++) {
+				sum += in[t * channels + c] * weights[t];
+			}
+			dst[i * channels + c] = _mm_native_resize_clip(sum);
+		}
+	}
+}
+
+static void
+_mm_native_resize_vertical(const imgp_native_kernels_s *k, const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0, t = 0;
+
+	if(taps == 1 && weights[0] == IMGP_NATIVE_RESIZE_ONE) {
+		memcpy(dst, rows[0], count);
+		return;
+	}
+	if(k->resize_vertical) {
+		x = k->resize_vertical(rows, weights, taps, dst, count);
+	}
+	for(; x < count; x++) {
+		int sum = 1 << (IMGP_NATIVE_RESIZE_BITS - 1);
+		for(t = 0; t < taps; t++) {
+			sum += rows[t][x] * weights[t];
+		}
+		dst[x] = _mm_native_resize_clip(sum);
+	}
+}
+
+/* average of box_x x box_y blocks, the horizontal sums of the source rows of a dst row are accumulated.
+ * The blocks of the right and bottom borders may be cut by the source, they average the samples they cover.
+ * src and dst hold the rows from src_row and dst_row of the planes */
+static int
+_mm_native_resize_box(const unsigned char *src, unsigned int src_stride, unsigned int src_width, unsigned int src_height, unsigned int src_row,
+	unsigned char *dst, unsigned int dst_stride, unsigned int dst_width, unsigned int dst_row, unsigned int channels,
+	unsigned int box_x, unsigned int box_y, unsigned int y_start, unsigned int y_end)
+{
+	const unsigned int count = dst_width * channels;
+	const unsigned int area = box_x * box_y;
+	const unsigned int reciprocal = ((1u << 24) + area / 2) / area;
+	unsigned int *sum = (unsigned int*) malloc(count * sizeof(unsigned int));
+	unsigned int y = 0, r = 0, x = 0, c = 0, t = 0;
+	unsigned int rows = 0, cols = 0, covered = 0;
+
+	if(sum == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate a row of %u sums", __func__, __LINE__, count);
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	for(y = y_start; y < y_end; y++) {
+		unsigned char *out = dst + (y - dst_row) * dst_stride;
+
+		rows = IMGP_NATIVE_MIN(box_y, src_height - y * box_y);
+		memset(sum, 0, count * sizeof(unsigned int));
+		for(r = 0; r < rows; r++) {
+			const unsigned char *in = src + (y * box_y + r - src_row) * src_stride;
+			for(x = 0; x < dst_width; x++, in += box_x * channels) {
+				cols = IMGP_NATIVE_MIN(box_x, src_width - x * box_x);
+				for(c = 0; c < channels; c++) {
+					unsigned int s = 0;
+					for(t = 0; t < cols; t++) {
+						s += in[t * channels + c];
+					}
+					sum[x * channels + c] += s;
+				}
+			}
+		}
+		for(x = 0; x < dst_width; x++) {
+			cols = IMGP_NATIVE_MIN(box_x, src_width - x * box_x);
+			covered = rows * cols;
+			for(c = 0; c < channels; c++) {
+				unsigned int s = sum[x * channels + c];
+				out[x * channels + c] = (covered == area) ? (unsigned char) (((unsigned long long) s * reciprocal + (1u << 23)) >> 24)
+					: (unsigned char) ((s + covered / 2) / covered);
+			}
+		}
+	}
+	free(sum);
+	return MM_ERROR_NONE;
+}
+
+int
+_mm_native_resize_supported(mm_util_img_format_e format, unsigned int src_width, unsigned int src_height, unsigned int dst_width, unsigned int dst_height)
+{
+	const imgp_format_desc_s *desc = _mm_format_get_desc(format);
+
+	/* the samples of RGB565 and of the packed 4:2:2 pixels are not bytes of the same component, tiled rows are not contiguous */
+	if(desc == NULL || desc->plane_count == 0 || (desc->flags & IMGP_FORMAT_FLAG_TILED) || format == MM_UTIL_IMG_FMT_RGB565
+		|| format == MM_UTIL_IMG_FMT_YUYV || format == MM_UTIL_IMG_FMT_UYVY) {
+		return 0;
+	}
+	return src_width > 0 && src_height > 0 && dst_width > 0 && dst_height > 0;
+}
+
+int
+_mm_native_resize_prepare(imgp_native_op_s *op)
+{
+	const imgp_frame_s *src = NULL;
+	const imgp_frame_s *dst = NULL;
+	imgp_native_resize_s *resize = NULL;
+	mm_util_img_resize_filter_e filter = MM_UTIL_RESIZE_FILTER_DEFAULT;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int sw = 0, sh = 0, dw = 0, dh = 0;
+	unsigned int i = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(op == NULL || op->src == NULL || op->dst == NULL || op->src->format != op->dst->format
+		|| !_mm_native_resize_supported(op->src->format, op->src->width, op->src->height, op->dst->width, op->dst->height)) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid op", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	src = op->src;
+	dst = op->dst;
+	filter = op->filter;
+	if((unsigned int) filter >= MM_UTIL_RESIZE_FILTER_NUM) {
+		mmf_debug(MMF_DEBUG_LOG, "[%s][%05d] unknown filter %d, the default one is used", __func__, __LINE__, filter);
+		filter = MM_UTIL_RESIZE_FILTER_DEFAULT;
+	}
+
+	resize = (imgp_native_resize_s*) calloc(1, sizeof(imgp_native_resize_s));
+	if(resize == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate the resize", __func__, __LINE__);
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	resize->plane_count = _mm_format_get_desc(src->format)->plane_count;
+	for(i = 0; i < resize->plane_count && ret == MM_ERROR_NONE; i++) {
+		_mm_native_plane_layout(src->format, i, &elem, &x_shift, &y_shift);
+		sw = (src->width + (1 << x_shift) - 1) >> x_shift;
+		sh = (src->height + (1 << y_shift) - 1) >> y_shift;
+		dw = (dst->width + (1 << x_shift) - 1) >> x_shift;
+		dh = (dst->height + (1 << y_shift) - 1) >> y_shift;
+		if(op->reduce > 1) {
+			/* the planes are all reduced by the same factor, so the chroma of the reduced frame stays aligned on its luma */
+			if(dw != (sw + op->reduce - 1) / op->reduce || dh != (sh + op->reduce - 1) / op->reduce || op->reduce > IMGP_NATIVE_RESIZE_BOX_MAX) {
+				mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] plane %u of %ux%u is not reduced to %ux%u by %u", __func__, __LINE__, i, sw, sh, dw, dh, op->reduce);
+				ret = MM_ERROR_IMAGE_INVALID_VALUE;
+				break;
+			}
+			resize->box_x[i] = op->reduce;
+			resize->box_y[i] = op->reduce;
+			continue;
+		}
+		if(filter == MM_UTIL_RESIZE_FILTER_AREA && sw % dw == 0 && sh % dh == 0
+			&& sw / dw <= IMGP_NATIVE_RESIZE_BOX_MAX && sh / dh <= IMGP_NATIVE_RESIZE_BOX_MAX) {
+			resize->box_x[i] = sw / dw;
+			resize->box_y[i] = sh / dh;
+			continue;
+		}
+		ret = _mm_native_filter_init(&resize->x[i], filter, sw, dw);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_native_filter_init(&resize->y[i], filter, sh, dh);
+		}
+	}
+	op->resize = resize;
+	if(ret != MM_ERROR_NONE) {
+		_mm_native_resize_release(op);
+	}
+	return ret;
+}
+
+void
+_mm_native_resize_release(imgp_native_op_s *op)
+{
+	unsigned int i = 0;
+
+	if(op == NULL || op->resize == NULL) {
+		return;
+	}
+	for(i = 0; i < op->resize->plane_count; i++) {
+		_mm_native_filter_free(&op->resize->x[i]);
+		_mm_native_filter_free(&op->resize->y[i]);
+	}
+	free(op->resize);
+	op->resize = NULL;
+}
+
+int
+_mm_native_resize_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end)
+{
+	const imgp_native_kernels_s *k = _mm_native_get_kernels();
+	const imgp_native_resize_s *resize = NULL;
+	const imgp_frame_s *src = NULL;
+	const imgp_frame_s *dst = NULL;
+	const unsigned char **rows = NULL;
+	unsigned char *ring = NULL;
+	int *ring_row = NULL;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int row_start = 0, row_end = 0, row_bytes = 0;
+	unsigned int i = 0, y = 0, t = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(op == NULL || op->resize == NULL || op->src == NULL || op->dst == NULL || y_start > y_end || y_end > op->dst->height) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid op or rows [%u, %u)", __func__, __LINE__, y_start, y_end);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	resize = op->resize;
+	src = op->src;
+	dst = op->dst;
+
+	for(i = 0; i < resize->plane_count && ret == MM_ERROR_NONE; i++) {
+		const imgp_native_filter_s *fx = &resize->x[i];
+		const imgp_native_filter_s *fy = &resize->y[i];
+
+		_mm_native_plane_layout(src->format, i, &elem, &x_shift, &y_shift);
+		/* y_start is even, the last stripe takes the last chroma row of an odd height */
+		row_start = y_start >> y_shift;
+		row_end = (y_end == dst->height) ? (dst->height + (1 << y_shift) - 1) >> y_shift : y_end >> y_shift;
+		if(resize->box_x[i]) {
+			ret = _mm_native_resize_box(src->data[i], src->stride[i], (src->width + (1 << x_shift) - 1) >> x_shift, (src->height + (1 << y_shift) - 1) >> y_shift, op->src_y >> y_shift,
+				dst->data[i], dst->stride[i], (dst->width + (1 << x_shift) - 1) >> x_shift, op->dst_y >> y_shift, elem, resize->box_x[i], resize->box_y[i], row_start, row_end);
+			continue;
+		}
+		/* rows filtered horizontally, source row r is kept in the slot r % taps while it is used */
+		row_bytes = fx->size * elem;
+		ring = (unsigned char*) malloc(fy->taps * row_bytes);
+		ring_row = (int*) malloc(fy->taps * sizeof(int));
+		rows = (const unsigned char**) malloc(fy->taps * sizeof(unsigned char*));
+		if(ring == NULL || ring_row == NULL || rows == NULL) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate %u rows of %u bytes", __func__, __LINE__, fy->taps, row_bytes);
+			ret = MM_ERROR_IMAGE_NO_FREE_SPACE;
+		}else {
+			for(t = 0; t < fy->taps; t++) {
+				ring_row[t] = -1;
+			}
+			for(y = row_start; y < row_end; y++) {
+				for(t = 0; t < fy->taps; t++) {
+					int r = fy->start[y] + t;
+					unsigned int slot = r % fy->taps;
+
+					if(ring_row[slot] != r) {
+						_mm_native_resize_horizontal(k, fx, src->data[i] + (r - (op->src_y >> y_shift)) * src->stride[i], ring + slot * row_bytes, elem);
+						ring_row[slot] = r;
+					}
+					rows[t] = ring + slot * row_bytes;
+				}
+				_mm_native_resize_vertical(k, rows, fy->weights + y * fy->taps, fy->taps, dst->data[i] + (y - (op->dst_y >> y_shift)) * dst->stride[i], row_bytes);
+			}
+		}
+		free(ring);
+		free(ring_row);
+		free(rows);
+		ring = NULL;
+		ring_row = NULL;
+		rows = NULL;
+	}
+	return ret;
+}
+
+void
+_mm_native_resize_src_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end, unsigned int *src_start, unsigned int *src_end)
+{
+	const imgp_native_resize_s *resize = op->resize;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int row_start = 0, row_end = 0, plane_height = 0;
+	unsigned int first = 0, last = 0;
+	unsigned int i = 0, y = 0;
+
+	*src_start = op->src->height;
+	*src_end = 0;
+	for(i = 0; i < resize->plane_count; i++) {
+		_mm_native_plane_layout(op->src->format, i, &elem, &x_shift, &y_shift);
+		row_start = y_start >> y_shift;
+		row_end = (y_end == op->dst->height) ? (op->dst->height + (1 << y_shift) - 1) >> y_shift : y_end >> y_shift;
+		plane_height = (op->src->height + (1 << y_shift) - 1) >> y_shift;
+		if(row_start >= row_end) {
+			continue;
+		}
+		if(resize->box_x[i]) {
+			first = row_start * resize->box_y[i];
+			last = IMGP_NATIVE_MIN(row_end * resize->box_y[i], plane_height);
+		}else {
+			first = plane_height;
+			last = 0;
+			for(y = row_start; y < row_end; y++) {
+				first = IMGP_NATIVE_MIN(first, (unsigned int) resize->y[i].start[y]);
+				last = (resize->y[i].start[y] + resize->y[i].taps > last) ? resize->y[i].start[y] + resize->y[i].taps : last;
+			}
+		}
+		/* a row of a subsampled plane covers 1 << y_shift rows of the frame */
+		*src_start = IMGP_NATIVE_MIN(*src_start, first << y_shift);
+		*src_end = IMGP_NATIVE_MIN((last << y_shift > *src_end) ? last << y_shift : *src_end, op->src->height);
+	}
+	*src_start &= ~1u;
+	if(*src_start > *src_end) {
+		*src_start = *src_end & ~1u;
+	}
+}
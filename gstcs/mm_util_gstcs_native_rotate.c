@@ -0,0 +1,292 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_format.h"
+#include <mm_debug.h>
+#include <mm_error.h>
+
+/*
+ * 90 and 270 degrees walk dst in tiles of IMGP_NATIVE_ROTATE_TILE x IMGP_NATIVE_ROTATE_TILE elements,
+ * so the source rows of a tile stay in the cache while it is written. Inside a tile, square blocks
+ * are transposed by the SIMD kernels, the borders of the image are copied element by element.
+ * 180 degrees and the flips only reverse and / or reorder rows.
+ */
+
+#define IMGP_NATIVE_ROTATE_TILE 64 /* 64 x 64 x 4 bytes of source and destination fit in a 32 KB L1 */
+
+typedef struct _imgp_native_plane_s
+{
+	const unsigned char *src;
+	int src_stride;
+	unsigned int src_width;     /* in elements */
+	unsigned int src_height;
+	unsigned char *dst;
+	int dst_stride;
+	unsigned int elem;          /* bytes of an element */
+} imgp_native_plane_s;
+
+#define IMGP_NATIVE_TRANSPOSE_C(name, type, block) \
+void \
+name(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride) \
+{ \
+	int i = 0, j = 0; \
+	for(j = 0; j < (block); j++) { \
+		for(i = 0; i < (block); i++) { \
+			memcpy(dst + j * dst_stride + i * sizeof(type), src + i * src_stride + j * sizeof(type), sizeof(type)); \
+		} \
+	} \
+}
+
+IMGP_NATIVE_TRANSPOSE_C(_mm_native_transpose_u8_c, unsigned char, IMGP_NATIVE_TRANSPOSE_U8_BLOCK)
+IMGP_NATIVE_TRANSPOSE_C(_mm_native_transpose_u16_c, unsigned short, IMGP_NATIVE_TRANSPOSE_U16_BLOCK)
+IMGP_NATIVE_TRANSPOSE_C(_mm_native_transpose_u32_c, unsigned int, IMGP_NATIVE_TRANSPOSE_U32_BLOCK)
+
+/* the buffers of the caller may not be aligned to the size of an element, constant sizes become plain moves */
+static inline void
+_mm_native_copy_elem(unsigned char *dst, const unsigned char *src, unsigned int elem)
+{
+	switch(elem) {
+		case 1: *dst = *src; break;
+		case 2: memcpy(dst, src, 2); break;
+		case 4: memcpy(dst, src, 4); break;
+		default: memcpy(dst, src, elem); break;
+	}
+}
+
+static void
+_mm_native_reverse_row(const imgp_native_kernels_s *k, const unsigned char *src, unsigned char *dst, unsigned int count, unsigned int elem)
+{
+	unsigned int i = 0;
+
+	if(elem == 1 && k->reverse_u8) {
+		i = k->reverse_u8(src, dst, count);
+	}else if(elem == 2 && k->reverse_u16) {
+		i = k->reverse_u16(src, dst, count);
+	}else if(elem == 4 && k->reverse_u32) {
+		i = k->reverse_u32(src, dst, count);
+	}
+	for(; i < count; i++) {
+		_mm_native_copy_elem(dst + i * elem, src + (count - 1 - i) * elem, elem);
+	}
+}
+
+static void
+_mm_native_transpose_tile(const imgp_native_kernels_s *k, const imgp_native_plane_s *p, mm_util_img_rotate_type_e angle,
+	unsigned int x0, unsigned int x1, unsigned int y0, unsigned int y1)
+{
+	imgp_native_transpose_f transpose = NULL;
+	unsigned int block = 0;
+	unsigned int bx = 0, by = 0, x = 0, y = 0;
+
+	switch(p->elem) {
+		case 1: transpose = k->transpose_u8; block = IMGP_NATIVE_TRANSPOSE_U8_BLOCK; break;
+		case 2: transpose = k->transpose_u16; block = IMGP_NATIVE_TRANSPOSE_U16_BLOCK; break;
+		case 4: transpose = k->transpose_u32; block = IMGP_NATIVE_TRANSPOSE_U32_BLOCK; break;
+		default: break; /* 24 bit elements are copied one by one */
+	}
+
+	for(by = y0; by < y1; by += block ? block : (y1 - y0)) {
+		for(bx = x0; bx < x1; bx += block ? block : (x1 - x0)) {
+			unsigned int bx1 = block ? bx + block : x1;
+			unsigned int by1 = block ? by + block : y1;
+
+			if(transpose && bx1 <= x1 && by1 <= y1) {
+				if(angle == MM_UTIL_ROTATE_90) {
+					/* dst(x, y) = src(y, h - 1 - x) : the source rows are walked backwards */
+					transpose(p->src + (p->src_height - 1 - bx) * p->src_stride + by * p->elem, -p->src_stride,
+						p->dst + by * p->dst_stride + bx * p->elem, p->dst_stride);
+				}else {
+					/* dst(x, y) = src(w - 1 - y, x) : the destination rows are walked backwards */
+					transpose(p->src + bx * p->src_stride + (p->src_width - by - block) * p->elem, p->src_stride,
+						p->dst + (by + block - 1) * p->dst_stride + bx * p->elem, -p->dst_stride);
+				}
+				continue;
+			}
+			bx1 = IMGP_NATIVE_MIN(bx1, x1);
+			by1 = IMGP_NATIVE_MIN(by1, y1);
+			for(y = by; y < by1; y++) {
+				unsigned char *d = p->dst + y * p->dst_stride;
+				for(x = bx; x < bx1; x++) {
+					const unsigned char *s = (angle == MM_UTIL_ROTATE_90)
+						? p->src + (p->src_height - 1 - x) * p->src_stride + y * p->elem
+						: p->src + x * p->src_stride + (p->src_width - 1 - y) * p->elem;
+					_mm_native_copy_elem(d + x * p->elem, s, p->elem);
+				}
+			}
+		}
+	}
+}
+
+static void
+_mm_native_rotate_plane(const imgp_native_kernels_s *k, const imgp_native_plane_s *p, mm_util_img_rotate_type_e angle, unsigned int y_start, unsigned int y_end)
+{
+	unsigned int dst_width = (angle == MM_UTIL_ROTATE_90 || angle == MM_UTIL_ROTATE_270) ? p->src_height : p->src_width;
+	unsigned int tx = 0, ty = 0, y = 0;
+
+	switch(angle) {
+		case MM_UTIL_ROTATE_90:
+		case MM_UTIL_ROTATE_270:
+			for(ty = y_start; ty < y_end; ty += IMGP_NATIVE_ROTATE_TILE) {
+				for(tx = 0; tx < dst_width; tx += IMGP_NATIVE_ROTATE_TILE) {
+					_mm_native_transpose_tile(k, p, angle, tx, IMGP_NATIVE_MIN(tx + IMGP_NATIVE_ROTATE_TILE, dst_width), ty, IMGP_NATIVE_MIN(ty + IMGP_NATIVE_ROTATE_TILE, y_end));
+				}
+			}
+			break;
+		case MM_UTIL_ROTATE_180:
+			for(y = y_start; y < y_end; y++) {
+				_mm_native_reverse_row(k, p->src + (p->src_height - 1 - y) * p->src_stride, p->dst + y * p->dst_stride, p->src_width, p->elem);
+			}
+			break;
+		case MM_UTIL_ROTATE_FLIP_HORZ:
+			for(y = y_start; y < y_end; y++) {
+				_mm_native_reverse_row(k, p->src + y * p->src_stride, p->dst + y * p->dst_stride, p->src_width, p->elem);
+			}
+			break;
+		case MM_UTIL_ROTATE_FLIP_VERT:
+			for(y = y_start; y < y_end; y++) {
+				memcpy(p->dst + y * p->dst_stride, p->src + (p->src_height - 1 - y) * p->src_stride, p->src_width * p->elem);
+			}
+			break;
+		default:
+			for(y = y_start; y < y_end; y++) {
+				memcpy(p->dst + y * p->dst_stride, p->src + y * p->src_stride, p->src_width * p->elem);
+			}
+			break;
+	}
+}
+
+/* YUYV and UYVY : Y of every pixel is moved, U and V of a dst pair come from the source pixel of its first pixel */
+static void
+_mm_native_rotate_packed_422(const imgp_frame_s *src, const imgp_frame_s *dst, mm_util_img_rotate_type_e angle, unsigned int y_start, unsigned int y_end)
+{
+	const unsigned int y_pos = (src->format == MM_UTIL_IMG_FMT_YUYV) ? 0 : 1;
+	const unsigned int uv_pos = 1 - y_pos;
+	const unsigned char *s0 = NULL, *s1 = NULL;
+	unsigned int sx0 = 0, sy0 = 0, sx1 = 0, sy1 = 0;
+	unsigned int tx = 0, ty = 0, x = 0, y = 0;
+	unsigned char *d = NULL;
+
+	for(ty = y_start; ty < y_end; ty += IMGP_NATIVE_ROTATE_TILE) {
+		for(tx = 0; tx < dst->width; tx += IMGP_NATIVE_ROTATE_TILE) {
+			for(y = ty; y < IMGP_NATIVE_MIN(ty + IMGP_NATIVE_ROTATE_TILE, y_end); y++) {
+				d = dst->data[0] + y * dst->stride[0];
+				for(x = tx; x < IMGP_NATIVE_MIN(tx + IMGP_NATIVE_ROTATE_TILE, dst->width); x += 2) {
+					switch(angle) {
+						case MM_UTIL_ROTATE_90:
+							sx0 = y; sy0 = src->height - 1 - x; sx1 = y; sy1 = sy0 - 1;
+							break;
+						case MM_UTIL_ROTATE_270:
+							sx0 = src->width - 1 - y; sy0 = x; sx1 = sx0; sy1 = x + 1;
+							break;
+						case MM_UTIL_ROTATE_180:
+							sx0 = src->width - 1 - x; sy0 = src->height - 1 - y; sx1 = sx0 - 1; sy1 = sy0;
+							break;
+						case MM_UTIL_ROTATE_FLIP_HORZ:
+							sx0 = src->width - 1 - x; sy0 = y; sx1 = sx0 - 1; sy1 = y;
+							break;
+						case MM_UTIL_ROTATE_FLIP_VERT:
+							sx0 = x; sy0 = src->height - 1 - y; sx1 = x + 1; sy1 = sy0;
+							break;
+						default:
+							sx0 = x; sy0 = y; sx1 = x + 1; sy1 = y;
+							break;
+					}
+					s0 = src->data[0] + sy0 * src->stride[0] + (sx0 & ~1) * 2;
+					s1 = src->data[0] + sy1 * src->stride[0] + (sx1 & ~1) * 2;
+					d[x * 2 + y_pos] = s0[(sx0 & 1) * 2 + y_pos];
+					d[x * 2 + 2 + y_pos] = s1[(sx1 & 1) * 2 + y_pos];
+					d[x * 2 + uv_pos] = s0[uv_pos];
+					d[x * 2 + 2 + uv_pos] = s0[2 + uv_pos];
+				}
+			}
+		}
+	}
+}
+
+int
+_mm_native_rotate_supported(mm_util_img_format_e format, mm_util_img_rotate_type_e angle, unsigned int width, unsigned int height)
+{
+	const imgp_format_desc_s *desc = _mm_format_get_desc(format);
+	int transposed = (angle == MM_UTIL_ROTATE_90 || angle == MM_UTIL_ROTATE_270);
+
+	if(desc == NULL || desc->plane_count == 0 || (desc->flags & IMGP_FORMAT_FLAG_TILED) || (unsigned int) angle >= MM_UTIL_ROTATE_NUM) {
+		return 0;
+	}
+	if(format == MM_UTIL_IMG_FMT_YUYV || format == MM_UTIL_IMG_FMT_UYVY) {
+		/* the pairs of pixels sharing U and V must be complete on both sides */
+		return (width % 2 == 0) && (!transposed || height % 2 == 0);
+	}
+	if(transposed && desc->plane[desc->plane_count - 1].x_shift != desc->plane[desc->plane_count - 1].y_shift
+		&& format != MM_UTIL_IMG_FMT_NV12) {
+		/* 4:2:2 planar would become 4:4:0 */
+		return 0;
+	}
+	return 1;
+}
+
+int
+_mm_native_rotate_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end)
+{
+	const imgp_native_kernels_s *k = _mm_native_get_kernels();
+	const imgp_frame_s *src = NULL;
+	const imgp_frame_s *dst = NULL;
+	const imgp_format_desc_s *desc = NULL;
+	imgp_native_plane_s plane;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0;
+	unsigned int i = 0;
+	int transposed = 0;
+
+	if(op == NULL || op->src == NULL || op->dst == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] invalid op", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	src = op->src;
+	dst = op->dst;
+	transposed = (op->angle == MM_UTIL_ROTATE_90 || op->angle == MM_UTIL_ROTATE_270);
+	if(src->format != dst->format || !_mm_native_rotate_supported(src->format, op->angle, src->width, src->height)
+		|| dst->width != (transposed ? src->height : src->width) || dst->height != (transposed ? src->width : src->height)
+		|| y_start > y_end || y_end > dst->height) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] %d %ux%u -> %d %ux%u angle %d rows [%u, %u) is not supported", __func__, __LINE__,
+			src->format, src->width, src->height, dst->format, dst->width, dst->height, op->angle, y_start, y_end);
+		return MM_ERROR_IMAGE_NOT_SUPPORT_FORMAT;
+	}
+
+	if(src->format == MM_UTIL_IMG_FMT_YUYV || src->format == MM_UTIL_IMG_FMT_UYVY) {
+		_mm_native_rotate_packed_422(src, dst, op->angle, y_start, y_end);
+		return MM_ERROR_NONE;
+	}
+
+	desc = _mm_format_get_desc(src->format);
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(src->format, i, &elem, &x_shift, &y_shift);
+		plane.elem = elem;
+		plane.src = src->data[i];
+		plane.src_stride = src->stride[i];
+		plane.src_width = (src->width + (1 << x_shift) - 1) >> x_shift;
+		plane.src_height = (src->height + (1 << y_shift) - 1) >> y_shift;
+		plane.dst = dst->data[i];
+		plane.dst_stride = dst->stride[i];
+		/* y_start is even, the last stripe takes the last chroma row of an odd height */
+		_mm_native_rotate_plane(k, &plane, op->angle, y_start >> y_shift,
+			(y_end == dst->height) ? (dst->height + (1 << y_shift) - 1) >> y_shift : y_end >> y_shift);
+	}
+	return MM_ERROR_NONE;
+}
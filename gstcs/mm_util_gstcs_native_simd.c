@@ -0,0 +1,630 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_native.h"
+
+/*
+ * The SIMD kernels keep the 32 bit intermediate values of the C kernels, so their output is identical.
+ * x86 kernels are built with target attributes and only called after cpu feature detection,
+ * the NEON kernels are only built when the target has NEON.
+ */
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+
+/* two 16 bit coefficients for _mm_madd_epi16, c0 multiplies the even lane */
+#define IMGP_NATIVE_PAIR(c0, c1) ((int) (((unsigned int) (unsigned short) (c1) << 16) | (unsigned short) (c0)))
+
+__attribute__((target("sse2"))) unsigned int
+_mm_native_yuv420_to_rgb32_row_sse2(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha = _mm_set1_epi8((char) 0xff);
+	const __m128i y_offset = _mm_set1_epi16(coeffs->y_offset);
+	const __m128i c128 = _mm_set1_epi16(128);
+	const __m128i low_byte = _mm_set1_epi16(0x00ff);
+	const __m128i round = _mm_set1_epi32(1 << (IMGP_NATIVE_SCALEBITS - 1));
+	const __m128i y_r = _mm_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->r_cr));
+	const __m128i y_g = _mm_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->g_cb));
+	const __m128i v_g = _mm_set1_epi32(IMGP_NATIVE_PAIR(coeffs->g_cr, 0));
+	const __m128i y_b = _mm_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->b_cb));
+	unsigned int x = 0;
+
+	for(x = 0; x + 8 <= width; x += 8) {
+		__m128i y16, u16, v16, lo, hi, r, g, b;
+		int chroma = 0;
+
+		y16 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (y + x)), zero), y_offset);
+		if(uv_step == 2) { /* u and v are interleaved, v is u + 1 */
+			__m128i uv = _mm_loadl_epi64((const __m128i*) (u + x));
+			u16 = _mm_and_si128(uv, low_byte);
+			v16 = _mm_srli_epi16(uv, 8);
+		}else {
+			memcpy(&chroma, u + (x >> 1), 4);
+			u16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(chroma), zero);
+			memcpy(&chroma, v + (x >> 1), 4);
+			v16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(chroma), zero);
+		}
+		/* one chroma sample for 2 pixels */
+		u16 = _mm_sub_epi16(_mm_unpacklo_epi16(u16, u16), c128);
+		v16 = _mm_sub_epi16(_mm_unpacklo_epi16(v16, v16), c128);
+
+		lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y16, v16), y_r), round), IMGP_NATIVE_SCALEBITS);
+		hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y16, v16), y_r), round), IMGP_NATIVE_SCALEBITS);
+		r = _mm_packs_epi32(lo, hi);
+
+		lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y16, u16), y_g), _mm_madd_epi16(_mm_unpacklo_epi16(v16, zero), v_g));
+		hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y16, u16), y_g), _mm_madd_epi16(_mm_unpackhi_epi16(v16, zero), v_g));
+		g = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, round), IMGP_NATIVE_SCALEBITS), _mm_srai_epi32(_mm_add_epi32(hi, round), IMGP_NATIVE_SCALEBITS));
+
+		lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y16, u16), y_b), round), IMGP_NATIVE_SCALEBITS);
+		hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y16, u16), y_b), round), IMGP_NATIVE_SCALEBITS);
+		b = _mm_packs_epi32(lo, hi);
+
+		/* saturation to 0 ~ 255 is the crop table of ffmpegcolorspace */
+		r = _mm_packus_epi16(r, r);
+		g = _mm_packus_epi16(g, g);
+		b = _mm_packus_epi16(b, b);
+		if(order == IMGP_NATIVE_RGB32_BGRA) {
+			lo = _mm_unpacklo_epi8(b, g);
+			hi = _mm_unpacklo_epi8(r, alpha);
+		}else {
+			lo = _mm_unpacklo_epi8(alpha, r);
+			hi = _mm_unpacklo_epi8(g, b);
+		}
+		_mm_storeu_si128((__m128i*) (dst + x * 4), _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128((__m128i*) (dst + x * 4 + 16), _mm_unpackhi_epi16(lo, hi));
+	}
+	return x;
+}
+
+__attribute__((target("avx2"))) unsigned int
+_mm_native_yuv420_to_rgb32_row_avx2(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha = _mm256_set1_epi8((char) 0xff);
+	const __m256i y_offset = _mm256_set1_epi16(coeffs->y_offset);
+	const __m256i c128 = _mm256_set1_epi16(128);
+	const __m128i low_byte = _mm_set1_epi16(0x00ff);
+	const __m256i round = _mm256_set1_epi32(1 << (IMGP_NATIVE_SCALEBITS - 1));
+	const __m256i y_r = _mm256_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->r_cr));
+	const __m256i y_g = _mm256_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->g_cb));
+	const __m256i v_g = _mm256_set1_epi32(IMGP_NATIVE_PAIR(coeffs->g_cr, 0));
+	const __m256i y_b = _mm256_set1_epi32(IMGP_NATIVE_PAIR(coeffs->y_scale, coeffs->b_cb));
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= width; x += 16) {
+		__m256i y16, u16, v16, lo, hi, r, g, b;
+		__m128i u8, v8;
+
+		y16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (y + x))), y_offset);
+		if(uv_step == 2) { /* u and v are interleaved, v is u + 1 */
+			__m128i uv = _mm_loadu_si128((const __m128i*) (u + x));
+			u8 = _mm_packus_epi16(_mm_and_si128(uv, low_byte), _mm_setzero_si128());
+			v8 = _mm_packus_epi16(_mm_srli_epi16(uv, 8), _mm_setzero_si128());
+		}else {
+			u8 = _mm_loadl_epi64((const __m128i*) (u + (x >> 1)));
+			v8 = _mm_loadl_epi64((const __m128i*) (v + (x >> 1)));
+		}
+		/* one chroma sample for 2 pixels */
+		u16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8)), c128);
+		v16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8)), c128);
+
+		/* unpack and pack work inside each 128 bit lane, so the pixels stay in order after packs */
+		lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y16, v16), y_r), round), IMGP_NATIVE_SCALEBITS);
+		hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y16, v16), y_r), round), IMGP_NATIVE_SCALEBITS);
+		r = _mm256_packs_epi32(lo, hi);
+
+		lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y16, u16), y_g), _mm256_madd_epi16(_mm256_unpacklo_epi16(v16, zero), v_g));
+		hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y16, u16), y_g), _mm256_madd_epi16(_mm256_unpackhi_epi16(v16, zero), v_g));
+		g = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(lo, round), IMGP_NATIVE_SCALEBITS), _mm256_srai_epi32(_mm256_add_epi32(hi, round), IMGP_NATIVE_SCALEBITS));
+
+		lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y16, u16), y_b), round), IMGP_NATIVE_SCALEBITS);
+		hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y16, u16), y_b), round), IMGP_NATIVE_SCALEBITS);
+		b = _mm256_packs_epi32(lo, hi);
+
+		r = _mm256_packus_epi16(r, r);
+		g = _mm256_packus_epi16(g, g);
+		b = _mm256_packus_epi16(b, b);
+		if(order == IMGP_NATIVE_RGB32_BGRA) {
+			lo = _mm256_unpacklo_epi8(b, g);
+			hi = _mm256_unpacklo_epi8(r, alpha);
+		}else {
+			lo = _mm256_unpacklo_epi8(alpha, r);
+			hi = _mm256_unpacklo_epi8(g, b);
+		}
+		/* pixels 0-3 and 8-11 are in the first register, 4-7 and 12-15 in the second one */
+		r = _mm256_unpacklo_epi16(lo, hi);
+		g = _mm256_unpackhi_epi16(lo, hi);
+		_mm256_storeu_si256((__m256i*) (dst + x * 4), _mm256_permute2x128_si256(r, g, 0x20));
+		_mm256_storeu_si256((__m256i*) (dst + x * 4 + 32), _mm256_permute2x128_si256(r, g, 0x31));
+	}
+	return x;
+}
+
+/* 8x8 bytes: the rows are interleaved by bytes, then 16 and 32 bit units until every register holds 2 columns */
+__attribute__((target("sse2"))) void
+_mm_native_transpose_u8_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	__m128i r0, r1, r2, r3, r4, r5, r6, r7, t0, t1, t2, t3;
+
+	r0 = _mm_loadl_epi64((const __m128i*) (src));
+	r1 = _mm_loadl_epi64((const __m128i*) (src + src_stride));
+	r2 = _mm_loadl_epi64((const __m128i*) (src + 2 * src_stride));
+	r3 = _mm_loadl_epi64((const __m128i*) (src + 3 * src_stride));
+	r4 = _mm_loadl_epi64((const __m128i*) (src + 4 * src_stride));
+	r5 = _mm_loadl_epi64((const __m128i*) (src + 5 * src_stride));
+	r6 = _mm_loadl_epi64((const __m128i*) (src + 6 * src_stride));
+	r7 = _mm_loadl_epi64((const __m128i*) (src + 7 * src_stride));
+
+	t0 = _mm_unpacklo_epi8(r0, r1);
+	t1 = _mm_unpacklo_epi8(r2, r3);
+	t2 = _mm_unpacklo_epi8(r4, r5);
+	t3 = _mm_unpacklo_epi8(r6, r7);
+
+	r0 = _mm_unpacklo_epi16(t0, t1);  /* rows 0-3 of the columns 0-3 */
+	r1 = _mm_unpackhi_epi16(t0, t1);  /* rows 0-3 of the columns 4-7 */
+	r2 = _mm_unpacklo_epi16(t2, t3);
+	r3 = _mm_unpackhi_epi16(t2, t3);
+
+	t0 = _mm_unpacklo_epi32(r0, r2);  /* columns 0 and 1 */
+	t1 = _mm_unpackhi_epi32(r0, r2);
+	t2 = _mm_unpacklo_epi32(r1, r3);
+	t3 = _mm_unpackhi_epi32(r1, r3);
+
+	_mm_storel_epi64((__m128i*) (dst), t0);
+	_mm_storel_epi64((__m128i*) (dst + dst_stride), _mm_unpackhi_epi64(t0, t0));
+	_mm_storel_epi64((__m128i*) (dst + 2 * dst_stride), t1);
+	_mm_storel_epi64((__m128i*) (dst + 3 * dst_stride), _mm_unpackhi_epi64(t1, t1));
+	_mm_storel_epi64((__m128i*) (dst + 4 * dst_stride), t2);
+	_mm_storel_epi64((__m128i*) (dst + 5 * dst_stride), _mm_unpackhi_epi64(t2, t2));
+	_mm_storel_epi64((__m128i*) (dst + 6 * dst_stride), t3);
+	_mm_storel_epi64((__m128i*) (dst + 7 * dst_stride), _mm_unpackhi_epi64(t3, t3));
+}
+
+__attribute__((target("sse2"))) void
+_mm_native_transpose_u16_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	__m128i r[8], t[8];
+	int i = 0;
+
+	for(i = 0; i < 8; i++) {
+		r[i] = _mm_loadu_si128((const __m128i*) (src + i * src_stride));
+	}
+	for(i = 0; i < 8; i += 2) {
+		t[i] = _mm_unpacklo_epi16(r[i], r[i + 1]);      /* columns 0-3 of 2 rows */
+		t[i + 1] = _mm_unpackhi_epi16(r[i], r[i + 1]);  /* columns 4-7 of 2 rows */
+	}
+	for(i = 0; i < 8; i += 4) {
+		r[i] = _mm_unpacklo_epi32(t[i], t[i + 2]);      /* columns 0 and 1 of 4 rows */
+		r[i + 1] = _mm_unpackhi_epi32(t[i], t[i + 2]);  /* columns 2 and 3 */
+		r[i + 2] = _mm_unpacklo_epi32(t[i + 1], t[i + 3]);
+		r[i + 3] = _mm_unpackhi_epi32(t[i + 1], t[i + 3]);
+	}
+	for(i = 0; i < 4; i++) {
+		_mm_storeu_si128((__m128i*) (dst + 2 * i * dst_stride), _mm_unpacklo_epi64(r[i], r[i + 4]));
+		_mm_storeu_si128((__m128i*) (dst + (2 * i + 1) * dst_stride), _mm_unpackhi_epi64(r[i], r[i + 4]));
+	}
+}
+
+__attribute__((target("sse2"))) void
+_mm_native_transpose_u32_sse2(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	__m128i r0, r1, r2, r3, t0, t1, t2, t3;
+
+	r0 = _mm_loadu_si128((const __m128i*) (src));
+	r1 = _mm_loadu_si128((const __m128i*) (src + src_stride));
+	r2 = _mm_loadu_si128((const __m128i*) (src + 2 * src_stride));
+	r3 = _mm_loadu_si128((const __m128i*) (src + 3 * src_stride));
+
+	t0 = _mm_unpacklo_epi32(r0, r1);
+	t1 = _mm_unpacklo_epi32(r2, r3);
+	t2 = _mm_unpackhi_epi32(r0, r1);
+	t3 = _mm_unpackhi_epi32(r2, r3);
+
+	_mm_storeu_si128((__m128i*) (dst), _mm_unpacklo_epi64(t0, t1));
+	_mm_storeu_si128((__m128i*) (dst + dst_stride), _mm_unpackhi_epi64(t0, t1));
+	_mm_storeu_si128((__m128i*) (dst + 2 * dst_stride), _mm_unpacklo_epi64(t2, t3));
+	_mm_storeu_si128((__m128i*) (dst + 3 * dst_stride), _mm_unpackhi_epi64(t2, t3));
+}
+
+/* the rows are reversed by 16 bytes read from the end of src, SSE2 has no byte shuffle so the 32 bit units are
+ * reversed first, then the 16 bit units and the bytes inside them */
+__attribute__((target("sse2"))) unsigned int
+_mm_native_reverse_u32_sse2(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 4 <= count; x += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + (count - x - 4) * 4));
+		_mm_storeu_si128((__m128i*) (dst + x * 4), _mm_shuffle_epi32(v, 0x1b));
+	}
+	return x;
+}
+
+__attribute__((target("sse2"))) unsigned int
+_mm_native_reverse_u16_sse2(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 8 <= count; x += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + (count - x - 8) * 2));
+		v = _mm_shuffle_epi32(v, 0x1b);
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+		_mm_storeu_si128((__m128i*) (dst + x * 2), v);
+	}
+	return x;
+}
+
+__attribute__((target("sse2"))) unsigned int
+_mm_native_reverse_u8_sse2(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + count - x - 16));
+		v = _mm_shuffle_epi32(v, 0x1b);
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*) (dst + x), v);
+	}
+	return x;
+}
+
+/* 8 bytes of 2 rows are interleaved, so that _mm_madd_epi16 applies the weights of 2 taps at once */
+__attribute__((target("sse2"))) unsigned int
+_mm_native_resize_vertical_sse2(const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << (IMGP_NATIVE_RESIZE_BITS - 1));
+	unsigned int x = 0, t = 0;
+
+	for(x = 0; x + 8 <= count; x += 8) {
+		__m128i lo = round, hi = round, a, b, w;
+
+		for(t = 0; t + 2 <= taps; t += 2) {
+			a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (rows[t] + x)), zero);
+			b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (rows[t + 1] + x)), zero);
+			w = _mm_set1_epi32(IMGP_NATIVE_PAIR(weights[t], weights[t + 1]));
+			lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+			hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+		}
+		if(t < taps) {
+			a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (rows[t] + x)), zero);
+			w = _mm_set1_epi32(IMGP_NATIVE_PAIR(weights[t], 0));
+			lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), w));
+			hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, zero), w));
+		}
+		lo = _mm_srai_epi32(lo, IMGP_NATIVE_RESIZE_BITS);
+		hi = _mm_srai_epi32(hi, IMGP_NATIVE_RESIZE_BITS);
+		_mm_storel_epi64((__m128i*) (dst + x), _mm_packus_epi16(_mm_packs_epi32(lo, hi), zero));
+	}
+	return x;
+}
+
+/* the 4 components of 2 neighbour pixels are interleaved, so that _mm_madd_epi16 applies the weights of 2 taps at once */
+__attribute__((target("sse2"))) unsigned int
+_mm_native_resize_horizontal_u8x4_sse2(const unsigned char *src, const int *start, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << (IMGP_NATIVE_RESIZE_BITS - 1));
+	unsigned int i = 0, t = 0;
+	int pixel = 0;
+
+	for(i = 0; i < count; i++) {
+		const unsigned char *in = src + start[i] * 4;
+		const short *w = weights + i * taps;
+		__m128i sum = round, p;
+
+		for(t = 0; t + 2 <= taps; t += 2) {
+			p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (in + t * 4)), zero);
+			p = _mm_unpacklo_epi16(p, _mm_srli_si128(p, 8));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(p, _mm_set1_epi32(IMGP_NATIVE_PAIR(w[t], w[t + 1]))));
+		}
+		if(t < taps) {
+			memcpy(&pixel, in + t * 4, 4);
+			p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(p, _mm_set1_epi32(IMGP_NATIVE_PAIR(w[t], 0))));
+		}
+		sum = _mm_srai_epi32(sum, IMGP_NATIVE_RESIZE_BITS);
+		sum = _mm_packs_epi32(sum, sum);
+		pixel = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+		memcpy(dst + i * 4, &pixel, 4);
+	}
+	return count;
+}
+
+/* the even bytes are masked and the odd ones shifted down, packus puts 16 of each in a register */
+__attribute__((target("sse2"))) unsigned int
+_mm_native_split_uv_sse2(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count)
+{
+	const __m128i mask = _mm_set1_epi16(0x00ff);
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*) (uv + x * 2));
+		__m128i b = _mm_loadu_si128((const __m128i*) (uv + x * 2 + 16));
+		_mm_storeu_si128((__m128i*) (u + x), _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i*) (v + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+	return x;
+}
+
+__attribute__((target("sse2"))) unsigned int
+_mm_native_merge_uv_sse2(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*) (u + x));
+		__m128i b = _mm_loadu_si128((const __m128i*) (v + x));
+		_mm_storeu_si128((__m128i*) (uv + x * 2), _mm_unpacklo_epi8(a, b));
+		_mm_storeu_si128((__m128i*) (uv + x * 2 + 16), _mm_unpackhi_epi8(a, b));
+	}
+	return x;
+}
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+
+unsigned int
+_mm_native_yuv420_to_rgb32_row_neon(const unsigned char *y, const unsigned char *u, const unsigned char *v, unsigned int uv_step,
+	unsigned char *dst, unsigned int width, const imgp_yuv_coeffs_s *coeffs, imgp_native_rgb32_order_e order)
+{
+	const int16x8_t y_offset = vdupq_n_s16(coeffs->y_offset);
+	const int16x8_t c128 = vdupq_n_s16(128);
+	const int32x4_t round = vdupq_n_s32(1 << (IMGP_NATIVE_SCALEBITS - 1));
+	const uint8x8_t alpha = vdup_n_u8(0xff);
+	unsigned int x = 0;
+
+	for(x = 0; x + 8 <= width; x += 8) {
+		int16x8_t y16, u16, v16;
+		int32x4_t y_lo, y_hi, lo, hi;
+		uint8x8_t r, g, b;
+		uint8x8x4_t pixel;
+
+		y16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), y_offset);
+		if(uv_step == 2) { /* u and v are interleaved, v is u + 1 */
+			int16x8_t uv = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x)));
+			int16x8x2_t split = vuzpq_s16(uv, uv);
+			u16 = split.val[0];
+			v16 = split.val[1];
+		}else {
+			unsigned int chroma = 0;
+			memcpy(&chroma, u + (x >> 1), 4);
+			u16 = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(chroma))));
+			memcpy(&chroma, v + (x >> 1), 4);
+			v16 = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(chroma))));
+		}
+		/* one chroma sample for 2 pixels, only the first 4 samples are used */
+		u16 = vsubq_s16(vzipq_s16(u16, u16).val[0], c128);
+		v16 = vsubq_s16(vzipq_s16(v16, v16).val[0], c128);
+
+		y_lo = vaddq_s32(vmull_n_s16(vget_low_s16(y16), coeffs->y_scale), round);
+		y_hi = vaddq_s32(vmull_n_s16(vget_high_s16(y16), coeffs->y_scale), round);
+
+		/* saturating narrow, then saturation to 0 ~ 255 as the crop table of ffmpegcolorspace */
+		lo = vmlal_n_s16(y_lo, vget_low_s16(v16), coeffs->r_cr);
+		hi = vmlal_n_s16(y_hi, vget_high_s16(v16), coeffs->r_cr);
+		r = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, IMGP_NATIVE_SCALEBITS), vqshrn_n_s32(hi, IMGP_NATIVE_SCALEBITS)));
+
+		lo = vmlal_n_s16(vmlal_n_s16(y_lo, vget_low_s16(u16), coeffs->g_cb), vget_low_s16(v16), coeffs->g_cr);
+		hi = vmlal_n_s16(vmlal_n_s16(y_hi, vget_high_s16(u16), coeffs->g_cb), vget_high_s16(v16), coeffs->g_cr);
+		g = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, IMGP_NATIVE_SCALEBITS), vqshrn_n_s32(hi, IMGP_NATIVE_SCALEBITS)));
+
+		lo = vmlal_n_s16(y_lo, vget_low_s16(u16), coeffs->b_cb);
+		hi = vmlal_n_s16(y_hi, vget_high_s16(u16), coeffs->b_cb);
+		b = vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, IMGP_NATIVE_SCALEBITS), vqshrn_n_s32(hi, IMGP_NATIVE_SCALEBITS)));
+
+		if(order == IMGP_NATIVE_RGB32_BGRA) {
+			pixel.val[0] = b; pixel.val[1] = g; pixel.val[2] = r; pixel.val[3] = alpha;
+		}else {
+			pixel.val[0] = alpha; pixel.val[1] = r; pixel.val[2] = g; pixel.val[3] = b;
+		}
+		vst4_u8(dst + x * 4, pixel);
+	}
+	return x;
+}
+
+/* 8x8 bytes: vtrn of bytes, 16 and 32 bit units leaves one column in each register */
+void
+_mm_native_transpose_u8_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	uint8x8x2_t t01, t23, t45, t67;
+	uint16x4x2_t s02, s13, s46, s57;
+	uint32x2x2_t q04, q15, q26, q37;
+
+	t01 = vtrn_u8(vld1_u8(src), vld1_u8(src + src_stride));
+	t23 = vtrn_u8(vld1_u8(src + 2 * src_stride), vld1_u8(src + 3 * src_stride));
+	t45 = vtrn_u8(vld1_u8(src + 4 * src_stride), vld1_u8(src + 5 * src_stride));
+	t67 = vtrn_u8(vld1_u8(src + 6 * src_stride), vld1_u8(src + 7 * src_stride));
+
+	s02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+	s13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+	s46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+	s57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+
+	q04 = vtrn_u32(vreinterpret_u32_u16(s02.val[0]), vreinterpret_u32_u16(s46.val[0]));
+	q26 = vtrn_u32(vreinterpret_u32_u16(s02.val[1]), vreinterpret_u32_u16(s46.val[1]));
+	q15 = vtrn_u32(vreinterpret_u32_u16(s13.val[0]), vreinterpret_u32_u16(s57.val[0]));
+	q37 = vtrn_u32(vreinterpret_u32_u16(s13.val[1]), vreinterpret_u32_u16(s57.val[1]));
+
+	vst1_u8(dst, vreinterpret_u8_u32(q04.val[0]));
+	vst1_u8(dst + dst_stride, vreinterpret_u8_u32(q15.val[0]));
+	vst1_u8(dst + 2 * dst_stride, vreinterpret_u8_u32(q26.val[0]));
+	vst1_u8(dst + 3 * dst_stride, vreinterpret_u8_u32(q37.val[0]));
+	vst1_u8(dst + 4 * dst_stride, vreinterpret_u8_u32(q04.val[1]));
+	vst1_u8(dst + 5 * dst_stride, vreinterpret_u8_u32(q15.val[1]));
+	vst1_u8(dst + 6 * dst_stride, vreinterpret_u8_u32(q26.val[1]));
+	vst1_u8(dst + 7 * dst_stride, vreinterpret_u8_u32(q37.val[1]));
+}
+
+void
+_mm_native_transpose_u16_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	uint16x8x2_t t01, t23, t45, t67;
+	uint32x4x2_t s02, s13, s46, s57;
+
+	t01 = vtrnq_u16(vld1q_u16((const uint16_t*) (src)), vld1q_u16((const uint16_t*) (src + src_stride)));
+	t23 = vtrnq_u16(vld1q_u16((const uint16_t*) (src + 2 * src_stride)), vld1q_u16((const uint16_t*) (src + 3 * src_stride)));
+	t45 = vtrnq_u16(vld1q_u16((const uint16_t*) (src + 4 * src_stride)), vld1q_u16((const uint16_t*) (src + 5 * src_stride)));
+	t67 = vtrnq_u16(vld1q_u16((const uint16_t*) (src + 6 * src_stride)), vld1q_u16((const uint16_t*) (src + 7 * src_stride)));
+
+	/* columns 0 and 4 of 4 rows in s02.val[0], 2 and 6 in s02.val[1] */
+	s02 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]), vreinterpretq_u32_u16(t23.val[0]));
+	s13 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]), vreinterpretq_u32_u16(t23.val[1]));
+	s46 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]), vreinterpretq_u32_u16(t67.val[0]));
+	s57 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]), vreinterpretq_u32_u16(t67.val[1]));
+
+	vst1q_u32((uint32_t*) (dst), vcombine_u32(vget_low_u32(s02.val[0]), vget_low_u32(s46.val[0])));
+	vst1q_u32((uint32_t*) (dst + dst_stride), vcombine_u32(vget_low_u32(s13.val[0]), vget_low_u32(s57.val[0])));
+	vst1q_u32((uint32_t*) (dst + 2 * dst_stride), vcombine_u32(vget_low_u32(s02.val[1]), vget_low_u32(s46.val[1])));
+	vst1q_u32((uint32_t*) (dst + 3 * dst_stride), vcombine_u32(vget_low_u32(s13.val[1]), vget_low_u32(s57.val[1])));
+	vst1q_u32((uint32_t*) (dst + 4 * dst_stride), vcombine_u32(vget_high_u32(s02.val[0]), vget_high_u32(s46.val[0])));
+	vst1q_u32((uint32_t*) (dst + 5 * dst_stride), vcombine_u32(vget_high_u32(s13.val[0]), vget_high_u32(s57.val[0])));
+	vst1q_u32((uint32_t*) (dst + 6 * dst_stride), vcombine_u32(vget_high_u32(s02.val[1]), vget_high_u32(s46.val[1])));
+	vst1q_u32((uint32_t*) (dst + 7 * dst_stride), vcombine_u32(vget_high_u32(s13.val[1]), vget_high_u32(s57.val[1])));
+}
+
+void
+_mm_native_transpose_u32_neon(const unsigned char *src, int src_stride, unsigned char *dst, int dst_stride)
+{
+	uint32x4x2_t t01, t23;
+
+	t01 = vtrnq_u32(vld1q_u32((const uint32_t*) (src)), vld1q_u32((const uint32_t*) (src + src_stride)));
+	t23 = vtrnq_u32(vld1q_u32((const uint32_t*) (src + 2 * src_stride)), vld1q_u32((const uint32_t*) (src + 3 * src_stride)));
+
+	vst1q_u32((uint32_t*) (dst), vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+	vst1q_u32((uint32_t*) (dst + dst_stride), vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+	vst1q_u32((uint32_t*) (dst + 2 * dst_stride), vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+	vst1q_u32((uint32_t*) (dst + 3 * dst_stride), vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+}
+
+/* vrev64 reverses each half of the register, the halves are swapped after it */
+unsigned int
+_mm_native_reverse_u8_neon(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		uint8x16_t v = vrev64q_u8(vld1q_u8(src + count - x - 16));
+		vst1q_u8(dst + x, vcombine_u8(vget_high_u8(v), vget_low_u8(v)));
+	}
+	return x;
+}
+
+unsigned int
+_mm_native_reverse_u16_neon(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 8 <= count; x += 8) {
+		uint16x8_t v = vrev64q_u16(vld1q_u16((const uint16_t*) (src + (count - x - 8) * 2)));
+		vst1q_u16((uint16_t*) (dst + x * 2), vcombine_u16(vget_high_u16(v), vget_low_u16(v)));
+	}
+	return x;
+}
+
+unsigned int
+_mm_native_reverse_u32_neon(const unsigned char *src, unsigned char *dst, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 4 <= count; x += 4) {
+		uint32x4_t v = vrev64q_u32(vld1q_u32((const uint32_t*) (src + (count - x - 4) * 4)));
+		vst1q_u32((uint32_t*) (dst + x * 4), vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+	}
+	return x;
+}
+
+unsigned int
+_mm_native_resize_vertical_neon(const unsigned char *const *rows, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count)
+{
+	const int32x4_t round = vdupq_n_s32(1 << (IMGP_NATIVE_RESIZE_BITS - 1));
+	unsigned int x = 0, t = 0;
+
+	for(x = 0; x + 8 <= count; x += 8) {
+		int32x4_t lo = round, hi = round;
+
+		for(t = 0; t < taps; t++) {
+			int16x8_t v = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows[t] + x)));
+			lo = vmlal_n_s16(lo, vget_low_s16(v), weights[t]);
+			hi = vmlal_n_s16(hi, vget_high_s16(v), weights[t]);
+		}
+		/* saturating narrow, then saturation to 0 ~ 255 as the C pass clips */
+		vst1_u8(dst + x, vqmovun_s16(vcombine_s16(vqshrn_n_s32(lo, IMGP_NATIVE_RESIZE_BITS), vqshrn_n_s32(hi, IMGP_NATIVE_RESIZE_BITS))));
+	}
+	return x;
+}
+
+unsigned int
+_mm_native_resize_horizontal_u8x4_neon(const unsigned char *src, const int *start, const short *weights, unsigned int taps, unsigned char *dst, unsigned int count)
+{
+	const int32x4_t round = vdupq_n_s32(1 << (IMGP_NATIVE_RESIZE_BITS - 1));
+	unsigned int i = 0, t = 0;
+	uint32_t pixel = 0;
+
+	for(i = 0; i < count; i++) {
+		const unsigned char *in = src + start[i] * 4;
+		const short *w = weights + i * taps;
+		int32x4_t sum = round;
+		int16x4_t narrow;
+
+		for(t = 0; t < taps; t++) {
+			memcpy(&pixel, in + t * 4, 4);
+			sum = vmlal_n_s16(sum, vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixel))))), w[t]);
+		}
+		narrow = vqshrn_n_s32(sum, IMGP_NATIVE_RESIZE_BITS);
+		pixel = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(narrow, narrow))), 0);
+		memcpy(dst + i * 4, &pixel, 4);
+	}
+	return count;
+}
+
+unsigned int
+_mm_native_split_uv_neon(const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		uint8x16x2_t pair = vld2q_u8(uv + x * 2);
+		vst1q_u8(u + x, pair.val[0]);
+		vst1q_u8(v + x, pair.val[1]);
+	}
+	return x;
+}
+
+unsigned int
+_mm_native_merge_uv_neon(const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count)
+{
+	unsigned int x = 0;
+
+	for(x = 0; x + 16 <= count; x += 16) {
+		uint8x16x2_t pair;
+		pair.val[0] = vld1q_u8(u + x);
+		pair.val[1] = vld1q_u8(v + x);
+		vst2q_u8(uv + x * 2, pair);
+	}
+	return x;
+}
+
+#endif
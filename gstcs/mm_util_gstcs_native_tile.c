@@ -0,0 +1,238 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_format.h"
+#include <stdlib.h>
+#include <string.h>
+#include <mm_debug.h>
+#include <mm_error.h>
+
+/*
+ * NV12 tiled stores each plane in tiles of IMGP_NATIVE_TILE_WIDTH bytes x IMGP_NATIVE_TILE_HEIGHT rows,
+ * 2048 contiguous bytes, the chroma tiles hold 32 interleaved CbCr pairs. A plane is an even number of tiles
+ * wide and the tiles of 2 rows of tiles are stored in groups of 4 in Z order, one group out of 2 flipped:
+ *   row 0: 0 1 6 7 8 9 ...
+ *   row 1: 2 3 4 5 10 11 ...
+ * the last row of an odd number of rows is linear.
+ * The rows of a frame are walked a row of tiles at a time and every tile of it in turn, so a tile is read or
+ * written once as a whole while the 64 bytes of each of its rows go to a row of the linear frame.
+ * To / from RGB the row of tiles goes through a NV12 band which stays in the cache between the two passes.
+ */
+
+#define IMGP_NATIVE_TILE_SIZE (IMGP_NATIVE_TILE_WIDTH * IMGP_NATIVE_TILE_HEIGHT)
+
+typedef enum
+{
+	IMGP_NATIVE_TILE_READ = 0,      /* tiles -> rows */
+	IMGP_NATIVE_TILE_READ_SPLIT,    /* tiles of CbCr -> rows of Cb and of Cr */
+	IMGP_NATIVE_TILE_WRITE,         /* rows -> tiles */
+	IMGP_NATIVE_TILE_WRITE_MERGE,   /* rows of Cb and of Cr -> tiles of CbCr */
+} imgp_native_tile_walk_e;
+
+/* a tiled plane and the rows of the frame it covers */
+typedef struct _imgp_native_tiled_plane_s
+{
+	unsigned char *tiles;
+	unsigned int x_tiles;       /* always even */
+	unsigned int y_tiles;
+	unsigned int bytes;         /* bytes of a row of the image */
+} imgp_native_tiled_plane_s;
+
+static inline unsigned int
+_mm_native_tile_index(unsigned int x, unsigned int y, unsigned int x_tiles, unsigned int y_tiles)
+{
+	unsigned int index = (y & ~1) * x_tiles + x;
+
+	if(y & 1) {
+		/* odd rows are 2 tiles after the even one, Z to the left */
+		index += (x & ~3) + 2;
+	}else if((y_tiles & 1) == 0 || y != y_tiles - 1) {
+		/* even rows, unless it is the last of an odd number of rows */
+		index += (x + 2) & ~3;
+	}
+	return index;
+}
+
+static void
+_mm_native_split_uv(const imgp_native_kernels_s *k, const unsigned char *uv, unsigned char *u, unsigned char *v, unsigned int count)
+{
+	unsigned int i = k->split_uv ? k->split_uv(uv, u, v, count) : 0;
+
+	for(; i < count; i++) {
+		u[i] = uv[i * 2];
+		v[i] = uv[i * 2 + 1];
+	}
+}
+
+static void
+_mm_native_merge_uv(const imgp_native_kernels_s *k, const unsigned char *u, const unsigned char *v, unsigned char *uv, unsigned int count)
+{
+	unsigned int i = k->merge_uv ? k->merge_uv(u, v, uv, count) : 0;
+
+	for(; i < count; i++) {
+		uv[i * 2] = u[i];
+		uv[i * 2 + 1] = v[i];
+	}
+}
+
+/* move the rows [y_start, y_end) of a tiled plane from / to linear[], whose first row is y_start.
+ * linear[1] is the Cr plane of the split and merge walks, the strides of the Cb and Cr rows are for half the bytes */
+static void
+_mm_native_tile_walk(const imgp_native_tiled_plane_s *plane, imgp_native_tile_walk_e walk,
+	unsigned char *const *linear, const unsigned int *stride, unsigned int y_start, unsigned int y_end)
+{
+	const imgp_native_kernels_s *k = _mm_native_get_kernels();
+	unsigned char *tile = NULL;
+	size_t offset = 0;
+	unsigned int band_end = 0, count = 0;
+	unsigned int x = 0, y = 0, row = 0;
+
+	for(y = y_start; y < y_end; y = band_end) {
+		band_end = IMGP_NATIVE_MIN((y / IMGP_NATIVE_TILE_HEIGHT + 1) * IMGP_NATIVE_TILE_HEIGHT, y_end);
+		for(x = 0; x * IMGP_NATIVE_TILE_WIDTH < plane->bytes; x++) {
+			tile = plane->tiles + (size_t) _mm_native_tile_index(x, y / IMGP_NATIVE_TILE_HEIGHT, plane->x_tiles, plane->y_tiles) * IMGP_NATIVE_TILE_SIZE
+				+ (y % IMGP_NATIVE_TILE_HEIGHT) * IMGP_NATIVE_TILE_WIDTH;
+			count = IMGP_NATIVE_MIN(IMGP_NATIVE_TILE_WIDTH, plane->bytes - x * IMGP_NATIVE_TILE_WIDTH);
+			for(row = y; row < band_end; row++, tile += IMGP_NATIVE_TILE_WIDTH) {
+				switch(walk) {
+					case IMGP_NATIVE_TILE_READ:
+						memcpy(linear[0] + (size_t) (row - y_start) * stride[0] + x * IMGP_NATIVE_TILE_WIDTH, tile, count);
+						break;
+					case IMGP_NATIVE_TILE_WRITE:
+						memcpy(tile, linear[0] + (size_t) (row - y_start) * stride[0] + x * IMGP_NATIVE_TILE_WIDTH, count);
+						break;
+					case IMGP_NATIVE_TILE_READ_SPLIT:
+						offset = x * IMGP_NATIVE_TILE_WIDTH / 2;
+						_mm_native_split_uv(k, tile, linear[0] + (size_t) (row - y_start) * stride[0] + offset,
+							linear[1] + (size_t) (row - y_start) * stride[1] + offset, count / 2);
+						break;
+					case IMGP_NATIVE_TILE_WRITE_MERGE:
+						offset = x * IMGP_NATIVE_TILE_WIDTH / 2;
+						_mm_native_merge_uv(k, linear[0] + (size_t) (row - y_start) * stride[0] + offset,
+							linear[1] + (size_t) (row - y_start) * stride[1] + offset, tile, count / 2);
+						break;
+				}
+			}
+		}
+	}
+}
+
+/* rows [y_start, y_end) of the tiled frame from / to the NV12 or I420 frame linear, whose row 0 is the row origin of the image */
+static void
+_mm_native_tile_yuv420(const imgp_frame_s *tiled, const imgp_frame_s *linear, unsigned int origin, int read, unsigned int y_start, unsigned int y_end)
+{
+	imgp_native_tiled_plane_s plane;
+	unsigned char *rows[2] = { NULL, NULL };
+	unsigned int stride[2] = { 0, 0 };
+	unsigned int uv_start = y_start / 2, uv_end = (y_end + 1) / 2;
+
+	plane.tiles = tiled->data[0];
+	plane.x_tiles = tiled->stride[0] / IMGP_NATIVE_TILE_WIDTH;
+	plane.y_tiles = (tiled->height + IMGP_NATIVE_TILE_HEIGHT - 1) / IMGP_NATIVE_TILE_HEIGHT;
+	plane.bytes = tiled->width;
+	rows[0] = linear->data[0] + (size_t) (y_start - origin) * linear->stride[0];
+	stride[0] = linear->stride[0];
+	_mm_native_tile_walk(&plane, read ? IMGP_NATIVE_TILE_READ : IMGP_NATIVE_TILE_WRITE, rows, stride, y_start, y_end);
+
+	plane.tiles = tiled->data[1];
+	plane.x_tiles = tiled->stride[1] / IMGP_NATIVE_TILE_WIDTH;
+	plane.y_tiles = ((tiled->height + 1) / 2 + IMGP_NATIVE_TILE_HEIGHT - 1) / IMGP_NATIVE_TILE_HEIGHT;
+	plane.bytes = (tiled->width + 1) / 2 * 2;
+	rows[0] = linear->data[1] + (size_t) (uv_start - origin / 2) * linear->stride[1];
+	stride[0] = linear->stride[1];
+	if(linear->format == MM_UTIL_IMG_FMT_NV12) {
+		_mm_native_tile_walk(&plane, read ? IMGP_NATIVE_TILE_READ : IMGP_NATIVE_TILE_WRITE, rows, stride, uv_start, uv_end);
+	}else {
+		rows[1] = linear->data[2] + (size_t) (uv_start - origin / 2) * linear->stride[2];
+		stride[1] = linear->stride[2];
+		_mm_native_tile_walk(&plane, read ? IMGP_NATIVE_TILE_READ_SPLIT : IMGP_NATIVE_TILE_WRITE_MERGE, rows, stride, uv_start, uv_end);
+	}
+}
+
+int
+_mm_native_tile_supported(mm_util_img_format_e src_format, mm_util_img_format_e dst_format)
+{
+	/* the other formats go through the NV12 band */
+	if(src_format == MM_UTIL_IMG_FMT_NV12_TILED) {
+		return dst_format == MM_UTIL_IMG_FMT_NV12 || dst_format == MM_UTIL_IMG_FMT_I420
+			|| _mm_native_csc_supported(MM_UTIL_IMG_FMT_NV12, dst_format);
+	}
+	if(dst_format == MM_UTIL_IMG_FMT_NV12_TILED) {
+		return src_format == MM_UTIL_IMG_FMT_NV12 || src_format == MM_UTIL_IMG_FMT_I420
+			|| _mm_native_csc_supported(src_format, MM_UTIL_IMG_FMT_NV12);
+	}
+	return 0;
+}
+
+int
+_mm_native_tile_rows(const imgp_native_op_s *op, unsigned int y_start, unsigned int y_end)
+{
+	int read = (op->src->format == MM_UTIL_IMG_FMT_NV12_TILED);
+	const imgp_frame_s *tiled = read ? op->src : op->dst;
+	const imgp_frame_s *linear = read ? op->dst : op->src;
+	imgp_frame_s band, rows;
+	unsigned char *buffer = NULL;
+	unsigned int band_end = 0, y = 0;
+	int ret = MM_ERROR_NONE;
+
+	/* the Z order pairs the tiles of a row */
+	if(tiled->stride[0] % (IMGP_NATIVE_TILE_WIDTH * 2) != 0 || tiled->stride[1] % (IMGP_NATIVE_TILE_WIDTH * 2) != 0
+		|| tiled->stride[0] < tiled->width || tiled->stride[1] < (tiled->width + 1) / 2 * 2) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] stride %u / %u is not a row of pairs of tiles for the width %u", __func__, __LINE__,
+			tiled->stride[0], tiled->stride[1], tiled->width);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+	if(linear->format == MM_UTIL_IMG_FMT_NV12 || linear->format == MM_UTIL_IMG_FMT_I420) {
+		_mm_native_tile_yuv420(tiled, linear, 0, read, y_start, y_end);
+		return MM_ERROR_NONE;
+	}
+
+	/* a NV12 band of a row of tiles between the tiles and the colorspace converter */
+	memset(&band, 0, sizeof(imgp_frame_s));
+	band.format = MM_UTIL_IMG_FMT_NV12;
+	band.width = linear->width;
+	band.stride[0] = MM_UTIL_ROUND_UP_16(linear->width);
+	band.stride[1] = MM_UTIL_ROUND_UP_16(linear->width + 1);
+	buffer = malloc((size_t) band.stride[0] * IMGP_NATIVE_TILE_HEIGHT + (size_t) band.stride[1] * IMGP_NATIVE_TILE_HEIGHT / 2);
+	if(buffer == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate the band", __func__, __LINE__);
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	band.data[0] = buffer;
+	band.data[1] = buffer + (size_t) band.stride[0] * IMGP_NATIVE_TILE_HEIGHT;
+	rows = *linear;
+
+	for(y = y_start; y < y_end && ret == MM_ERROR_NONE; y = band_end) {
+		band_end = IMGP_NATIVE_MIN((y / IMGP_NATIVE_TILE_HEIGHT + 1) * IMGP_NATIVE_TILE_HEIGHT, y_end);
+		band.height = band_end - y;
+		rows.height = band.height;
+		rows.data[0] = linear->data[0] + (size_t) y * linear->stride[0];
+		if(read) {
+			_mm_native_tile_yuv420(tiled, &band, y, 1, y, band_end);
+			ret = _mm_native_csc(&band, &rows, op->coeffs, 0, band.height);
+		}else {
+			ret = _mm_native_csc(&rows, &band, op->coeffs, 0, band.height);
+			_mm_native_tile_yuv420(tiled, &band, y, 0, y, band_end);
+		}
+	}
+	free(buffer);
+	return ret;
+}
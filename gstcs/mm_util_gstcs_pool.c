@@ -0,0 +1,388 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mm_util_gstcs_internal.h"
+#include <mm_debug.h>
+#include <mm_error.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Pool of the memory blocks, GstBuffers and image formats which every frame or pipeline used to allocate.
+ * Blocks are kept in size classes of a quarter of a power of two, so a block wastes at most a fifth of its size.
+ * GstBuffers of the pool are a subclass whose finalize puts the object back in the pool instead of freeing it.
+ */
+
+#define MM_UTIL_IMGP_POOL_DEFAULT_BYTES (32 * 1024 * 1024)
+#define MM_UTIL_IMGP_POOL_DEFAULT_BUFFERS 32
+#define MM_UTIL_IMGP_POOL_DEFAULT_FORMATS 8
+#define MM_UTIL_IMGP_POOL_MIN_LOG 12 /* 4 KiB, smaller blocks take the smallest class */
+#define MM_UTIL_IMGP_POOL_MAX_LOG 28 /* 256 MiB, larger blocks are not pooled */
+#define MM_UTIL_IMGP_POOL_CLASSES (1 + 4 * (MM_UTIL_IMGP_POOL_MAX_LOG - MM_UTIL_IMGP_POOL_MIN_LOG))
+#define MM_UTIL_IMGP_POOL_NO_CLASS ((unsigned int) -1)
+
+G_LOCK_DEFINE_STATIC(imgp_pool);
+static imgp_pool_block_s* _mm_imgp_pool_blocks[MM_UTIL_IMGP_POOL_CLASSES];
+static GQueue _mm_imgp_pool_buffers = G_QUEUE_INIT;
+static GQueue _mm_imgp_pool_formats = G_QUEUE_INIT; /* the most recently released one is at the head */
+static unsigned int _mm_imgp_pool_flushing = 0; /* buffers finalized while the pool is trimmed are freed */
+static imgp_pool_stats_s _mm_imgp_pool_stats = {
+	MM_UTIL_IMGP_POOL_DEFAULT_BYTES, 0, MM_UTIL_IMGP_POOL_DEFAULT_BUFFERS, 0, MM_UTIL_IMGP_POOL_DEFAULT_FORMATS, 0,
+};
+static GstMiniObjectClass* _mm_imgp_pool_buffer_parent_class = NULL;
+
+static unsigned int
+_mm_imgp_pool_class(gsize size, gsize* class_size)
+{
+	unsigned int log = MM_UTIL_IMGP_POOL_MIN_LOG;
+	gsize step = 0;
+	gsize quarters = 0;
+
+	if(size <= ((gsize) 1 << MM_UTIL_IMGP_POOL_MIN_LOG)) {
+		*class_size = (gsize) 1 << MM_UTIL_IMGP_POOL_MIN_LOG;
+		return 0;
+	}
+	while(log < MM_UTIL_IMGP_POOL_MAX_LOG && ((gsize) 1 << (log + 1)) < size) {
+		log++;
+	}
+	if(log == MM_UTIL_IMGP_POOL_MAX_LOG) {
+		*class_size = size;
+		return MM_UTIL_IMGP_POOL_NO_CLASS;
+	}
+	/* 2^log < size <= 2^(log + 1), rounded up to a quarter of 2^log */
+	step = (gsize) 1 << (log - 2);
+	quarters = (size - ((gsize) 1 << log) + step - 1) / step;
+	*class_size = ((gsize) 1 << log) + quarters * step;
+	return 1 + 4 * (log - MM_UTIL_IMGP_POOL_MIN_LOG) + (unsigned int) (quarters - 1);
+}
+
+static gsize
+_mm_imgp_pool_class_size(unsigned int size_class)
+{
+	unsigned int log = 0;
+
+	if(size_class == 0) {
+		return (gsize) 1 << MM_UTIL_IMGP_POOL_MIN_LOG;
+	}
+	log = MM_UTIL_IMGP_POOL_MIN_LOG + (size_class - 1) / 4;
+	return ((gsize) 1 << log) + ((size_class - 1) % 4 + 1) * ((gsize) 1 << (log - 2));
+}
+
+gpointer
+_mm_imgp_pool_alloc(gsize size)
+{
+	imgp_pool_block_s* block = NULL;
+	gsize class_size = 0;
+	unsigned int size_class = _mm_imgp_pool_class(size, &class_size);
+
+	if(size_class != MM_UTIL_IMGP_POOL_NO_CLASS) {
+		G_LOCK(imgp_pool);
+		block = _mm_imgp_pool_blocks[size_class];
+		if(block) {
+			_mm_imgp_pool_blocks[size_class] = block->free.next;
+			_mm_imgp_pool_stats.bytes -= class_size;
+			_mm_imgp_pool_stats.block_hits++;
+		}else {
+			_mm_imgp_pool_stats.block_misses++;
+		}
+		G_UNLOCK(imgp_pool);
+	}
+	if(block == NULL) {
+		block = (imgp_pool_block_s*) g_try_malloc(sizeof(imgp_pool_block_s) + class_size);
+		if(block == NULL) {
+			mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] fail to allocate %" G_GSIZE_FORMAT " bytes", __func__, __LINE__, class_size);
+			return NULL;
+		}
+	}
+	block->free.next = NULL;
+	block->free.size_class = size_class;
+	return block + 1;
+}
+
+void
+_mm_imgp_pool_free(gpointer data)
+{
+	imgp_pool_block_s* block = NULL;
+	gsize class_size = 0;
+
+	if(data == NULL) {
+		return;
+	}
+	block = (imgp_pool_block_s*) data - 1;
+	if(block->free.size_class != MM_UTIL_IMGP_POOL_NO_CLASS) {
+		class_size = _mm_imgp_pool_class_size(block->free.size_class);
+		G_LOCK(imgp_pool);
+		if(_mm_imgp_pool_stats.bytes + class_size <= _mm_imgp_pool_stats.max_bytes) {
+			block->free.next = _mm_imgp_pool_blocks[block->free.size_class];
+			_mm_imgp_pool_blocks[block->free.size_class] = block;
+			_mm_imgp_pool_stats.bytes += class_size;
+			block = NULL;
+		}
+		G_UNLOCK(imgp_pool);
+	}
+	g_free(block);
+}
+
+static void
+_mm_imgp_pool_buffer_finalize(GstBuffer* buffer)
+{
+	gboolean recycled = FALSE;
+
+	/* the data and the caps are released as the finalize of GstBuffer would do */
+	if(GST_BUFFER_FREE_FUNC(buffer)) {
+		GST_BUFFER_FREE_FUNC(buffer)(GST_BUFFER_MALLOCDATA(buffer));
+	}else {
+		g_free(GST_BUFFER_MALLOCDATA(buffer));
+	}
+	GST_BUFFER_MALLOCDATA(buffer) = NULL;
+	GST_BUFFER_FREE_FUNC(buffer) = NULL;
+	gst_caps_replace(&GST_BUFFER_CAPS(buffer), NULL);
+	GST_BUFFER_DATA(buffer) = NULL;
+	GST_BUFFER_SIZE(buffer) = 0;
+	GST_BUFFER_TIMESTAMP(buffer) = GST_CLOCK_TIME_NONE;
+	GST_BUFFER_DURATION(buffer) = GST_CLOCK_TIME_NONE;
+	GST_BUFFER_OFFSET(buffer) = GST_BUFFER_OFFSET_NONE;
+	GST_BUFFER_OFFSET_END(buffer) = GST_BUFFER_OFFSET_NONE;
+	GST_MINI_OBJECT_FLAGS(buffer) = 0;
+
+	G_LOCK(imgp_pool);
+	if(_mm_imgp_pool_flushing == 0 && g_queue_get_length(&_mm_imgp_pool_buffers) < _mm_imgp_pool_stats.max_buffers) {
+		/* a finalize which takes a new reference keeps the object alive */
+		gst_buffer_ref(buffer);
+		g_queue_push_head(&_mm_imgp_pool_buffers, buffer);
+		recycled = TRUE;
+	}
+	G_UNLOCK(imgp_pool);
+
+	if(!recycled) {
+		_mm_imgp_pool_buffer_parent_class->finalize(GST_MINI_OBJECT_CAST(buffer));
+	}
+}
+
+static void
+_mm_imgp_pool_buffer_class_init(gpointer g_class, gpointer class_data)
+{
+	GstMiniObjectClass* mini_object_class = GST_MINI_OBJECT_CLASS(g_class);
+
+	_mm_imgp_pool_buffer_parent_class = (GstMiniObjectClass*) g_type_class_peek_parent(g_class);
+	mini_object_class->finalize = (GstMiniObjectFinalizeFunction) _mm_imgp_pool_buffer_finalize;
+}
+
+static GType
+_mm_imgp_pool_buffer_get_type(void)
+{
+	static volatile gsize _type = 0;
+	static const GTypeInfo _info = {
+		sizeof(GstBufferClass), NULL, NULL, _mm_imgp_pool_buffer_class_init, NULL, NULL, sizeof(GstBuffer), 0, NULL, NULL,
+	};
+
+	if(g_once_init_enter(&_type)) {
+		g_once_init_leave(&_type, g_type_register_static(GST_TYPE_BUFFER, "MMImgpPoolBuffer", &_info, 0));
+	}
+	return _type;
+}
+
+GstBuffer*
+_mm_imgp_pool_buffer_new(void)
+{
+	GstBuffer* buffer = NULL;
+
+	G_LOCK(imgp_pool);
+	buffer = (GstBuffer*) g_queue_pop_head(&_mm_imgp_pool_buffers);
+	if(buffer) {
+		_mm_imgp_pool_stats.buffer_hits++;
+	}else {
+		_mm_imgp_pool_stats.buffer_misses++;
+	}
+	G_UNLOCK(imgp_pool);
+
+	if(buffer == NULL) {
+		buffer = (GstBuffer*) gst_mini_object_new(_mm_imgp_pool_buffer_get_type());
+	}
+	return buffer;
+}
+
+GstBuffer*
+_mm_imgp_pool_buffer_new_and_alloc(guint size)
+{
+	GstBuffer* buffer = NULL;
+	gpointer data = _mm_imgp_pool_alloc(size);
+
+	if(data == NULL) {
+		return NULL;
+	}
+	buffer = _mm_imgp_pool_buffer_new();
+	GST_BUFFER_MALLOCDATA(buffer) = (guint8*) data;
+	GST_BUFFER_FREE_FUNC(buffer) = _mm_imgp_pool_free;
+	GST_BUFFER_DATA(buffer) = (guint8*) data;
+	GST_BUFFER_SIZE(buffer) = size;
+	return buffer;
+}
+
+image_format_s*
+_mm_imgp_pool_format_take(const char* format_label, int width, int height, mm_util_img_color_matrix_e color_matrix)
+{
+	GList* _list = NULL;
+	image_format_s* format = NULL;
+
+	G_LOCK(imgp_pool);
+	for(_list = _mm_imgp_pool_formats.head; _list != NULL; _list = _list->next) {
+		image_format_s* candidate = (image_format_s*) _list->data;
+		if(candidate->width == width && candidate->height == height && candidate->color_matrix == color_matrix
+			&& strcmp(candidate->format_label, format_label) == 0) {
+			format = candidate;
+			g_queue_delete_link(&_mm_imgp_pool_formats, _list);
+			break;
+		}
+	}
+	if(format) {
+		_mm_imgp_pool_stats.format_hits++;
+	}else {
+		_mm_imgp_pool_stats.format_misses++;
+	}
+	G_UNLOCK(imgp_pool);
+	return format;
+}
+
+static void
+_mm_imgp_pool_format_free(image_format_s* format)
+{
+	if(format->caps) {
+		gst_caps_unref(format->caps);
+		format->caps = NULL;
+	}
+	free(format);
+}
+
+void
+_mm_imgp_pool_format_release(image_format_s* format)
+{
+	image_format_s* evicted = NULL;
+
+	if(format == NULL) {
+		return;
+	}
+	if(format->caps == NULL) {
+		/* a format without caps is never handed to a pipeline again */
+		_mm_imgp_pool_format_free(format);
+		return;
+	}
+	G_LOCK(imgp_pool);
+	if(_mm_imgp_pool_stats.max_formats > 0) {
+		g_queue_push_head(&_mm_imgp_pool_formats, format);
+		format = NULL;
+		if(g_queue_get_length(&_mm_imgp_pool_formats) > _mm_imgp_pool_stats.max_formats) {
+			evicted = (image_format_s*) g_queue_pop_tail(&_mm_imgp_pool_formats);
+		}
+	}
+	G_UNLOCK(imgp_pool);
+
+	if(format) {
+		_mm_imgp_pool_format_free(format);
+	}
+	if(evicted) {
+		_mm_imgp_pool_format_free(evicted);
+	}
+}
+
+/* release what the pool keeps beyond its limits, everything when flush is set */
+static void
+_mm_imgp_pool_trim(gboolean flush)
+{
+	imgp_pool_block_s* blocks = NULL;
+	imgp_pool_block_s* block = NULL;
+	GSList* buffers = NULL;
+	GSList* formats = NULL;
+	unsigned int i = 0;
+
+	G_LOCK(imgp_pool);
+	for(i = MM_UTIL_IMGP_POOL_CLASSES; i > 0 && (flush || _mm_imgp_pool_stats.bytes > _mm_imgp_pool_stats.max_bytes); i--) {
+		/* the largest blocks go first */
+		while(_mm_imgp_pool_blocks[i - 1] && (flush || _mm_imgp_pool_stats.bytes > _mm_imgp_pool_stats.max_bytes)) {
+			block = _mm_imgp_pool_blocks[i - 1];
+			_mm_imgp_pool_blocks[i - 1] = block->free.next;
+			_mm_imgp_pool_stats.bytes -= _mm_imgp_pool_class_size(i - 1);
+			block->free.next = blocks;
+			blocks = block;
+		}
+	}
+	while(g_queue_get_length(&_mm_imgp_pool_buffers) > (flush ? 0 : _mm_imgp_pool_stats.max_buffers)) {
+		buffers = g_slist_prepend(buffers, g_queue_pop_tail(&_mm_imgp_pool_buffers));
+	}
+	while(g_queue_get_length(&_mm_imgp_pool_formats) > (flush ? 0 : _mm_imgp_pool_stats.max_formats)) {
+		formats = g_slist_prepend(formats, g_queue_pop_tail(&_mm_imgp_pool_formats));
+	}
+	_mm_imgp_pool_flushing++;
+	G_UNLOCK(imgp_pool);
+
+	while(blocks) {
+		block = blocks;
+		blocks = block->free.next;
+		g_free(block);
+	}
+	while(buffers) {
+		gst_buffer_unref((GstBuffer*) buffers->data);
+		buffers = g_slist_delete_link(buffers, buffers);
+	}
+	while(formats) {
+		_mm_imgp_pool_format_free((image_format_s*) formats->data);
+		formats = g_slist_delete_link(formats, formats);
+	}
+
+	G_LOCK(imgp_pool);
+	_mm_imgp_pool_flushing--;
+	G_UNLOCK(imgp_pool);
+}
+
+int
+mm_imgp_pool_set_limits(unsigned int max_bytes, unsigned int max_buffers, unsigned int max_formats)
+{
+	G_LOCK(imgp_pool);
+	_mm_imgp_pool_stats.max_bytes = max_bytes;
+	_mm_imgp_pool_stats.max_buffers = max_buffers;
+	_mm_imgp_pool_stats.max_formats = max_formats;
+	G_UNLOCK(imgp_pool);
+
+	_mm_imgp_pool_trim(FALSE);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_pool_get_stats(imgp_pool_stats_s *stats)
+{
+	if(stats == NULL) {
+		mmf_debug(MMF_DEBUG_ERROR, "[%s][%05d] input vaule is error", __func__, __LINE__);
+		return MM_ERROR_IMAGE_INVALID_VALUE;
+	}
+
+	G_LOCK(imgp_pool);
+	memcpy(stats, &_mm_imgp_pool_stats, sizeof(imgp_pool_stats_s));
+	stats->buffers = g_queue_get_length(&_mm_imgp_pool_buffers);
+	stats->formats = g_queue_get_length(&_mm_imgp_pool_formats);
+	G_UNLOCK(imgp_pool);
+	return MM_ERROR_NONE;
+}
+
+int
+mm_imgp_pool_flush(void)
+{
+	_mm_imgp_pool_trim(TRUE);
+	return MM_ERROR_NONE;
+}
@@ -0,0 +1,206 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+/*
+ * Check of the native colorspace converter against ffmpegcolorspace: the same frames are converted by mm_imgp()
+ * in a pipeline (MM_IMGP_TIER=gstreamer) and by the native kernels the cpu picks, and the results must be bit-exact
+ * for BT.601 limited range, as mm_util_gstcs_native.h states. The pairs a pipeline can not run here are skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+#include "mm_util_gstcs_format.h"
+#include "mm_util_gstcs_test.h"
+
+/* a width which is a multiple of the row alignment of the caps, so that both tiers use the same layout */
+#define TEST_WIDTH 176
+#define TEST_HEIGHT 144
+
+typedef struct _test_case_s
+{
+	const char *src_label;
+	const char *dst_label;
+} test_case_s;
+
+/* result of a case in the buffer sent back by a tier, followed by the frame */
+typedef struct _test_record_s
+{
+	int ret;
+	mm_util_imgp_tier_e tier;
+} test_record_s;
+
+static const test_case_s _test_cases[] = {
+	{ "I420", "RGB888" },
+	{ "I420", "RGB565" },
+	{ "I420", "ARGB8888" },
+	{ "I420", "BGRA8888" },
+	{ "NV12", "RGB888" },
+	{ "NV12", "RGB565" },
+	{ "NV12", "ARGB8888" },
+	{ "NV12", "BGRA8888" },
+	{ "RGB888", "I420" },
+	{ "RGB565", "I420" },
+	{ "ARGB8888", "I420" },
+	{ "BGRA8888", "I420" },
+	{ "RGB888", "NV12" },
+	{ "BGRA8888", "NV12" },
+	{ "YUYV", "I420" },
+	{ "UYVY", "I420" },
+};
+
+#define TEST_CASE_NUM (sizeof(_test_cases) / sizeof(_test_cases[0]))
+
+static unsigned int
+_test_frame_size(const char *label)
+{
+	return _mm_format_get_size(_mm_format_get_desc_by_label(label), TEST_WIDTH, TEST_HEIGHT);
+}
+
+static size_t
+_test_record_size(const test_case_s *test)
+{
+	return sizeof(test_record_s) + _test_frame_size(test->dst_label);
+}
+
+static size_t
+_test_total_size(void)
+{
+	size_t size = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		size += _test_record_size(&_test_cases[i]);
+	}
+	return size;
+}
+
+static void
+_test_convert(const test_case_s *test, test_record_s *record, unsigned char *dst)
+{
+	unsigned int src_size = _test_frame_size(test->src_label);
+	unsigned char *src = malloc(src_size);
+	imgp_kernel_info_s kernel;
+	imgp_info_s info;
+
+	memset(record, 0, sizeof(test_record_s));
+	memset(dst, 0, _test_frame_size(test->dst_label));
+	if(src == NULL) {
+		record->ret = MM_ERROR_IMAGE_NO_FREE_SPACE;
+		return;
+	}
+	_test_fill_pattern(src, src_size, 0x1234567);
+
+	memset(&info, 0, sizeof(imgp_info_s));
+	info.src = src;
+	info.dst = dst;
+	snprintf(info.input_format_label, IMAGE_FORMAT_LABEL_BUFFER_SIZE, "%s", test->src_label);
+	snprintf(info.output_format_label, IMAGE_FORMAT_LABEL_BUFFER_SIZE, "%s", test->dst_label);
+	info.src_width = info.dst_width = TEST_WIDTH;
+	info.src_height = info.dst_height = TEST_HEIGHT;
+	info.angle = MM_UTIL_ROTATE_0;
+
+	record->ret = mm_imgp_query(&info, &kernel);
+	record->tier = kernel.tier;
+	if(record->ret == MM_ERROR_NONE) {
+		record->ret = mm_imgp(&info, IMGP_CSC);
+	}
+	free(src);
+}
+
+static int
+_test_convert_all(unsigned char *buffer, void *user_data)
+{
+	unsigned int i = 0;
+	test_record_s record;
+
+	(void) user_data;
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		_test_convert(&_test_cases[i], &record, buffer + sizeof(test_record_s));
+		memcpy(buffer, &record, sizeof(test_record_s));
+		buffer += _test_record_size(&_test_cases[i]);
+	}
+	return MM_ERROR_NONE;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t size = _test_total_size();
+	unsigned char *pipeline = malloc(size);
+	unsigned char *native = malloc(size);
+	unsigned char *pipeline_frame = NULL, *native_frame = NULL;
+	test_record_s pipeline_record, native_record;
+	imgp_native_isa_e isa = IMGP_NATIVE_ISA_C;
+	size_t frame_size = 0, j = 0;
+	unsigned int i = 0, fails = 0, passes = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) argc;
+	(void) argv;
+	if(pipeline == NULL || native == NULL) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	ret = _test_run_tier("gstreamer", _test_convert_all, NULL, pipeline, size, &isa);
+	if(ret == MM_ERROR_NONE) {
+		ret = _test_run_tier(NULL, _test_convert_all, NULL, native, size, &isa);
+	}
+	if(ret != MM_ERROR_NONE) {
+		printf("FAIL: the conversions did not run: %d\n", ret);
+		return 1;
+	}
+
+	pipeline_frame = pipeline;
+	native_frame = native;
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		memcpy(&pipeline_record, pipeline_frame, sizeof(test_record_s));
+		memcpy(&native_record, native_frame, sizeof(test_record_s));
+		frame_size = _test_record_size(&_test_cases[i]) - sizeof(test_record_s);
+		if(native_record.ret != MM_ERROR_NONE || native_record.tier == MM_UTIL_IMGP_TIER_GSTREAMER || native_record.tier == MM_UTIL_IMGP_TIER_NONE) {
+			printf("FAIL: %s -> %s is not converted natively, ret: %d tier: %d\n", _test_cases[i].src_label, _test_cases[i].dst_label, native_record.ret, native_record.tier);
+			fails++;
+		}else if(pipeline_record.ret != MM_ERROR_NONE || pipeline_record.tier != MM_UTIL_IMGP_TIER_GSTREAMER) {
+			printf("SKIP: %s -> %s does not run in a pipeline here, ret: %d tier: %d\n", _test_cases[i].src_label, _test_cases[i].dst_label, pipeline_record.ret, pipeline_record.tier);
+		}else {
+			j = _test_first_difference(pipeline_frame + sizeof(test_record_s), native_frame + sizeof(test_record_s), frame_size);
+			if(j < frame_size) {
+				printf("FAIL: %s -> %s %s: byte %u is %u instead of %u\n", _test_cases[i].src_label, _test_cases[i].dst_label, _mm_native_get_isa_name(isa),
+					(unsigned int) j, native_frame[sizeof(test_record_s) + j], pipeline_frame[sizeof(test_record_s) + j]);
+				fails++;
+			}else {
+				printf("PASS: %s -> %s %s is bit-exact with ffmpegcolorspace\n", _test_cases[i].src_label, _test_cases[i].dst_label, _mm_native_get_isa_name(isa));
+				passes++;
+			}
+		}
+		pipeline_frame += _test_record_size(&_test_cases[i]);
+		native_frame += _test_record_size(&_test_cases[i]);
+	}
+	free(pipeline);
+	free(native);
+	if(fails) {
+		return 1;
+	}
+	return passes ? 0 : TEST_EXIT_SKIP;
+}
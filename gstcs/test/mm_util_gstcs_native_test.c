@@ -0,0 +1,235 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Check of the YUV <-> RGB kernels for every color matrix and range: a fixed pattern is converted at every
+ * MM_IMGP_TIER the cpu has and the result of each tier must be bit-exact with the one of the C tier.
+ * The kernels pick their tier once per process, so each tier runs in a child process which sends its frames back.
+ * The matrices and ranges must also give different results, so that none of them is silently ignored.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+#include "mm_util_gstcs_format.h"
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_test.h"
+
+/* odd sizes and a width which is not a multiple of the SIMD steps, so the C tails and the last chroma samples run too */
+#define TEST_WIDTH 70
+#define TEST_HEIGHT 35
+#define TEST_SCALED_WIDTH 53
+#define TEST_SCALED_HEIGHT 29
+
+typedef struct _test_case_s
+{
+	mm_util_img_format_e src_format;
+	mm_util_img_format_e dst_format;
+	int fused;                      /* resize and rotate by 90 degrees in the fused pass */
+} test_case_s;
+
+static const test_case_s _test_cases[] = {
+	{ MM_UTIL_IMG_FMT_I420, MM_UTIL_IMG_FMT_ARGB8888, 0 },
+	{ MM_UTIL_IMG_FMT_I420, MM_UTIL_IMG_FMT_BGRA8888, 0 },
+	{ MM_UTIL_IMG_FMT_I420, MM_UTIL_IMG_FMT_RGB888, 0 },
+	{ MM_UTIL_IMG_FMT_I420, MM_UTIL_IMG_FMT_RGB565, 0 },
+	{ MM_UTIL_IMG_FMT_NV12, MM_UTIL_IMG_FMT_BGRA8888, 0 },
+	{ MM_UTIL_IMG_FMT_NV12, MM_UTIL_IMG_FMT_RGB888, 0 },
+	{ MM_UTIL_IMG_FMT_RGB888, MM_UTIL_IMG_FMT_I420, 0 },
+	{ MM_UTIL_IMG_FMT_BGRA8888, MM_UTIL_IMG_FMT_NV12, 0 },
+	{ MM_UTIL_IMG_FMT_I420, MM_UTIL_IMG_FMT_BGRA8888, 1 },
+};
+
+#define TEST_CASE_NUM (sizeof(_test_cases) / sizeof(_test_cases[0]))
+
+static unsigned int
+_test_dst_size(const test_case_s *test)
+{
+	if(test->fused) {
+		return _mm_format_get_size(_mm_format_get_desc(test->dst_format), TEST_SCALED_HEIGHT, TEST_SCALED_WIDTH);
+	}
+	return _mm_format_get_size(_mm_format_get_desc(test->dst_format), TEST_WIDTH, TEST_HEIGHT);
+}
+
+/* bytes of the frames of every case, matrix and range in the order _test_convert_all writes them */
+static size_t
+_test_total_size(void)
+{
+	size_t size = 0;
+	unsigned int i = 0;
+
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		size += _test_dst_size(&_test_cases[i]);
+	}
+	return size * MM_UTIL_COLOR_MATRIX_NUM * MM_UTIL_COLOR_RANGE_NUM;
+}
+
+static int
+_test_convert(const test_case_s *test, const imgp_yuv_coeffs_s *coeffs, unsigned char *dst_buffer)
+{
+	const imgp_format_desc_s *src_desc = _mm_format_get_desc(test->src_format);
+	unsigned int src_size = _mm_format_get_size(src_desc, TEST_WIDTH, TEST_HEIGHT);
+	unsigned char *src_buffer = malloc(src_size);
+	imgp_frame_s src, dst;
+	imgp_native_op_s op;
+	int ret = MM_ERROR_NONE;
+
+	if(src_buffer == NULL) {
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	_test_fill_pattern(src_buffer, src_size, 0x1234567);
+	memset(dst_buffer, 0, _test_dst_size(test));
+	ret = _mm_native_frame_init(&src, test->src_format, TEST_WIDTH, TEST_HEIGHT, src_buffer);
+	if(ret == MM_ERROR_NONE && test->fused) {
+		ret = _mm_native_frame_init(&dst, test->dst_format, TEST_SCALED_HEIGHT, TEST_SCALED_WIDTH, dst_buffer);
+		if(ret == MM_ERROR_NONE) {
+			memset(&op, 0, sizeof(imgp_native_op_s));
+			op.src = &src;
+			op.dst = &dst;
+			op.angle = MM_UTIL_ROTATE_90;
+			op.coeffs = coeffs;
+			ret = _mm_native_fused_rows(&op, 0, dst.height);
+		}
+	}else if(ret == MM_ERROR_NONE) {
+		ret = _mm_native_frame_init(&dst, test->dst_format, TEST_WIDTH, TEST_HEIGHT, dst_buffer);
+		if(ret == MM_ERROR_NONE) {
+			ret = _mm_native_csc(&src, &dst, coeffs, 0, TEST_HEIGHT);
+		}
+	}
+	free(src_buffer);
+	return ret;
+}
+
+static int
+_test_convert_all(unsigned char *buffer, void *user_data)
+{
+	unsigned int matrix = 0, range = 0, i = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) user_data;
+	for(matrix = 0; matrix < MM_UTIL_COLOR_MATRIX_NUM; matrix++) {
+		for(range = 0; range < MM_UTIL_COLOR_RANGE_NUM; range++) {
+			for(i = 0; i < TEST_CASE_NUM && ret == MM_ERROR_NONE; i++) {
+				ret = _test_convert(&_test_cases[i], _mm_native_get_coeffs(matrix, range), buffer);
+				buffer += _test_dst_size(&_test_cases[i]);
+			}
+		}
+	}
+	return ret;
+}
+
+/* the frames of a case for two colorimetries must differ */
+static int
+_test_check_distinct(const unsigned char *reference)
+{
+	size_t offset = 0, set_size = 0, case_offset = 0;
+	unsigned int set = 0, other = 0, i = 0;
+	int fails = 0;
+
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		set_size += _test_dst_size(&_test_cases[i]);
+	}
+	for(i = 0; i < TEST_CASE_NUM; i++) {
+		for(set = 0; set < MM_UTIL_COLOR_MATRIX_NUM * MM_UTIL_COLOR_RANGE_NUM; set++) {
+			for(other = set + 1; other < MM_UTIL_COLOR_MATRIX_NUM * MM_UTIL_COLOR_RANGE_NUM; other++) {
+				offset = case_offset;
+				if(memcmp(reference + set * set_size + offset, reference + other * set_size + offset, _test_dst_size(&_test_cases[i])) == 0) {
+					printf("FAIL: %d -> %d%s: matrix %u range %u gives the same frame as matrix %u range %u\n",
+						_test_cases[i].src_format, _test_cases[i].dst_format, _test_cases[i].fused ? " fused" : "",
+						set / MM_UTIL_COLOR_RANGE_NUM, set % MM_UTIL_COLOR_RANGE_NUM, other / MM_UTIL_COLOR_RANGE_NUM, other % MM_UTIL_COLOR_RANGE_NUM);
+					fails++;
+				}
+			}
+		}
+		case_offset += _test_dst_size(&_test_cases[i]);
+	}
+	return fails;
+}
+
+/* report the first differing byte of every case, matrix and range */
+static int
+_test_compare(imgp_native_isa_e isa, const unsigned char *reference, const unsigned char *result)
+{
+	unsigned int matrix = 0, range = 0, i = 0;
+	size_t size = 0, j = 0;
+	int fails = 0;
+
+	for(matrix = 0; matrix < MM_UTIL_COLOR_MATRIX_NUM; matrix++) {
+		for(range = 0; range < MM_UTIL_COLOR_RANGE_NUM; range++) {
+			for(i = 0; i < TEST_CASE_NUM; i++) {
+				size = _test_dst_size(&_test_cases[i]);
+				j = _test_first_difference(reference, result, size);
+				if(j < size) {
+					printf("FAIL: %s %d -> %d%s matrix %u range %u: byte %u is %u instead of %u\n", _mm_native_get_isa_name(isa),
+						_test_cases[i].src_format, _test_cases[i].dst_format, _test_cases[i].fused ? " fused" : "",
+						matrix, range, (unsigned int) j, result[j], reference[j]);
+					fails++;
+				}
+				reference += size;
+				result += size;
+			}
+		}
+	}
+	return fails;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t size = _test_total_size();
+	unsigned char *reference = malloc(size);
+	unsigned char *result = malloc(size);
+	imgp_native_isa_e tier = IMGP_NATIVE_ISA_C, isa = IMGP_NATIVE_ISA_C;
+	int fails = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) argc;
+	(void) argv;
+	if(reference == NULL || result == NULL) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	ret = _test_run_tier(_mm_native_get_isa_name(IMGP_NATIVE_ISA_C), _test_convert_all, NULL, reference, size, &isa);
+	if(ret != MM_ERROR_NONE || isa != IMGP_NATIVE_ISA_C) {
+		printf("FAIL: C tier ret: %d isa: %s\n", ret, _mm_native_get_isa_name(isa));
+		return 1;
+	}
+	fails += _test_check_distinct(reference);
+
+	for(tier = IMGP_NATIVE_ISA_C + 1; tier < IMGP_NATIVE_ISA_NUM; tier++) {
+		ret = _test_run_tier(_mm_native_get_isa_name(tier), _test_convert_all, NULL, result, size, &isa);
+		if(ret != MM_ERROR_NONE) {
+			printf("FAIL: %s tier ret: %d\n", _mm_native_get_isa_name(tier), ret);
+			fails++;
+		}else if(isa != tier) {
+			printf("SKIP: %s is not available, the cpu runs %s\n", _mm_native_get_isa_name(tier), _mm_native_get_isa_name(isa));
+		}else {
+			ret = _test_compare(tier, reference, result);
+			printf("%s: %s is bit-exact with C for every matrix and range\n", ret ? "FAIL" : "PASS", _mm_native_get_isa_name(tier));
+			fails += ret;
+		}
+	}
+	free(reference);
+	free(result);
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+/*
+ * Check of the native resize engine: every filter resizes a pattern at every MM_IMGP_TIER the cpu has, and the
+ * result of each tier must be bit-exact with the one of the C tier. Every filter must also keep a flat field,
+ * each plane and channel of a single value, at exactly that value. The rows of dst are produced in stripes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+#include "mm_util_gstcs_format.h"
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_test.h"
+
+#define TEST_STRIPE_ROWS 18
+
+typedef struct _test_case_s
+{
+	unsigned int src_width;
+	unsigned int src_height;
+	unsigned int dst_width;
+	unsigned int dst_height;
+} test_case_s;
+
+static const mm_util_img_format_e _test_formats[] = {
+	MM_UTIL_IMG_FMT_I420,
+	MM_UTIL_IMG_FMT_NV12,
+	MM_UTIL_IMG_FMT_RGB888,
+	MM_UTIL_IMG_FMT_BGRA8888,
+};
+
+/* upscale, downscale, integer downscale for the box path of the area filter and both at once, with odd sizes */
+static const test_case_s _test_cases[] = {
+	{ 67, 45, 150, 101 },
+	{ 150, 101, 53, 29 },
+	{ 160, 96, 40, 24 },
+	{ 120, 80, 203, 37 },
+};
+
+#define TEST_FORMAT_NUM (sizeof(_test_formats) / sizeof(_test_formats[0]))
+#define TEST_CASE_NUM (sizeof(_test_cases) / sizeof(_test_cases[0]))
+
+static unsigned int
+_test_dst_size(mm_util_img_format_e format, const test_case_s *test)
+{
+	return _mm_format_get_size(_mm_format_get_desc(format), test->dst_width, test->dst_height);
+}
+
+/* bytes of the pattern and the flat field of every filter, format and case in the order _test_resize_all writes them */
+static size_t
+_test_total_size(void)
+{
+	size_t size = 0;
+	unsigned int f = 0, i = 0;
+
+	for(f = 0; f < TEST_FORMAT_NUM; f++) {
+		for(i = 0; i < TEST_CASE_NUM; i++) {
+			size += _test_dst_size(_test_formats[f], &_test_cases[i]) * 2;
+		}
+	}
+	return size * MM_UTIL_RESIZE_FILTER_NUM;
+}
+
+/* value of the flat field for byte b of a sample of plane i */
+static unsigned char
+_test_flat_value(unsigned int plane, unsigned int b)
+{
+	return 23 + plane * 71 + b * 41;
+}
+
+/* fill the samples of a frame with the flat field, or check that they hold it. The padding is not touched */
+static unsigned int
+_test_flat(const imgp_frame_s *frame, int check)
+{
+	const imgp_format_desc_s *desc = _mm_format_get_desc(frame->format);
+	unsigned int elem = 0, x_shift = 0, y_shift = 0, width = 0, height = 0;
+	unsigned int i = 0, x = 0, y = 0, b = 0, wrong = 0;
+	unsigned char *p = NULL;
+
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(frame->format, i, &elem, &x_shift, &y_shift);
+		width = (frame->width + (1 << x_shift) - 1) >> x_shift;
+		height = (frame->height + (1 << y_shift) - 1) >> y_shift;
+		for(y = 0; y < height; y++) {
+			p = frame->data[i] + y * frame->stride[i];
+			for(x = 0; x < width; x++) {
+				for(b = 0; b < elem; b++, p++) {
+					if(!check) {
+						*p = _test_flat_value(i, b);
+					}else if(*p != _test_flat_value(i, b)) {
+						wrong++;
+					}
+				}
+			}
+		}
+	}
+	return wrong;
+}
+
+static int
+_test_resize(mm_util_img_format_e format, const test_case_s *test, mm_util_img_resize_filter_e filter, int flat, unsigned char *buffer)
+{
+	unsigned int src_size = _mm_format_get_size(_mm_format_get_desc(format), test->src_width, test->src_height);
+	unsigned char *src_buffer = calloc(1, src_size);
+	imgp_frame_s src, dst;
+	imgp_native_op_s op;
+	unsigned int y = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(src_buffer == NULL) {
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	memset(buffer, 0, _test_dst_size(format, test));
+	_mm_native_frame_init(&src, format, test->src_width, test->src_height, src_buffer);
+	_mm_native_frame_init(&dst, format, test->dst_width, test->dst_height, buffer);
+	if(flat) {
+		_test_flat(&src, 0);
+	}else {
+		_test_fill_pattern(src_buffer, src_size, 0x2468ace);
+	}
+
+	memset(&op, 0, sizeof(imgp_native_op_s));
+	op.src = &src;
+	op.dst = &dst;
+	op.filter = filter;
+	ret = _mm_native_resize_prepare(&op);
+	for(y = 0; y < dst.height && ret == MM_ERROR_NONE; y += TEST_STRIPE_ROWS) {
+		ret = _mm_native_resize_rows(&op, y, IMGP_NATIVE_MIN(y + TEST_STRIPE_ROWS, dst.height));
+	}
+	_mm_native_resize_release(&op);
+	free(src_buffer);
+	return ret;
+}
+
+static int
+_test_resize_all(unsigned char *buffer, void *user_data)
+{
+	unsigned int filter = 0, f = 0, i = 0, flat = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) user_data;
+	for(filter = 0; filter < MM_UTIL_RESIZE_FILTER_NUM; filter++) {
+		for(f = 0; f < TEST_FORMAT_NUM; f++) {
+			for(i = 0; i < TEST_CASE_NUM; i++) {
+				for(flat = 0; flat < 2 && ret == MM_ERROR_NONE; flat++) {
+					ret = _test_resize(_test_formats[f], &_test_cases[i], filter, flat, buffer);
+					buffer += _test_dst_size(_test_formats[f], &_test_cases[i]);
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+/* the pattern of every case must be the one of C and the flat field must stay flat */
+static int
+_test_check(imgp_native_isa_e isa, const unsigned char *reference, unsigned char *result)
+{
+	unsigned int filter = 0, f = 0, i = 0, wrong = 0;
+	const test_case_s *test = NULL;
+	size_t size = 0, j = 0;
+	imgp_frame_s dst;
+	int fails = 0;
+
+	for(filter = 0; filter < MM_UTIL_RESIZE_FILTER_NUM; filter++) {
+		for(f = 0; f < TEST_FORMAT_NUM; f++) {
+			for(i = 0; i < TEST_CASE_NUM; i++) {
+				test = &_test_cases[i];
+				size = _test_dst_size(_test_formats[f], test);
+				j = _test_first_difference(reference, result, size);
+				if(j < size) {
+					printf("FAIL: %s filter %u format %d %ux%u -> %ux%u: byte %u is %u instead of %u\n", _mm_native_get_isa_name(isa), filter, _test_formats[f],
+						test->src_width, test->src_height, test->dst_width, test->dst_height, (unsigned int) j, result[j], reference[j]);
+					fails++;
+				}
+				reference += size;
+				result += size;
+
+				_mm_native_frame_init(&dst, _test_formats[f], test->dst_width, test->dst_height, result);
+				wrong = _test_flat(&dst, 1);
+				if(wrong) {
+					printf("FAIL: %s filter %u format %d %ux%u -> %ux%u: %u bytes of the flat field changed\n", _mm_native_get_isa_name(isa), filter, _test_formats[f],
+						test->src_width, test->src_height, test->dst_width, test->dst_height, wrong);
+					fails++;
+				}
+				reference += size;
+				result += size;
+			}
+		}
+	}
+	return fails;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t size = _test_total_size();
+	unsigned char *reference = malloc(size);
+	unsigned char *result = malloc(size);
+	imgp_native_isa_e tier = IMGP_NATIVE_ISA_C, isa = IMGP_NATIVE_ISA_C;
+	int fails = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) argc;
+	(void) argv;
+	if(reference == NULL || result == NULL) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	ret = _test_run_tier(_mm_native_get_isa_name(IMGP_NATIVE_ISA_C), _test_resize_all, NULL, reference, size, &isa);
+	if(ret != MM_ERROR_NONE || isa != IMGP_NATIVE_ISA_C) {
+		printf("FAIL: C tier ret: %d isa: %s\n", ret, _mm_native_get_isa_name(isa));
+		return 1;
+	}
+
+	for(tier = IMGP_NATIVE_ISA_C; tier < IMGP_NATIVE_ISA_NUM; tier++) {
+		if(tier != IMGP_NATIVE_ISA_C) {
+			ret = _test_run_tier(_mm_native_get_isa_name(tier), _test_resize_all, NULL, result, size, &isa);
+		}else {
+			memcpy(result, reference, size);
+		}
+		if(ret != MM_ERROR_NONE) {
+			printf("FAIL: %s tier ret: %d\n", _mm_native_get_isa_name(tier), ret);
+			fails++;
+		}else if(isa != tier) {
+			printf("SKIP: %s is not available, the cpu runs %s\n", _mm_native_get_isa_name(tier), _mm_native_get_isa_name(isa));
+		}else {
+			ret = _test_check(tier, reference, result);
+			printf("%s: %s keeps flat fields with every filter%s\n", ret ? "FAIL" : "PASS", _mm_native_get_isa_name(tier),
+				(tier == IMGP_NATIVE_ISA_C) ? "" : " and is bit-exact with C");
+			fails += ret;
+		}
+	}
+	free(reference);
+	free(result);
+	return fails ? 1 : 0;
+}
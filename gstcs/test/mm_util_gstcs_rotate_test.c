@@ -0,0 +1,304 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+/*
+ * Check of the native rotate / flip engine: every angle of the linear formats is compared with a rotation done
+ * sample by sample, at every MM_IMGP_TIER the cpu has. The rows of dst are produced in stripes which do not start
+ * on a tile, and the sizes leave partial tiles and partial SIMD blocks on the borders.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+#include "mm_util_gstcs_format.h"
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_test.h"
+
+#define TEST_STRIPE_ROWS 18
+
+typedef struct _test_size_s
+{
+	unsigned int width;
+	unsigned int height;
+} test_size_s;
+
+static const mm_util_img_format_e _test_formats[] = {
+	MM_UTIL_IMG_FMT_I420,
+	MM_UTIL_IMG_FMT_NV12,
+	MM_UTIL_IMG_FMT_Y444,
+	MM_UTIL_IMG_FMT_RGB565,
+	MM_UTIL_IMG_FMT_RGB888,
+	MM_UTIL_IMG_FMT_BGRA8888,
+	MM_UTIL_IMG_FMT_YUYV,
+	MM_UTIL_IMG_FMT_UYVY,
+};
+
+/* more than a tile of 64 on both sides with partial blocks, and an odd size */
+static const test_size_s _test_sizes[] = {
+	{ 150, 78 },
+	{ 67, 45 },
+};
+
+#define TEST_FORMAT_NUM (sizeof(_test_formats) / sizeof(_test_formats[0]))
+#define TEST_SIZE_NUM (sizeof(_test_sizes) / sizeof(_test_sizes[0]))
+
+static int
+_test_transposed(mm_util_img_rotate_type_e angle)
+{
+	return angle == MM_UTIL_ROTATE_90 || angle == MM_UTIL_ROTATE_270;
+}
+
+static int
+_test_supported(mm_util_img_format_e format, const test_size_s *size, mm_util_img_rotate_type_e angle)
+{
+	return _mm_native_rotate_supported(format, angle, size->width, size->height);
+}
+
+static unsigned int
+_test_dst_size(mm_util_img_format_e format, const test_size_s *size, mm_util_img_rotate_type_e angle)
+{
+	if(!_test_supported(format, size, angle)) {
+		return 0;
+	}
+	if(_test_transposed(angle)) {
+		return _mm_format_get_size(_mm_format_get_desc(format), size->height, size->width);
+	}
+	return _mm_format_get_size(_mm_format_get_desc(format), size->width, size->height);
+}
+
+/* bytes of every format, size and angle in the order _test_rotate_all writes them */
+static size_t
+_test_total_size(void)
+{
+	size_t total = 0;
+	unsigned int f = 0, s = 0, a = 0;
+
+	for(f = 0; f < TEST_FORMAT_NUM; f++) {
+		for(s = 0; s < TEST_SIZE_NUM; s++) {
+			for(a = 0; a < MM_UTIL_ROTATE_NUM; a++) {
+				total += _test_dst_size(_test_formats[f], &_test_sizes[s], a);
+			}
+		}
+	}
+	return total;
+}
+
+static unsigned char *
+_test_new_source(mm_util_img_format_e format, const test_size_s *size, imgp_frame_s *src)
+{
+	unsigned int src_size = _mm_format_get_size(_mm_format_get_desc(format), size->width, size->height);
+	unsigned char *buffer = malloc(src_size);
+
+	if(buffer != NULL) {
+		_test_fill_pattern(buffer, src_size, 0x7654321);
+		_mm_native_frame_init(src, format, size->width, size->height, buffer);
+	}
+	return buffer;
+}
+
+/* position in a source of width x height of the sample at (x, y) of dst */
+static void
+_test_map(mm_util_img_rotate_type_e angle, unsigned int width, unsigned int height, unsigned int x, unsigned int y, unsigned int *sx, unsigned int *sy)
+{
+	switch(angle) {
+		case MM_UTIL_ROTATE_90: *sx = y; *sy = height - 1 - x; break;
+		case MM_UTIL_ROTATE_180: *sx = width - 1 - x; *sy = height - 1 - y; break;
+		case MM_UTIL_ROTATE_270: *sx = width - 1 - y; *sy = x; break;
+		case MM_UTIL_ROTATE_FLIP_HORZ: *sx = width - 1 - x; *sy = y; break;
+		case MM_UTIL_ROTATE_FLIP_VERT: *sx = x; *sy = height - 1 - y; break;
+		default: *sx = x; *sy = y; break;
+	}
+}
+
+static void
+_test_reference(const imgp_frame_s *src, const imgp_frame_s *dst, mm_util_img_rotate_type_e angle)
+{
+	const imgp_format_desc_s *desc = _mm_format_get_desc(src->format);
+	unsigned int y_pos = (src->format == MM_UTIL_IMG_FMT_YUYV) ? 0 : 1;
+	unsigned int elem = 0, x_shift = 0, y_shift = 0, width = 0, height = 0;
+	unsigned int i = 0, x = 0, y = 0, sx = 0, sy = 0;
+	const unsigned char *s = NULL;
+
+	if(src->format == MM_UTIL_IMG_FMT_YUYV || src->format == MM_UTIL_IMG_FMT_UYVY) {
+		/* Y of every pixel, U and V of a pair of dst from the pair of the source pixel of its first pixel */
+		for(y = 0; y < dst->height; y++) {
+			for(x = 0; x < dst->width; x++) {
+				_test_map(angle, src->width, src->height, x, y, &sx, &sy);
+				s = src->data[0] + sy * src->stride[0];
+				dst->data[0][y * dst->stride[0] + x * 2 + y_pos] = s[sx * 2 + y_pos];
+				if((x & 1) == 0) {
+					dst->data[0][y * dst->stride[0] + x * 2 + 1 - y_pos] = s[(sx & ~1) * 2 + 1 - y_pos];
+					dst->data[0][y * dst->stride[0] + x * 2 + 3 - y_pos] = s[(sx & ~1) * 2 + 3 - y_pos];
+				}
+			}
+		}
+		return;
+	}
+	for(i = 0; i < desc->plane_count; i++) {
+		_mm_native_plane_layout(src->format, i, &elem, &x_shift, &y_shift);
+		width = (src->width + (1 << x_shift) - 1) >> x_shift;
+		height = (src->height + (1 << y_shift) - 1) >> y_shift;
+		for(y = 0; y < (_test_transposed(angle) ? width : height); y++) {
+			for(x = 0; x < (_test_transposed(angle) ? height : width); x++) {
+				_test_map(angle, width, height, x, y, &sx, &sy);
+				memcpy(dst->data[i] + y * dst->stride[i] + x * elem, src->data[i] + sy * src->stride[i] + sx * elem, elem);
+			}
+		}
+	}
+}
+
+static int
+_test_rotate(mm_util_img_format_e format, const test_size_s *size, mm_util_img_rotate_type_e angle, unsigned char *buffer)
+{
+	imgp_frame_s src, dst;
+	imgp_native_op_s op;
+	unsigned char *src_buffer = _test_new_source(format, size, &src);
+	unsigned int y = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(src_buffer == NULL) {
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	memset(buffer, 0, _test_dst_size(format, size, angle));
+	_mm_native_frame_init(&dst, format, _test_transposed(angle) ? size->height : size->width, _test_transposed(angle) ? size->width : size->height, buffer);
+	memset(&op, 0, sizeof(imgp_native_op_s));
+	op.src = &src;
+	op.dst = &dst;
+	op.angle = angle;
+	for(y = 0; y < dst.height && ret == MM_ERROR_NONE; y += TEST_STRIPE_ROWS) {
+		ret = _mm_native_rotate_rows(&op, y, IMGP_NATIVE_MIN(y + TEST_STRIPE_ROWS, dst.height));
+	}
+	free(src_buffer);
+	return ret;
+}
+
+static int
+_test_rotate_all(unsigned char *buffer, void *user_data)
+{
+	unsigned int f = 0, s = 0, a = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) user_data;
+	for(f = 0; f < TEST_FORMAT_NUM; f++) {
+		for(s = 0; s < TEST_SIZE_NUM; s++) {
+			for(a = 0; a < MM_UTIL_ROTATE_NUM && ret == MM_ERROR_NONE; a++) {
+				if(_test_supported(_test_formats[f], &_test_sizes[s], a)) {
+					ret = _test_rotate(_test_formats[f], &_test_sizes[s], a, buffer);
+					buffer += _test_dst_size(_test_formats[f], &_test_sizes[s], a);
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+static int
+_test_reference_all(unsigned char *buffer)
+{
+	imgp_frame_s src, dst;
+	unsigned char *src_buffer = NULL;
+	unsigned int f = 0, s = 0, a = 0;
+	const test_size_s *size = NULL;
+
+	for(f = 0; f < TEST_FORMAT_NUM; f++) {
+		for(s = 0; s < TEST_SIZE_NUM; s++) {
+			size = &_test_sizes[s];
+			for(a = 0; a < MM_UTIL_ROTATE_NUM; a++) {
+				if(!_test_supported(_test_formats[f], size, a)) {
+					continue;
+				}
+				src_buffer = _test_new_source(_test_formats[f], size, &src);
+				if(src_buffer == NULL) {
+					return MM_ERROR_IMAGE_NO_FREE_SPACE;
+				}
+				memset(buffer, 0, _test_dst_size(_test_formats[f], size, a));
+				_mm_native_frame_init(&dst, _test_formats[f], _test_transposed(a) ? size->height : size->width, _test_transposed(a) ? size->width : size->height, buffer);
+				_test_reference(&src, &dst, a);
+				free(src_buffer);
+				buffer += _test_dst_size(_test_formats[f], size, a);
+			}
+		}
+	}
+	return MM_ERROR_NONE;
+}
+
+/* report the first differing byte of every format, size and angle */
+static int
+_test_compare(imgp_native_isa_e isa, const unsigned char *reference, const unsigned char *result)
+{
+	unsigned int f = 0, s = 0, a = 0;
+	size_t size = 0, j = 0;
+	int fails = 0;
+
+	for(f = 0; f < TEST_FORMAT_NUM; f++) {
+		for(s = 0; s < TEST_SIZE_NUM; s++) {
+			for(a = 0; a < MM_UTIL_ROTATE_NUM; a++) {
+				size = _test_dst_size(_test_formats[f], &_test_sizes[s], a);
+				j = _test_first_difference(reference, result, size);
+				if(j < size) {
+					printf("FAIL: %s format %d %ux%u angle %u: byte %u is %u instead of %u\n", _mm_native_get_isa_name(isa), _test_formats[f],
+						_test_sizes[s].width, _test_sizes[s].height, a, (unsigned int) j, result[j], reference[j]);
+					fails++;
+				}
+				reference += size;
+				result += size;
+			}
+		}
+	}
+	return fails;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t size = _test_total_size();
+	unsigned char *reference = malloc(size);
+	unsigned char *result = malloc(size);
+	imgp_native_isa_e tier = IMGP_NATIVE_ISA_C, isa = IMGP_NATIVE_ISA_C;
+	int fails = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) argc;
+	(void) argv;
+	if(reference == NULL || result == NULL || _test_reference_all(reference) != MM_ERROR_NONE) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	for(tier = IMGP_NATIVE_ISA_C; tier < IMGP_NATIVE_ISA_NUM; tier++) {
+		ret = _test_run_tier(_mm_native_get_isa_name(tier), _test_rotate_all, NULL, result, size, &isa);
+		if(ret != MM_ERROR_NONE) {
+			printf("FAIL: %s tier ret: %d\n", _mm_native_get_isa_name(tier), ret);
+			fails++;
+		}else if(isa != tier) {
+			printf("SKIP: %s is not available, the cpu runs %s\n", _mm_native_get_isa_name(tier), _mm_native_get_isa_name(isa));
+		}else {
+			ret = _test_compare(tier, reference, result);
+			printf("%s: %s rotates and flips every format as the reference\n", ret ? "FAIL" : "PASS", _mm_native_get_isa_name(tier));
+			fails += ret;
+		}
+	}
+	free(reference);
+	free(result);
+	return fails ? 1 : 0;
+}
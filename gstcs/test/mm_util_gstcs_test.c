@@ -0,0 +1,130 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <mm_error.h>
+#include "mm_util_gstcs_test.h"
+
+void
+_test_fill_pattern(unsigned char *buffer, size_t size, unsigned int seed)
+{
+	size_t i = 0;
+
+	for(i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buffer[i] = (i < 256) ? i : (seed >> 16) & 0xff;
+	}
+}
+
+static int
+_test_write_all(int fd, const unsigned char *data, size_t size)
+{
+	ssize_t done = 0;
+
+	while(size > 0) {
+		done = write(fd, data, size);
+		if(done <= 0) {
+			return -1;
+		}
+		data += done;
+		size -= done;
+	}
+	return 0;
+}
+
+static int
+_test_read_all(int fd, unsigned char *data, size_t size)
+{
+	ssize_t done = 0;
+
+	while(size > 0) {
+		done = read(fd, data, size);
+		if(done <= 0) {
+			return -1;
+		}
+		data += done;
+		size -= done;
+	}
+	return 0;
+}
+
+int
+_test_run_tier(const char *tier, test_run_f func, void *user_data, unsigned char *buffer, size_t size, imgp_native_isa_e *isa)
+{
+	int fds[2] = { -1, -1 };
+	int status = 0;
+	int ret = MM_ERROR_NONE;
+	int read_ret = 0;
+	pid_t pid = 0;
+
+	if(pipe(fds) != 0) {
+		return MM_ERROR_IMAGE_INTERNAL;
+	}
+	pid = fork();
+	if(pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return MM_ERROR_IMAGE_INTERNAL;
+	}
+	if(pid == 0) {
+		close(fds[0]);
+		if(tier) {
+			setenv("MM_IMGP_TIER", tier, 1);
+		}else {
+			unsetenv("MM_IMGP_TIER");
+		}
+		ret = func(buffer, user_data);
+		*isa = _mm_native_get_isa();
+		if(_test_write_all(fds[1], (const unsigned char *) &ret, sizeof(ret)) != 0
+			|| _test_write_all(fds[1], (const unsigned char *) isa, sizeof(*isa)) != 0
+			|| _test_write_all(fds[1], buffer, size) != 0) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+	close(fds[1]);
+	read_ret = _test_read_all(fds[0], (unsigned char *) &ret, sizeof(ret));
+	if(read_ret == 0) {
+		read_ret = _test_read_all(fds[0], (unsigned char *) isa, sizeof(*isa));
+	}
+	if(read_ret == 0) {
+		read_ret = _test_read_all(fds[0], buffer, size);
+	}
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+	if(read_ret != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		return MM_ERROR_IMAGE_INTERNAL;
+	}
+	return ret;
+}
+
+size_t
+_test_first_difference(const unsigned char *a, const unsigned char *b, size_t size)
+{
+	size_t i = 0;
+
+	for(i = 0; i < size && a[i] == b[i]; i++);
+	return i;
+}
@@ -0,0 +1,55 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef __MM_UTIL_GSTCS_TEST_H__
+#define __MM_UTIL_GSTCS_TEST_H__
+
+#include <stddef.h>
+#include "mm_util_gstcs_native.h"
+
+/* exit status of a check which can not run here, e.g. without the gstreamer plugins */
+#define TEST_EXIT_SKIP 77
+
+/* conversions of a check run in the child process of a tier, they fill buffer and return MM_ERROR_NONE on success */
+typedef int (*test_run_f)(unsigned char *buffer, void *user_data);
+
+/**
+ * @remark	fill a source with bytes which span every value first, then with pseudo random ones from seed
+ */
+void
+_test_fill_pattern(unsigned char *buffer, size_t size, unsigned int seed);
+
+/**
+ * @remark	run func with MM_IMGP_TIER=tier in a child process, the kernels pick their tier once per process. A NULL tier leaves it to the cpu.
+ *		buffer receives the size bytes func wrote there and isa the instruction set the native kernels ran with
+ * @return	what func returned, or MM_ERROR_IMAGE_INTERNAL when the child could not run
+ */
+int
+_test_run_tier(const char *tier, test_run_f func, void *user_data, unsigned char *buffer, size_t size, imgp_native_isa_e *isa);
+
+/**
+ * @return	index of the first byte which differs, size when a and b are equal
+ */
+size_t
+_test_first_difference(const unsigned char *a, const unsigned char *b, size_t size);
+
+#endif	/*__MM_UTIL_GSTCS_TEST_H__*/
@@ -0,0 +1,317 @@
+/*
+ * libmm-imgp-gstcs
+ *
+ * Copyright (c) 2000 - 2011 Samsung Electronics Co., Ltd. All rights reserved.
+ *
+ * Contact: YoungHun Kim <yh8004.kim@samsung.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+/*
+ * Check of the NV12 tiled de-tiler and tiler: a NV12 pattern is tiled, compared with a tiling done byte by byte
+ * from the layout of the s5pc110 decoder, de-tiled to NV12 and to I420, and the I420 frame is tiled back,
+ * at every MM_IMGP_TIER the cpu has. The heights give odd numbers of rows of tiles, whose last row is linear,
+ * to the luma and to the chroma planes. The rows are produced in stripes which do not start on a row of tiles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mm_error.h>
+#include "mm_util_gstcs.h"
+#include "mm_util_gstcs_format.h"
+#include "mm_util_gstcs_native.h"
+#include "mm_util_gstcs_test.h"
+
+#define TEST_STRIPE_ROWS 18
+
+/* frames of a size in the order _test_tile_size writes them */
+typedef enum
+{
+	TEST_FRAME_TILED = 0,   /* NV12 tiled from NV12 */
+	TEST_FRAME_NV12,        /* de-tiled to NV12 */
+	TEST_FRAME_I420,        /* de-tiled to I420 */
+	TEST_FRAME_RETILED,     /* NV12 tiled from the I420 frame */
+	TEST_FRAME_NUM,
+} test_frame_e;
+
+typedef struct _test_size_s
+{
+	unsigned int width;
+	unsigned int height;
+} test_size_s;
+
+/* rows of tiles of luma / chroma: 3 / 2, 5 / 3, 2 / 1 and 1 / 1, with widths of a partial tile and of a partial pair of tiles */
+static const test_size_s _test_sizes[] = {
+	{ 130, 96 },
+	{ 200, 160 },
+	{ 70, 33 },
+	{ 64, 32 },
+};
+
+#define TEST_SIZE_NUM (sizeof(_test_sizes) / sizeof(_test_sizes[0]))
+
+static const mm_util_img_format_e _test_frame_formats[TEST_FRAME_NUM] = {
+	MM_UTIL_IMG_FMT_NV12_TILED,
+	MM_UTIL_IMG_FMT_NV12,
+	MM_UTIL_IMG_FMT_I420,
+	MM_UTIL_IMG_FMT_NV12_TILED,
+};
+
+static unsigned int
+_test_frame_size(test_frame_e frame, const test_size_s *size)
+{
+	return _mm_format_get_size(_mm_format_get_desc(_test_frame_formats[frame]), size->width, size->height);
+}
+
+static size_t
+_test_total_size(void)
+{
+	size_t total = 0;
+	unsigned int s = 0, f = 0;
+
+	for(s = 0; s < TEST_SIZE_NUM; s++) {
+		for(f = 0; f < TEST_FRAME_NUM; f++) {
+			total += _test_frame_size(f, &_test_sizes[s]);
+		}
+	}
+	return total;
+}
+
+static unsigned char *
+_test_new_source(const test_size_s *size, imgp_frame_s *src)
+{
+	unsigned int src_size = _mm_format_get_size(_mm_format_get_desc(MM_UTIL_IMG_FMT_NV12), size->width, size->height);
+	unsigned char *buffer = malloc(src_size);
+
+	if(buffer != NULL) {
+		_test_fill_pattern(buffer, src_size, 0x13579bd);
+		_mm_native_frame_init(src, MM_UTIL_IMG_FMT_NV12, size->width, size->height, buffer);
+	}
+	return buffer;
+}
+
+static int
+_test_tile_rows(const imgp_frame_s *src, const imgp_frame_s *dst)
+{
+	imgp_native_op_s op;
+	unsigned int y = 0;
+	int ret = MM_ERROR_NONE;
+
+	memset(&op, 0, sizeof(imgp_native_op_s));
+	op.src = src;
+	op.dst = dst;
+	for(y = 0; y < dst->height && ret == MM_ERROR_NONE; y += TEST_STRIPE_ROWS) {
+		ret = _mm_native_tile_rows(&op, y, IMGP_NATIVE_MIN(y + TEST_STRIPE_ROWS, dst->height));
+	}
+	return ret;
+}
+
+static int
+_test_tile_size(const test_size_s *size, unsigned char *buffer)
+{
+	imgp_frame_s src, frames[TEST_FRAME_NUM];
+	unsigned char *src_buffer = _test_new_source(size, &src);
+	unsigned int f = 0;
+	int ret = MM_ERROR_NONE;
+
+	if(src_buffer == NULL) {
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	for(f = 0; f < TEST_FRAME_NUM; f++) {
+		memset(buffer, 0, _test_frame_size(f, size));
+		_mm_native_frame_init(&frames[f], _test_frame_formats[f], size->width, size->height, buffer);
+		buffer += _test_frame_size(f, size);
+	}
+	ret = _test_tile_rows(&src, &frames[TEST_FRAME_TILED]);
+	if(ret == MM_ERROR_NONE) {
+		ret = _test_tile_rows(&frames[TEST_FRAME_TILED], &frames[TEST_FRAME_NV12]);
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = _test_tile_rows(&frames[TEST_FRAME_TILED], &frames[TEST_FRAME_I420]);
+	}
+	if(ret == MM_ERROR_NONE) {
+		ret = _test_tile_rows(&frames[TEST_FRAME_I420], &frames[TEST_FRAME_RETILED]);
+	}
+	free(src_buffer);
+	return ret;
+}
+
+static int
+_test_tile_all(unsigned char *buffer, void *user_data)
+{
+	unsigned int s = 0, f = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) user_data;
+	for(s = 0; s < TEST_SIZE_NUM && ret == MM_ERROR_NONE; s++) {
+		ret = _test_tile_size(&_test_sizes[s], buffer);
+		for(f = 0; f < TEST_FRAME_NUM; f++) {
+			buffer += _test_frame_size(f, &_test_sizes[s]);
+		}
+	}
+	return ret;
+}
+
+/* index of tile (x, y) of a plane of x_tiles x y_tiles: the tiles of 2 rows go in groups of 4, 2 of the upper row
+ * then 2 of the lower one, every other group starts on the lower row. The last row of an odd number of rows is linear */
+static unsigned int
+_test_tile_index(unsigned int x, unsigned int y, unsigned int x_tiles, unsigned int y_tiles)
+{
+	unsigned int base = (y / 2) * 2 * x_tiles;
+	unsigned int lower = y % 2;
+
+	if(y == y_tiles - 1 && y_tiles % 2 == 1) {
+		return base + x;
+	}
+	if((x / 2) % 2 == 1) {
+		lower = !lower;
+	}
+	return base + (x / 2) * 4 + lower * 2 + x % 2;
+}
+
+/* tile a NV12 frame byte by byte */
+static void
+_test_reference_tile(const imgp_frame_s *src, unsigned char *tiled)
+{
+	const imgp_format_desc_s *desc = _mm_format_get_desc(MM_UTIL_IMG_FMT_NV12_TILED);
+	unsigned int stride = 0, rows = 0, bytes = 0, height = 0;
+	unsigned int i = 0, x = 0, y = 0;
+
+	for(i = 0; i < 2; i++) {
+		_mm_format_get_plane_size(desc, i, src->width, src->height, &stride, &rows);
+		bytes = (i == 0) ? src->width : (src->width + 1) / 2 * 2;
+		height = (i == 0) ? src->height : (src->height + 1) / 2;
+		for(y = 0; y < height; y++) {
+			for(x = 0; x < bytes; x++) {
+				tiled[(size_t) _test_tile_index(x / IMGP_NATIVE_TILE_WIDTH, y / IMGP_NATIVE_TILE_HEIGHT, stride / IMGP_NATIVE_TILE_WIDTH, rows / IMGP_NATIVE_TILE_HEIGHT)
+					* IMGP_NATIVE_TILE_WIDTH * IMGP_NATIVE_TILE_HEIGHT + (y % IMGP_NATIVE_TILE_HEIGHT) * IMGP_NATIVE_TILE_WIDTH + x % IMGP_NATIVE_TILE_WIDTH]
+					= src->data[i][y * src->stride[i] + x];
+			}
+		}
+		tiled += (size_t) stride * rows;
+	}
+}
+
+/* the frames of a size as they must be, the padding of the linear frames is 0 as in the results */
+static int
+_test_reference_size(const test_size_s *size, unsigned char *buffer)
+{
+	imgp_frame_s src, nv12, i420;
+	unsigned char *src_buffer = _test_new_source(size, &src);
+	unsigned char *frames[TEST_FRAME_NUM];
+	unsigned int f = 0, x = 0, y = 0;
+
+	if(src_buffer == NULL) {
+		return MM_ERROR_IMAGE_NO_FREE_SPACE;
+	}
+	for(f = 0; f < TEST_FRAME_NUM; f++) {
+		frames[f] = buffer;
+		memset(buffer, 0, _test_frame_size(f, size));
+		buffer += _test_frame_size(f, size);
+	}
+	_test_reference_tile(&src, frames[TEST_FRAME_TILED]);
+	memcpy(frames[TEST_FRAME_RETILED], frames[TEST_FRAME_TILED], _test_frame_size(TEST_FRAME_TILED, size));
+
+	_mm_native_frame_init(&nv12, MM_UTIL_IMG_FMT_NV12, size->width, size->height, frames[TEST_FRAME_NV12]);
+	_mm_native_frame_init(&i420, MM_UTIL_IMG_FMT_I420, size->width, size->height, frames[TEST_FRAME_I420]);
+	for(y = 0; y < size->height; y++) {
+		memcpy(nv12.data[0] + y * nv12.stride[0], src.data[0] + y * src.stride[0], size->width);
+		memcpy(i420.data[0] + y * i420.stride[0], src.data[0] + y * src.stride[0], size->width);
+	}
+	for(y = 0; y < (size->height + 1) / 2; y++) {
+		memcpy(nv12.data[1] + y * nv12.stride[1], src.data[1] + y * src.stride[1], (size->width + 1) / 2 * 2);
+		for(x = 0; x < (size->width + 1) / 2; x++) {
+			i420.data[1][y * i420.stride[1] + x] = src.data[1][y * src.stride[1] + x * 2];
+			i420.data[2][y * i420.stride[2] + x] = src.data[1][y * src.stride[1] + x * 2 + 1];
+		}
+	}
+	free(src_buffer);
+	return MM_ERROR_NONE;
+}
+
+static int
+_test_reference_all(unsigned char *buffer)
+{
+	unsigned int s = 0, f = 0;
+	int ret = MM_ERROR_NONE;
+
+	for(s = 0; s < TEST_SIZE_NUM && ret == MM_ERROR_NONE; s++) {
+		ret = _test_reference_size(&_test_sizes[s], buffer);
+		for(f = 0; f < TEST_FRAME_NUM; f++) {
+			buffer += _test_frame_size(f, &_test_sizes[s]);
+		}
+	}
+	return ret;
+}
+
+static int
+_test_compare(imgp_native_isa_e isa, const unsigned char *reference, const unsigned char *result)
+{
+	static const char *names[TEST_FRAME_NUM] = { "tiled", "de-tiled NV12", "de-tiled I420", "tiled I420" };
+	unsigned int s = 0, f = 0;
+	size_t size = 0, j = 0;
+	int fails = 0;
+
+	for(s = 0; s < TEST_SIZE_NUM; s++) {
+		for(f = 0; f < TEST_FRAME_NUM; f++) {
+			size = _test_frame_size(f, &_test_sizes[s]);
+			j = _test_first_difference(reference, result, size);
+			if(j < size) {
+				printf("FAIL: %s %ux%u %s: byte %u is %u instead of %u\n", _mm_native_get_isa_name(isa), _test_sizes[s].width, _test_sizes[s].height,
+					names[f], (unsigned int) j, result[j], reference[j]);
+				fails++;
+			}
+			reference += size;
+			result += size;
+		}
+	}
+	return fails;
+}
+
+int
+main(int argc, char *argv[])
+{
+	size_t size = _test_total_size();
+	unsigned char *reference = malloc(size);
+	unsigned char *result = malloc(size);
+	imgp_native_isa_e tier = IMGP_NATIVE_ISA_C, isa = IMGP_NATIVE_ISA_C;
+	int fails = 0;
+	int ret = MM_ERROR_NONE;
+
+	(void) argc;
+	(void) argv;
+	if(reference == NULL || result == NULL || _test_reference_all(reference) != MM_ERROR_NONE) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	for(tier = IMGP_NATIVE_ISA_C; tier < IMGP_NATIVE_ISA_NUM; tier++) {
+		ret = _test_run_tier(_mm_native_get_isa_name(tier), _test_tile_all, NULL, result, size, &isa);
+		if(ret != MM_ERROR_NONE) {
+			printf("FAIL: %s tier ret: %d\n", _mm_native_get_isa_name(tier), ret);
+			fails++;
+		}else if(isa != tier) {
+			printf("SKIP: %s is not available, the cpu runs %s\n", _mm_native_get_isa_name(tier), _mm_native_get_isa_name(isa));
+		}else {
+			ret = _test_compare(tier, reference, result);
+			printf("%s: %s tiles and de-tiles NV12 and I420 as the reference\n", ret ? "FAIL" : "PASS", _mm_native_get_isa_name(tier));
+			fails += ret;
+		}
+	}
+	free(reference);
+	free(result);
+	return fails ? 1 : 0;
+}
@@ -1,8 +1,8 @@
 #sbs-git:slp/pkgs/l/libmm-imgp-gstcs libmm-imgp-gstcs 0.1 62b62e6d483557fc5750d1b4986e9a98323f1194
 Name:       libmm-imgp-gstcs
 Summary:    Multimedia Framework Utility Library
-Version:    0.3
-Release:    39
+Version:    0.4
+Release:    1
 Group:      System/Libraries
 License:    Apache
 Source0:    %{name}-%{version}.tar.gz